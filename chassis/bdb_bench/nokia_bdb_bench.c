@@ -0,0 +1,180 @@
+/*
+ * Compare scalar and batched BDB register access through nokia-kernel-bdb.
+ *
+ *   nokia_bdb_bench [-d <device>] [-s <hw slot>] [-a <addr>] [-n <ops>] [-b <batch>] [-w]
+ *
+ * Reads (or with -w writes back) the 32-bit register at addr on the given hw slot, first with one
+ * LUBDE_NOKIA_OP_BDB_READ/WRITE ioctl per register and then with LUBDE_NOKIA_OP_BDB_BATCH, and
+ * prints ops/sec for both. The default address is the SFM scratchpad, which is safe to write.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/ioctl.h>
+
+typedef struct  {
+    unsigned int dev;
+    unsigned int rc;
+    unsigned int d0;
+    unsigned int d1;
+    unsigned int d2;
+    unsigned int d3;
+    uint64_t p0;
+    union {
+        unsigned int dw[2];
+        unsigned char buf[64];
+    } dx;
+} lubde_ioctl_t;
+
+typedef struct {
+    uint32_t slot;
+    uint32_t dev;
+    uint32_t addr;
+    uint32_t op;
+    uint32_t value;
+    uint32_t rc;
+} nokia_bdb_op_t;
+
+#define LUBDE_MAGIC                         'L'
+#define LUBDE_NOKIA_OP_BDB_READ             _IO(LUBDE_MAGIC, 102)
+#define LUBDE_NOKIA_OP_BDB_WRITE            _IO(LUBDE_MAGIC, 103)
+#define LUBDE_NOKIA_OP_BDB_BATCH            _IO(LUBDE_MAGIC, 104)
+#define LUBDE_SUCCESS                       0
+
+#define BDB_BATCH_MAX                       4096
+#define BDB_OP_READ                         0
+#define BDB_OP_WRITE                        1
+
+#define A64_XRS_SCRATCHPAD                  0x00800500
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int run_scalar(int fd, uint32_t slot, uint32_t addr, int write, uint32_t value, uint32_t ops)
+{
+    lubde_ioctl_t io;
+    uint32_t i;
+
+    for (i = 0; i < ops; i++)
+    {
+        memset(&io, 0, sizeof(io));
+        io.dev = slot;
+        io.d0 = addr;
+        io.d1 = 4;
+        io.dx.dw[0] = value;
+        if (ioctl(fd, write ? LUBDE_NOKIA_OP_BDB_WRITE : LUBDE_NOKIA_OP_BDB_READ, &io) < 0 || io.rc != LUBDE_SUCCESS)
+        {
+            fprintf(stderr, "scalar %s %u failed (rc %d)\n", write ? "write" : "read", i, (int)io.rc);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int run_batch(int fd, uint32_t slot, uint32_t addr, int write, uint32_t value, uint32_t ops, uint32_t batch)
+{
+    nokia_bdb_op_t *vec = calloc(batch, sizeof(*vec));
+    lubde_ioctl_t io;
+    uint32_t done, i, n;
+
+    if (!vec)
+        return -1;
+
+    for (done = 0; done < ops; done += n)
+    {
+        n = (ops - done < batch) ? ops - done : batch;
+        for (i = 0; i < n; i++)
+        {
+            vec[i].slot = slot;
+            vec[i].addr = addr;
+            vec[i].op = write ? BDB_OP_WRITE : BDB_OP_READ;
+            vec[i].value = value;
+        }
+        memset(&io, 0, sizeof(io));
+        io.p0 = (uintptr_t)vec;
+        io.d0 = n;
+        if (ioctl(fd, LUBDE_NOKIA_OP_BDB_BATCH, &io) < 0 || io.rc != LUBDE_SUCCESS)
+        {
+            fprintf(stderr, "batch at %u failed (%u of %u entries)\n", done, io.d1, n);
+            free(vec);
+            return -1;
+        }
+    }
+    free(vec);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *device = "/dev/nokia-kernel-bdb";
+    uint32_t slot = 17, addr = A64_XRS_SCRATCHPAD, ops = 100000, batch = 256, value = 0;
+    int write = 0, opt, fd;
+    double t0, scalar, batched;
+    lubde_ioctl_t io;
+
+    while ((opt = getopt(argc, argv, "d:s:a:n:b:w")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd': device = optarg; break;
+        case 's': slot = strtoul(optarg, NULL, 0); break;
+        case 'a': addr = strtoul(optarg, NULL, 0); break;
+        case 'n': ops = strtoul(optarg, NULL, 0); break;
+        case 'b': batch = strtoul(optarg, NULL, 0); break;
+        case 'w': write = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-d <device>] [-s <hw slot>] [-a <addr>] [-n <ops>] [-b <batch>] [-w]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ops == 0 || batch == 0 || batch > BDB_BATCH_MAX)
+    {
+        fprintf(stderr, "ops must be non-zero and batch 1..%d\n", BDB_BATCH_MAX);
+        return 1;
+    }
+
+    fd = open(device, O_RDWR);
+    if (fd < 0)
+    {
+        perror(device);
+        return 1;
+    }
+
+    /* write back what is there so -w leaves the register unchanged */
+    memset(&io, 0, sizeof(io));
+    io.dev = slot;
+    io.d0 = addr;
+    io.d1 = 4;
+    if (ioctl(fd, LUBDE_NOKIA_OP_BDB_READ, &io) < 0 || io.rc != LUBDE_SUCCESS)
+    {
+        fprintf(stderr, "slot %u addr 0x%x is not readable\n", slot, addr);
+        close(fd);
+        return 1;
+    }
+    value = io.dx.dw[0];
+
+    t0 = now_sec();
+    if (run_scalar(fd, slot, addr, write, value, ops))
+        return 1;
+    scalar = now_sec() - t0;
+
+    t0 = now_sec();
+    if (run_batch(fd, slot, addr, write, value, ops, batch))
+        return 1;
+    batched = now_sec() - t0;
+
+    printf("%u %s of slot %u addr 0x%x\n", ops, write ? "writes" : "reads", slot, addr);
+    printf("scalar: %10.0f ops/sec\n", ops / scalar);
+    printf("batch:  %10.0f ops/sec (batch %u, %.1fx)\n", ops / batched, batch, scalar / batched);
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#include "mdipc.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <algorithm>
+
+#define MDIPC_SPIN_US                       20
+#define MDIPC_SLICE_MIN_US                  50
+#define MDIPC_SLICE_MAX_US                  1000
+
+static uint64_t mdipcNowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* the channel files are shared mappings, so these are process-shared (not FUTEX_PRIVATE) futexes */
+static void mdipcFutexWait(volatile uint32_t *addr, uint32_t val, uint32_t us)
+{
+    struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, nullptr, 0);
+}
+
+static void mdipcFutexWake(volatile uint32_t *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+extern "C" int mdipc_wait_own(volatile uint32_t *own, uint32_t want, uint32_t timeout_us)
+{
+    uint64_t start = mdipcNowUs();
+    uint32_t slice = MDIPC_SLICE_MIN_US;
+
+    while (true)
+    {
+        uint32_t v = __atomic_load_n(own, __ATOMIC_ACQUIRE);
+        if (v == want)
+            return 0;
+
+        uint64_t elapsed = mdipcNowUs() - start;
+        if (elapsed >= timeout_us)
+            return -1;
+        if (elapsed < MDIPC_SPIN_US)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+            continue;
+        }
+        mdipcFutexWait(own, v, std::min<uint64_t>(slice, timeout_us - elapsed));
+        slice = std::min(slice * 2, (uint32_t)MDIPC_SLICE_MAX_US);
+    }
+}
+
+extern "C" void mdipc_set_own(volatile uint32_t *own, uint32_t value)
+{
+    __atomic_store_n(own, value, __ATOMIC_RELEASE);
+    mdipcFutexWake(own);
+}
+
+MdipcChannel::~MdipcChannel()
+{
+    if (msg != nullptr)
+        munmap((void *)msg, size);
+    if (fd >= 0)
+        close(fd);
+}
+
+MdipcChannel::MdipcChannel(MdipcChannel &&other)
+    : msg(other.msg), size(other.size), fd(other.fd)
+{
+    other.msg = nullptr;
+    other.fd = -1;
+}
+
+bool MdipcChannel::open(const std::string &name)
+{
+    struct stat st;
+
+    fd = ::open(name.c_str(), O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    if ((fstat(fd, &st) < 0) || ((size_t)st.st_size <= sizeof(tMdipcMsg)))
+        return false;
+    void *map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        return false;
+    msg = (volatile tMdipcMsg *)map;
+    size = st.st_size;
+    return true;
+}
+
+Mdipc::Mdipc(const std::string &base_name, uint32_t num_channels)
+{
+    for (uint32_t i = 0; i < num_channels; i++)
+    {
+        MdipcChannel chan;
+        chan.open(base_name + std::to_string(i));
+        channels.push_back(std::move(chan));
+    }
+}
+
+/* same allocation protocol as MDIPC.obtain_channel(): flock on channel 0 guards against other processes */
+int Mdipc::obtainChannel()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    uint32_t tid = gettid();
+    int index = -1;
+
+    flock(channels[0].fd, LOCK_EX);
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        volatile tMdipcMsg *msg = channels[i].msg;
+        if ((msg == nullptr) || (msg->own != MDIPC_OWN_NOS) || (msg->owner_id != 0))
+            continue;
+        msg->own = MDIPC_OWN_NOS_PREP;
+        msg->owner_id = tid;
+        index = i;
+        break;
+    }
+    flock(channels[0].fd, LOCK_UN);
+    return index;
+}
+
+void Mdipc::freeChannel(int index)
+{
+    volatile tMdipcMsg *msg = channels[index].msg;
+
+    msg->owner_id = 0;
+    mdipc_set_own(&msg->own, MDIPC_OWN_NOS);
+}
+
+int Mdipc::waitResponse(MdipcChannel &chan, uint32_t timeout_us)
+{
+    if (poll_sleep_us == 0)
+        return mdipc_wait_own(&chan.msg->own, MDIPC_OWN_NOS_RSP, timeout_us);
+
+    for (uint32_t waited = 0; waited < timeout_us; waited += poll_sleep_us)
+    {
+        usleep(poll_sleep_us);
+        if (__atomic_load_n(&chan.msg->own, __ATOMIC_ACQUIRE) == MDIPC_OWN_NOS_RSP)
+            return 0;
+    }
+    return -1;
+}
+
+int Mdipc::send(uint32_t op, uint32_t hw_port_id, uint32_t page, uint32_t offset, uint32_t num_bytes,
+                const uint8_t *wdata, uint8_t *rdata, uint32_t timeout_us)
+{
+    if (!isOpen())
+        return MDIPC_RSP_FAIL;
+    if (((op == MDIPC_WRITE) || (op == MDIPC_WRITE_CDB_CHAIN)) && (wdata == nullptr))
+        return MDIPC_RSP_FAIL;
+    if ((op > MDIPC_WRITE_CDB_CHAIN) || ((op == MDIPC_READ) && (rdata == nullptr)))
+        return MDIPC_RSP_FAIL;
+
+    int index = obtainChannel();
+    if (index < 0)
+        return MDIPC_RSP_FAIL;
+
+    MdipcChannel &chan = channels[index];
+    volatile tMdipcMsg *msg = chan.msg;
+    if ((num_bytes > 128) && (page < 160))
+        num_bytes = 128;
+    if (num_bytes > chan.dataSize())
+    {
+        freeChannel(index);
+        return MDIPC_RSP_FAIL;
+    }
+
+    uint32_t msg_id = msg->msg_id + 1;
+    msg->msg_id = msg_id;
+    msg->hw_port_id = hw_port_id;
+    msg->op = op;
+    msg->page = page;
+    msg->offset = offset;
+    msg->num_bytes = num_bytes;
+    msg->status = msg_id;
+    if ((op == MDIPC_WRITE) || (op == MDIPC_WRITE_CDB_CHAIN))
+        memcpy((void *)msg->data, wdata, num_bytes);
+
+    mdipc_set_own(&msg->own, MDIPC_OWN_NDK);
+    if (waitResponse(chan, timeout_us) < 0)
+    {
+        freeChannel(index);
+        return MDIPC_RSP_FAIL;
+    }
+
+    int status = msg->status;
+    if ((status == MDIPC_RSP_SUCCESS) && (op == MDIPC_READ))
+        memcpy(rdata, (const void *)msg->data, num_bytes);
+    freeChannel(index);
+    return status;
+}
+
+int Mdipc::readMulti(uint32_t hw_port_id, tMdipcDesc *desc, uint32_t count, uint8_t *rdata, uint32_t timeout_us)
+{
+    size_t total = 0;
+
+    if (!isOpen() || (count == 0) || (count > MDIPC_MULTI_MAX_DESC))
+        return MDIPC_RSP_FAIL;
+    for (uint32_t i = 0; i < count; i++)
+        total += desc[i].num_bytes;
+
+    int index = obtainChannel();
+    if (index < 0)
+        return MDIPC_RSP_FAIL;
+
+    MdipcChannel &chan = channels[index];
+    volatile tMdipcMsg *msg = chan.msg;
+    size_t table = count * sizeof(tMdipcDesc);
+    if (table + total > chan.dataSize())
+    {
+        freeChannel(index);
+        return MDIPC_RSP_FAIL;
+    }
+
+    uint32_t msg_id = msg->msg_id + 1;
+    msg->msg_id = msg_id;
+    msg->hw_port_id = hw_port_id;
+    msg->op = MDIPC_READ_MULTI;
+    msg->page = count;
+    msg->offset = 0;
+    msg->num_bytes = total;
+    msg->status = msg_id;
+    for (uint32_t i = 0; i < count; i++)
+        desc[i].status = MDIPC_DESC_UNSERVED;
+    memcpy((void *)msg->data, desc, table);
+
+    mdipc_set_own(&msg->own, MDIPC_OWN_NDK);
+    if (waitResponse(chan, timeout_us) < 0)
+    {
+        freeChannel(index);
+        return MDIPC_RSP_FAIL;
+    }
+
+    int status = msg->status;
+    memcpy(desc, (const void *)msg->data, table);
+    memcpy(rdata, (const void *)(msg->data + table), total);
+    freeChannel(index);
+    return status;
+}
@@ -0,0 +1,120 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <mutex>
+
+/*
+ * Module Direct IPC: transceiver requests handed to the NDK through the mmapped /var/run/redis/MDIPC<N> files.
+ * The layout and ownership values are shared with the NDK and with MDIPC in sonic_platform/sfp.py, so C++ and
+ * Python clients can use the channels at the same time.
+ */
+#define MDIPC_BASE_NAME                     "/var/run/redis/MDIPC"
+#define MDIPC_NUM_CHANNELS                  10
+
+#define MDIPC_OWN_NDK                       0x5A5A3C3C
+#define MDIPC_OWN_NOS                       0x43211234
+#define MDIPC_OWN_NOS_PREP                  0xDEADBEEF
+#define MDIPC_OWN_NOS_RSP                   0xCBCBAF5F
+
+#define MDIPC_READ                          0
+#define MDIPC_WRITE                         1
+#define MDIPC_PRESENCE                      2
+#define MDIPC_WRITE_CDB_CHAIN               3
+#define MDIPC_READ_MULTI                    4
+#define MDIPC_RSP_SUCCESS                   0
+#define MDIPC_RSP_FAIL                      1
+#define MDIPC_RSP_NOTPRESENT                2
+
+#define MDIPC_TIMEOUT_US                    3000000
+#define MDIPC_MULTI_MAX_DESC                32
+#define MDIPC_DESC_UNSERVED                 0xFFFFFFFF
+
+typedef struct
+{
+    uint32_t own;
+    uint32_t msg_id;
+    uint32_t owner_id;
+    uint32_t hw_port_id;
+    uint32_t op;
+    uint32_t page;
+    uint32_t offset;
+    uint32_t num_bytes;
+    uint32_t status;                        /* msg_id on request, MDIPC_RSP_* on response */
+    uint8_t  data[];
+} tMdipcMsg;
+
+/*
+ * MDIPC_READ_MULTI: page carries the descriptor count and num_bytes the total of their lengths. data
+ * holds the descriptors, followed by the bytes read for each of them in descriptor order. The NDK sets
+ * the status of every descriptor, and the message status is MDIPC_RSP_SUCCESS only when all succeeded.
+ * Descriptors go out as MDIPC_DESC_UNSERVED, so an NDK without the op is recognised by leaving them so.
+ */
+typedef struct
+{
+    uint32_t bank;
+    uint32_t page;
+    uint32_t offset;
+    uint32_t num_bytes;
+    uint32_t status;
+} tMdipcDesc;
+
+/*
+ * Ownership handoff. mdipc_set_own() stores the new owner and wakes any futex waiter on the word,
+ * mdipc_wait_own() spins briefly and then futex-waits until the word reads want. The NDK does not
+ * have to issue FUTEX_WAKE: waits are cut into slices of at most 1 ms, so a peer that only stores
+ * the word is still seen within a slice. Returns 0, or -1 on timeout. Exported with C linkage for
+ * the ctypes binding in sfp.py.
+ */
+extern "C" {
+int  mdipc_wait_own(volatile uint32_t *own, uint32_t want, uint32_t timeout_us);
+void mdipc_set_own(volatile uint32_t *own, uint32_t value);
+}
+
+class MdipcChannel
+{
+public:
+    MdipcChannel() = default;
+    ~MdipcChannel();
+    MdipcChannel(MdipcChannel &&other);
+    MdipcChannel(const MdipcChannel &) = delete;
+    MdipcChannel& operator=(const MdipcChannel &) = delete;
+    bool open(const std::string &name);
+    bool isOpen() const {
+        return msg != nullptr;
+    }
+    size_t dataSize() const {
+        return size - sizeof(tMdipcMsg);
+    }
+    volatile tMdipcMsg *msg = nullptr;
+    size_t size = 0;
+    int fd = -1;
+};
+
+class Mdipc
+{
+public:
+    explicit Mdipc(const std::string &base_name = MDIPC_BASE_NAME, uint32_t num_channels = MDIPC_NUM_CHANNELS);
+    bool isOpen() const {
+        return !channels.empty() && channels[0].isOpen();
+    }
+    /* returns MDIPC_RSP_*; rdata receives num_bytes on a successful MDIPC_READ */
+    int send(uint32_t op, uint32_t hw_port_id, uint32_t page, uint32_t offset, uint32_t num_bytes,
+             const uint8_t *wdata = nullptr, uint8_t *rdata = nullptr, uint32_t timeout_us = MDIPC_TIMEOUT_US);
+    /* one round trip for all descriptors; rdata receives their bytes back to back, desc[].status is updated */
+    int readMulti(uint32_t hw_port_id, tMdipcDesc *desc, uint32_t count, uint8_t *rdata,
+                  uint32_t timeout_us = MDIPC_TIMEOUT_US);
+    /* non-zero: sleep-poll for the response like the original sfp.py loop, for comparison only */
+    uint32_t poll_sleep_us = 0;
+private:
+    int obtainChannel();
+    void freeChannel(int index);
+    int waitResponse(MdipcChannel &chan, uint32_t timeout_us);
+    std::vector<MdipcChannel> channels;
+    std::mutex lock;
+};
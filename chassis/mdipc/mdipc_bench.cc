@@ -0,0 +1,167 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+/*
+ * MDIPC request latency per op.
+ *
+ *   mdipc_bench [-b <base name>] [-c <channels>] [-p <port>] [-n <ops>] [-t <threads>] [-l <poll us>] [-w]
+ *
+ * Runs n requests of each op (presence, lower page read, upper page read, and a DOM refresh of five
+ * page halves done as separate reads and as one MDIPC_READ_MULTI) from t threads against the real NDK
+ * or mdipc_responder and prints p50/p99/max in us. With -l the response is sleep-polled every
+ * <poll us> like the original sfp.py loop (-l 1000) instead of futex-waited.
+ *
+ * -w adds the upper page write. Each write puts back the bytes read from the same location just
+ * before it (the read is not timed), so the module's EEPROM is left as it was.
+ */
+#include "mdipc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+struct BenchOp
+{
+    const char *name;
+    uint32_t op;
+    uint32_t page;
+    uint32_t offset;
+    uint32_t num_bytes;
+    const tMdipcDesc *desc;                 /* desc[count] instead of page/offset/num_bytes */
+    uint32_t count;
+};
+
+static const tMdipcDesc dom_pages[] = {
+    { 0, 0x00, 0,   128, 0 },
+    { 0, 0x00, 128, 128, 0 },
+    { 0, 0x01, 128, 128, 0 },
+    { 0, 0x02, 128, 128, 0 },
+    { 0, 0x11, 128, 128, 0 },
+};
+
+static const BenchOp bench_ops[] = {
+    { "presence",   MDIPC_PRESENCE,   0,    0,   0,   nullptr,   0 },
+    { "read lower", MDIPC_READ,       0,    0,   128, nullptr,   0 },
+    { "read upper", MDIPC_READ,       0x11, 128, 128, nullptr,   0 },
+    { "write",      MDIPC_WRITE,      0x11, 128, 8,   nullptr,   0 },
+    { "dom x5",     MDIPC_READ,       0,    0,   0,   dom_pages, std::size(dom_pages) },
+    { "dom multi",  MDIPC_READ_MULTI, 0,    0,   0,   dom_pages, std::size(dom_pages) },
+};
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void runOp(Mdipc *mdipc, const BenchOp *bop, uint32_t port, uint32_t ops, std::vector<uint64_t> *lat, uint32_t *fails)
+{
+    static thread_local uint8_t buf[MDIPC_MULTI_MAX_DESC * 256];
+    tMdipcDesc desc[MDIPC_MULTI_MAX_DESC];
+
+    for (uint32_t i = 0; i < ops; i++)
+    {
+        int rc = MDIPC_RSP_SUCCESS;
+        if ((bop->op == MDIPC_WRITE) &&
+            ((rc = mdipc->send(MDIPC_READ, port, bop->page, bop->offset, bop->num_bytes, buf, buf)) != MDIPC_RSP_SUCCESS))
+        {
+            /* never write what was not just read back */
+            (*fails)++;
+            continue;
+        }
+        uint64_t t0 = nowNs();
+        if (bop->count == 0)
+            rc = mdipc->send(bop->op, port, bop->page, bop->offset, bop->num_bytes, buf, buf);
+        else if (bop->op == MDIPC_READ_MULTI)
+        {
+            std::copy(bop->desc, bop->desc + bop->count, desc);
+            rc = mdipc->readMulti(port, desc, bop->count, buf);
+        }
+        else
+        {
+            for (uint32_t d = 0; (d < bop->count) && (rc == MDIPC_RSP_SUCCESS); d++)
+                rc = mdipc->send(bop->op, port, bop->desc[d].page, bop->desc[d].offset, bop->desc[d].num_bytes, buf, buf);
+        }
+        lat->push_back(nowNs() - t0);
+        /* presence answers FAIL for a present module */
+        if ((rc != MDIPC_RSP_SUCCESS) && (bop->op != MDIPC_PRESENCE))
+            (*fails)++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string base_name = MDIPC_BASE_NAME;
+    uint32_t num_channels = MDIPC_NUM_CHANNELS, port = 0, ops = 1000, num_threads = 1, poll_us = 0;
+    bool write = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:c:p:n:t:l:w")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': base_name = optarg; break;
+            case 'c': num_channels = strtoul(optarg, NULL, 0); break;
+            case 'p': port = strtoul(optarg, NULL, 0); break;
+            case 'n': ops = strtoul(optarg, NULL, 0); break;
+            case 't': num_threads = strtoul(optarg, NULL, 0); break;
+            case 'l': poll_us = strtoul(optarg, NULL, 0); break;
+            case 'w': write = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-b <base name>] [-c <channels>] [-p <port>] [-n <ops>] [-t <threads>] [-l <poll us>] [-w]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((ops == 0) || (num_threads == 0))
+    {
+        fprintf(stderr, "ops and threads must be non-zero\n");
+        return 1;
+    }
+
+    Mdipc mdipc(base_name, num_channels);
+    if (!mdipc.isOpen())
+    {
+        fprintf(stderr, "%s0 is not available\n", base_name.c_str());
+        return 1;
+    }
+    mdipc.poll_sleep_us = poll_us;
+
+    printf("port %u, %u ops x %u threads, %s\n", port, ops, num_threads, poll_us ? "sleep-poll" : "futex wait");
+    printf("%-12s %10s %10s %10s %10s %8s\n", "op", "p50 us", "p99 us", "max us", "ops/sec", "fails");
+    for (const BenchOp &bop : bench_ops)
+    {
+        if ((bop.op == MDIPC_WRITE) && !write)
+            continue;
+        std::vector<std::vector<uint64_t>> lat(num_threads);
+        std::vector<uint32_t> fails(num_threads);
+        std::vector<std::thread> threads;
+
+        uint64_t t0 = nowNs();
+        for (uint32_t t = 0; t < num_threads; t++)
+            threads.emplace_back(runOp, &mdipc, &bop, port, ops, &lat[t], &fails[t]);
+        for (auto &t : threads)
+            t.join();
+        double secs = (nowNs() - t0) / 1e9;
+
+        std::vector<uint64_t> all;
+        uint32_t total_fails = 0;
+        for (uint32_t t = 0; t < num_threads; t++)
+        {
+            all.insert(all.end(), lat[t].begin(), lat[t].end());
+            total_fails += fails[t];
+        }
+        if (all.empty())
+        {
+            printf("%-12s %10s %10s %10s %10s %8u\n", bop.name, "-", "-", "-", "-", total_fails);
+            continue;
+        }
+        std::sort(all.begin(), all.end());
+        printf("%-12s %10.1f %10.1f %10.1f %10.0f %8u\n", bop.name, all[all.size() / 2] / 1e3,
+               all[(all.size() * 99) / 100] / 1e3, all.back() / 1e3, all.size() / secs, total_fails);
+    }
+    return 0;
+}
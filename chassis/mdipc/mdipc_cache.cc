@@ -0,0 +1,202 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#include "mdipc_cache.h"
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MDIPC_CACHE_RETRIES                 8
+
+static tMdipcCache *cache;
+
+static uint64_t cacheNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void cacheStat(int stat)
+{
+    __atomic_fetch_add(&cache->stats[stat], 1, __ATOMIC_RELAXED);
+}
+
+static tMdipcCacheEntry *cacheSet(uint32_t port, uint32_t bank, uint32_t page, uint32_t offset)
+{
+    uint32_t key = (port << 17) ^ (bank << 9) ^ (page << 1) ^ (offset / MDIPC_CACHE_CHUNK);
+    return cache->entry[(key * 2654435761u) >> (32 - MDIPC_CACHE_SET_BITS)];
+}
+
+static bool cacheMatch(const tMdipcCacheEntry *e, uint32_t port, uint32_t bank, uint32_t page, uint32_t offset)
+{
+    return (e->port == port) && (e->bank == bank) && (e->page == page) && (e->offset == offset);
+}
+
+/*
+ * Whoever finds the file missing or of another layout (re)initialises it under the flock. Only its
+ * owner (root: xcvrd, sfputil) may write it, anyone else who opens it falls back to a private cache;
+ * a file left world-writable by an older build is tightened by the first owner to open it.
+ */
+#define MDIPC_CACHE_MODE 0644
+extern "C" int mdipc_cache_open(const char *name)
+{
+    struct stat st;
+
+    if (cache != nullptr)
+        return 0;
+    int fd = open(name, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, MDIPC_CACHE_MODE);
+    if (fd < 0)
+        return -1;
+    flock(fd, LOCK_EX);
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    if ((st.st_mode & 07777) != MDIPC_CACHE_MODE)
+        fchmod(fd, MDIPC_CACHE_MODE);
+    if (st.st_size != sizeof(tMdipcCache))
+    {
+        if ((ftruncate(fd, 0) < 0) || (ftruncate(fd, sizeof(tMdipcCache)) < 0))
+        {
+            close(fd);
+            return -1;
+        }
+    }
+    void *map = mmap(nullptr, sizeof(tMdipcCache), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED)
+    {
+        tMdipcCache *c = (tMdipcCache *)map;
+        if (c->magic != MDIPC_CACHE_MAGIC)
+        {
+            memset(c, 0, sizeof(*c));
+            c->size = sizeof(*c);
+            __atomic_store_n(&c->magic, MDIPC_CACHE_MAGIC, __ATOMIC_RELEASE);
+        }
+        cache = c;
+    }
+    flock(fd, LOCK_UN);
+    close(fd);
+    return (cache != nullptr) ? 0 : -1;
+}
+
+extern "C" uint32_t mdipc_cache_gen(uint32_t port)
+{
+    if ((cache == nullptr) || (port >= MDIPC_CACHE_PORTS))
+        return 0;
+    return __atomic_load_n(&cache->gen[port], __ATOMIC_ACQUIRE);
+}
+
+extern "C" void mdipc_cache_invalidate(uint32_t port)
+{
+    if ((cache == nullptr) || (port >= MDIPC_CACHE_PORTS))
+        return;
+    __atomic_fetch_add(&cache->gen[port], 1, __ATOMIC_ACQ_REL);
+    cacheStat(MDIPC_CACHE_STAT_INVALIDATIONS);
+}
+
+extern "C" int mdipc_cache_lookup(uint32_t port, uint32_t bank, uint32_t page, uint32_t offset, uint32_t ttl_ms,
+                                  uint8_t *data, uint32_t len)
+{
+    if ((cache == nullptr) || (port >= MDIPC_CACHE_PORTS) || (len > MDIPC_CACHE_CHUNK))
+        return -1;
+
+    uint32_t gen = mdipc_cache_gen(port);
+    tMdipcCacheEntry *set = cacheSet(port, bank, page, offset);
+    for (int w = 0; w < MDIPC_CACHE_WAYS; w++)
+    {
+        tMdipcCacheEntry *e = &set[w];
+        bool match = false, stable = false;
+        uint64_t fill_ns = 0;
+
+        for (int tries = 0; (tries < MDIPC_CACHE_RETRIES) && !stable; tries++)
+        {
+            uint32_t seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+            if (seq & 1)
+                continue;
+            match = cacheMatch(e, port, bank, page, offset) && (e->gen == gen) && (e->len >= len);
+            fill_ns = e->fill_ns;
+            if (match)
+                memcpy(data, e->data, len);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            stable = (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) == seq);
+        }
+        if (!stable)
+        {
+            cacheStat(MDIPC_CACHE_STAT_BUSY);
+            continue;
+        }
+        if (!match)
+            continue;
+        if (ttl_ms && ((cacheNowNs() - fill_ns) > (uint64_t)ttl_ms * 1000000))
+        {
+            cacheStat(MDIPC_CACHE_STAT_EXPIRED);
+            return -1;
+        }
+        cacheStat(MDIPC_CACHE_STAT_HITS);
+        return 0;
+    }
+    cacheStat(MDIPC_CACHE_STAT_MISSES);
+    return -1;
+}
+
+extern "C" void mdipc_cache_insert(uint32_t port, uint32_t bank, uint32_t page, uint32_t offset,
+                                   const uint8_t *data, uint32_t len, uint32_t gen)
+{
+    if ((cache == nullptr) || (port >= MDIPC_CACHE_PORTS) || (len == 0) || (len > MDIPC_CACHE_CHUNK))
+        return;
+    /* the module went away while this was being read */
+    if (gen != mdipc_cache_gen(port))
+        return;
+
+    /* same key first, then a free or invalidated way, then the oldest; the choice is unlocked and only a hint */
+    tMdipcCacheEntry *set = cacheSet(port, bank, page, offset);
+    tMdipcCacheEntry *victim = nullptr;
+    bool evict = false;
+    for (int w = 0; (w < MDIPC_CACHE_WAYS) && (victim == nullptr); w++)
+        if (cacheMatch(&set[w], port, bank, page, offset))
+            victim = &set[w];
+    for (int w = 0; (w < MDIPC_CACHE_WAYS) && (victim == nullptr); w++)
+        if ((set[w].len == 0) || (set[w].port >= MDIPC_CACHE_PORTS) || (set[w].gen != mdipc_cache_gen(set[w].port)))
+            victim = &set[w];
+    if (victim == nullptr)
+    {
+        victim = &set[0];
+        for (int w = 1; w < MDIPC_CACHE_WAYS; w++)
+            if (set[w].fill_ns < victim->fill_ns)
+                victim = &set[w];
+        evict = true;
+    }
+
+    uint32_t seq = __atomic_load_n(&victim->seq, __ATOMIC_RELAXED);
+    if ((seq & 1) || !__atomic_compare_exchange_n(&victim->seq, &seq, seq + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        cacheStat(MDIPC_CACHE_STAT_BUSY);
+        return;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    victim->port = port;
+    victim->bank = bank;
+    victim->page = page;
+    victim->offset = offset;
+    victim->len = len;
+    victim->gen = gen;
+    victim->fill_ns = cacheNowNs();
+    memcpy(victim->data, data, len);
+    __atomic_store_n(&victim->seq, seq + 2, __ATOMIC_RELEASE);
+
+    cacheStat(MDIPC_CACHE_STAT_INSERTS);
+    if (evict)
+        cacheStat(MDIPC_CACHE_STAT_EVICTIONS);
+}
+
+extern "C" void mdipc_cache_stats(uint64_t *stats, uint32_t num)
+{
+    for (uint32_t i = 0; i < num; i++)
+        stats[i] = ((cache != nullptr) && (i < MDIPC_CACHE_STAT_NUM)) ? __atomic_load_n(&cache->stats[i], __ATOMIC_RELAXED) : 0;
+}
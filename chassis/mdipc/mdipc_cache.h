@@ -0,0 +1,72 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Transceiver EEPROM chunks shared between every process using sfp.py (xcvrd, sfputil, show, snmp), so they
+ * stop issuing their own MDIPC reads for the same pages. Entries are 128-byte halves keyed by (port, bank,
+ * page, offset) in a 4-way set associative table in a shared file, read under a per-entry seqlock.
+ *
+ * Every port has a generation number. mdipc_cache_invalidate() bumps it on presence change or EEPROM write,
+ * which drops all entries of the port at once. Callers take the generation before their MDIPC read and
+ * insert with it, so data read across a removal never becomes visible. Lookups pass the TTL of the page
+ * class; 0 keeps the entry until the next invalidation.
+ */
+#define MDIPC_CACHE_NAME                    "/var/run/redis/MDIPC_cache"
+#define MDIPC_CACHE_MAGIC                   0x4D504331
+#define MDIPC_CACHE_PORTS                   128
+#define MDIPC_CACHE_SET_BITS                10
+#define MDIPC_CACHE_SETS                    (1 << MDIPC_CACHE_SET_BITS)
+#define MDIPC_CACHE_WAYS                    4
+#define MDIPC_CACHE_CHUNK                   128
+
+enum
+{
+    MDIPC_CACHE_STAT_HITS,
+    MDIPC_CACHE_STAT_MISSES,
+    MDIPC_CACHE_STAT_EXPIRED,
+    MDIPC_CACHE_STAT_INSERTS,
+    MDIPC_CACHE_STAT_EVICTIONS,
+    MDIPC_CACHE_STAT_INVALIDATIONS,
+    MDIPC_CACHE_STAT_BUSY,                  /* lookups or inserts that lost to a concurrent writer */
+    MDIPC_CACHE_STAT_NUM
+};
+
+typedef struct
+{
+    uint32_t seq;                           /* odd while a writer owns the entry */
+    uint32_t port;
+    uint32_t bank;
+    uint32_t page;
+    uint32_t offset;
+    uint32_t len;                           /* 0: empty */
+    uint32_t gen;
+    uint32_t pad;
+    uint64_t fill_ns;                       /* CLOCK_MONOTONIC, same clock in every container */
+    uint8_t  data[MDIPC_CACHE_CHUNK];
+} tMdipcCacheEntry;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t size;
+    uint32_t gen[MDIPC_CACHE_PORTS];
+    uint64_t stats[MDIPC_CACHE_STAT_NUM];
+    tMdipcCacheEntry entry[MDIPC_CACHE_SETS][MDIPC_CACHE_WAYS];
+} tMdipcCache;
+
+/* C linkage for the ctypes binding in sfp.py; all calls are no-ops or misses until mdipc_cache_open() succeeded */
+extern "C" {
+int      mdipc_cache_open(const char *name);
+uint32_t mdipc_cache_gen(uint32_t port);
+void     mdipc_cache_invalidate(uint32_t port);
+int      mdipc_cache_lookup(uint32_t port, uint32_t bank, uint32_t page, uint32_t offset, uint32_t ttl_ms,
+                            uint8_t *data, uint32_t len);
+void     mdipc_cache_insert(uint32_t port, uint32_t bank, uint32_t page, uint32_t offset,
+                            const uint8_t *data, uint32_t len, uint32_t gen);
+void     mdipc_cache_stats(uint64_t *stats, uint32_t num);
+}
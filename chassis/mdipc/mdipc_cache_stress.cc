@@ -0,0 +1,182 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+/*
+ * Concurrent readers of the shared page cache against mdipc_responder.
+ *
+ *   mdipc_cache_stress [-b <base name>] [-f <cache file>] [-r <readers>] [-p <ports>] [-s <seconds>] [-i <invalidate ms>]
+ *
+ * Forks <readers> processes that each read random (port, page half) chunks the way sfp.py does: cache lookup
+ * with the TTL of the page class, and on a miss an MDIPC read inserted under the generation taken before it.
+ * The parent invalidates a random port every <invalidate ms> like a presence change would. Every chunk is
+ * checked against the responder pattern, so a torn or misplaced entry is counted as corrupt.
+ */
+#include "mdipc.h"
+#include "mdipc_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <iterator>
+
+struct StressChunk
+{
+    uint32_t page;
+    uint32_t offset;
+    uint32_t ttl_ms;
+};
+
+/* same classes as shared_cache_ttl() in sfp.py */
+static const StressChunk chunks[] = {
+    { 0x00, 0,   500  },
+    { 0x00, 128, 0    },
+    { 0x01, 128, 0    },
+    { 0x02, 128, 0    },
+    { 0x11, 128, 2000 },
+};
+
+struct StressResult
+{
+    uint64_t reads;
+    uint64_t ndk_reads;
+    uint64_t corrupt;
+    uint64_t failed;
+};
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* mdipc_responder fills every byte with offset ^ page ^ port */
+static bool chunkValid(const uint8_t *data, uint32_t port, uint32_t page, uint32_t offset)
+{
+    for (uint32_t i = 0; i < MDIPC_CACHE_CHUNK; i++)
+        if (data[i] != (uint8_t)((offset + i) ^ page ^ port))
+            return false;
+    return true;
+}
+
+static void reader(const std::string &base_name, uint32_t ports, uint64_t end_ns, StressResult *res)
+{
+    Mdipc mdipc(base_name);
+    uint8_t data[MDIPC_CACHE_CHUNK];
+    unsigned int seed = getpid();
+
+    while (nowNs() < end_ns)
+    {
+        uint32_t port = rand_r(&seed) % ports;
+        const StressChunk &c = chunks[rand_r(&seed) % std::size(chunks)];
+
+        res->reads++;
+        if (mdipc_cache_lookup(port, 0, c.page, c.offset, c.ttl_ms, data, sizeof(data)) < 0)
+        {
+            uint32_t gen = mdipc_cache_gen(port);
+            int rc = MDIPC_RSP_FAIL;
+            res->ndk_reads++;
+            /* with more readers than channels a send can find them all busy */
+            for (int tries = 0; (tries < 10) && (rc != MDIPC_RSP_SUCCESS); tries++)
+            {
+                rc = mdipc.send(MDIPC_READ, port, c.page, c.offset, sizeof(data), nullptr, data);
+                if (rc != MDIPC_RSP_SUCCESS)
+                    usleep(200);
+            }
+            if (rc != MDIPC_RSP_SUCCESS)
+            {
+                res->failed++;
+                continue;
+            }
+            mdipc_cache_insert(port, 0, c.page, c.offset, data, sizeof(data), gen);
+        }
+        if (!chunkValid(data, port, c.page, c.offset))
+            res->corrupt++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::string base_name = MDIPC_BASE_NAME;
+    const char *cache_name = MDIPC_CACHE_NAME;
+    uint32_t readers = 16, ports = 36, seconds = 5, invalidate_ms = 100;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:f:r:p:s:i:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': base_name = optarg; break;
+            case 'f': cache_name = optarg; break;
+            case 'r': readers = strtoul(optarg, NULL, 0); break;
+            case 'p': ports = strtoul(optarg, NULL, 0); break;
+            case 's': seconds = strtoul(optarg, NULL, 0); break;
+            case 'i': invalidate_ms = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-b <base name>] [-f <cache file>] [-r <readers>] [-p <ports>] [-s <seconds>] [-i <invalidate ms>]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((readers == 0) || (ports == 0) || (ports > MDIPC_CACHE_PORTS))
+    {
+        fprintf(stderr, "need at least one reader and 1..%d ports\n", MDIPC_CACHE_PORTS);
+        return 1;
+    }
+    if (mdipc_cache_open(cache_name) < 0)
+    {
+        perror(cache_name);
+        return 1;
+    }
+
+    StressResult *results = (StressResult *)mmap(nullptr, readers * sizeof(StressResult), PROT_READ | PROT_WRITE,
+                                                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results == MAP_FAILED)
+        return 1;
+    memset(results, 0, readers * sizeof(StressResult));
+
+    uint64_t stats0[MDIPC_CACHE_STAT_NUM], stats[MDIPC_CACHE_STAT_NUM];
+    mdipc_cache_stats(stats0, MDIPC_CACHE_STAT_NUM);
+
+    uint64_t end_ns = nowNs() + (uint64_t)seconds * 1000000000;
+    for (uint32_t r = 0; r < readers; r++)
+    {
+        if (fork() == 0)
+        {
+            reader(base_name, ports, end_ns, &results[r]);
+            _exit(0);
+        }
+    }
+
+    unsigned int seed = getpid();
+    while (invalidate_ms && (nowNs() < end_ns))
+    {
+        usleep(invalidate_ms * 1000);
+        mdipc_cache_invalidate(rand_r(&seed) % ports);
+    }
+    while (wait(nullptr) > 0)
+        ;
+
+    StressResult total = {};
+    for (uint32_t r = 0; r < readers; r++)
+    {
+        total.reads += results[r].reads;
+        total.ndk_reads += results[r].ndk_reads;
+        total.corrupt += results[r].corrupt;
+        total.failed += results[r].failed;
+    }
+    mdipc_cache_stats(stats, MDIPC_CACHE_STAT_NUM);
+    for (int i = 0; i < MDIPC_CACHE_STAT_NUM; i++)
+        stats[i] -= stats0[i];
+
+    printf("%u readers, %u ports, %u s, invalidate every %u ms\n", readers, ports, seconds, invalidate_ms);
+    printf("reads %lu (%.0f/s)  ndk reads %lu (%.1f%%)  failed %lu  corrupt %lu\n", total.reads, (double)total.reads / seconds,
+           total.ndk_reads, total.reads ? 100.0 * total.ndk_reads / total.reads : 0.0, total.failed, total.corrupt);
+    printf("cache: hits %lu misses %lu expired %lu inserts %lu evictions %lu invalidations %lu busy %lu\n",
+           stats[MDIPC_CACHE_STAT_HITS], stats[MDIPC_CACHE_STAT_MISSES], stats[MDIPC_CACHE_STAT_EXPIRED],
+           stats[MDIPC_CACHE_STAT_INSERTS], stats[MDIPC_CACHE_STAT_EVICTIONS], stats[MDIPC_CACHE_STAT_INVALIDATIONS],
+           stats[MDIPC_CACHE_STAT_BUSY]);
+    return total.corrupt ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+/*
+ * Stand-in for the NDK side of MDIPC, for exercising sfp.py and mdipc_bench without a line card.
+ *
+ *   mdipc_responder [-b <base name>] [-c <channels>] [-s <channel size>] [-p <ports>] [-d <delay us>] [-a <absent port>]... [-m]
+ *
+ * Creates <base name>0..N-1, then serves each channel from its own thread against an in-memory EEPROM
+ * (256 pages of 256 bytes per port). An unwritten byte reads as offset ^ page ^ port. Ports given with -a
+ * answer MDIPC_RSP_NOTPRESENT, and -d adds a fixed service time per request to mimic the I2C access.
+ * MDIPC_READ_MULTI is served as well, so sfp.py can be tested with and without it (-m turns it off).
+ * The response is published with mdipc_set_own(), so futex waiters wake immediately.
+ */
+#include "mdipc.h"
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <set>
+#include <thread>
+
+#define EEPROM_PAGES                        256
+#define EEPROM_PAGE_SIZE                    256
+
+static volatile sig_atomic_t stop;
+static std::vector<uint8_t> eeprom;
+static std::set<uint32_t> absent;
+static uint32_t num_ports = 36;
+static uint32_t delay_us;
+static bool no_multi;
+
+static void onSignal(int)
+{
+    stop = 1;
+}
+
+static uint8_t *eepromAt(uint32_t port, uint32_t page, uint32_t offset, uint32_t num_bytes)
+{
+    if ((page >= EEPROM_PAGES) || (offset >= EEPROM_PAGE_SIZE) || (num_bytes > EEPROM_PAGE_SIZE - offset))
+        return nullptr;
+    return &eeprom[((size_t)port * EEPROM_PAGES + page) * EEPROM_PAGE_SIZE + offset];
+}
+
+/* banks are not modelled, every bank reads the same pages */
+static uint32_t serveMulti(volatile tMdipcMsg *msg, size_t data_size)
+{
+    uint32_t count = msg->page;
+    size_t table = count * sizeof(tMdipcDesc);
+    uint32_t status = MDIPC_RSP_SUCCESS;
+
+    if ((count == 0) || (count > MDIPC_MULTI_MAX_DESC) || (table + msg->num_bytes > data_size))
+        return MDIPC_RSP_FAIL;
+
+    volatile tMdipcDesc *desc = (volatile tMdipcDesc *)msg->data;
+    volatile uint8_t *out = msg->data + table;
+    size_t used = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t *mem = eepromAt(msg->hw_port_id, desc[i].page, desc[i].offset, desc[i].num_bytes);
+        if ((mem == nullptr) || (used + desc[i].num_bytes > msg->num_bytes))
+        {
+            desc[i].status = MDIPC_RSP_FAIL;
+            status = MDIPC_RSP_FAIL;
+        }
+        else
+        {
+            memcpy((void *)(out + used), mem, desc[i].num_bytes);
+            desc[i].status = MDIPC_RSP_SUCCESS;
+        }
+        used += desc[i].num_bytes;
+    }
+    return status;
+}
+
+static uint32_t serve(volatile tMdipcMsg *msg, size_t data_size)
+{
+    uint32_t port = msg->hw_port_id;
+    uint32_t num_bytes = msg->num_bytes;
+
+    if (delay_us)
+        usleep(delay_us);
+    if ((port >= num_ports) || absent.count(port))
+        return (msg->op == MDIPC_PRESENCE) ? MDIPC_RSP_SUCCESS : MDIPC_RSP_NOTPRESENT;
+    if (msg->op == MDIPC_PRESENCE)
+        return MDIPC_RSP_FAIL;              /* sfp.py reads FAIL as present */
+    if ((msg->op == MDIPC_READ_MULTI) && !no_multi)
+        return serveMulti(msg, data_size);
+
+    uint8_t *mem = eepromAt(port, msg->page, msg->offset, num_bytes);
+    if ((mem == nullptr) || (num_bytes > data_size))
+        return MDIPC_RSP_FAIL;
+
+    switch (msg->op)
+    {
+        case MDIPC_READ:
+            memcpy((void *)msg->data, mem, num_bytes);
+            return MDIPC_RSP_SUCCESS;
+        case MDIPC_WRITE:
+        case MDIPC_WRITE_CDB_CHAIN:
+            memcpy(mem, (const void *)msg->data, num_bytes);
+            return MDIPC_RSP_SUCCESS;
+        default:
+            return MDIPC_RSP_FAIL;
+    }
+}
+
+static void channelLoop(MdipcChannel *chan)
+{
+    while (!stop)
+    {
+        if (mdipc_wait_own(&chan->msg->own, MDIPC_OWN_NDK, 100000) < 0)
+            continue;
+        chan->msg->status = serve(chan->msg, chan->dataSize());
+        mdipc_set_own(&chan->msg->own, MDIPC_OWN_NOS_RSP);
+    }
+}
+
+static bool createChannel(const std::string &name, size_t size)
+{
+    int fd = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0)
+        return false;
+    bool ok = (ftruncate(fd, size) == 0);
+    if (ok)
+    {
+        tMdipcMsg hdr = {};
+        hdr.own = MDIPC_OWN_NOS;
+        ok = (pwrite(fd, &hdr, sizeof(hdr), 0) == (ssize_t)sizeof(hdr));
+    }
+    close(fd);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string base_name = MDIPC_BASE_NAME;
+    uint32_t num_channels = MDIPC_NUM_CHANNELS;
+    size_t size = 4096;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:c:s:p:d:a:m")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b': base_name = optarg; break;
+            case 'c': num_channels = strtoul(optarg, NULL, 0); break;
+            case 's': size = strtoul(optarg, NULL, 0); break;
+            case 'p': num_ports = strtoul(optarg, NULL, 0); break;
+            case 'd': delay_us = strtoul(optarg, NULL, 0); break;
+            case 'a': absent.insert(strtoul(optarg, NULL, 0)); break;
+            case 'm': no_multi = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-b <base name>] [-c <channels>] [-s <channel size>] [-p <ports>] [-d <delay us>] [-a <absent port>]... [-m]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((num_channels == 0) || (size <= sizeof(tMdipcMsg)))
+    {
+        fprintf(stderr, "need at least one channel larger than the %zu byte header\n", sizeof(tMdipcMsg));
+        return 1;
+    }
+
+    eeprom.resize((size_t)num_ports * EEPROM_PAGES * EEPROM_PAGE_SIZE);
+    for (size_t i = 0; i < eeprom.size(); i++)
+        eeprom[i] = (i % EEPROM_PAGE_SIZE) ^ ((i / EEPROM_PAGE_SIZE) % EEPROM_PAGES) ^ (i / (EEPROM_PAGES * EEPROM_PAGE_SIZE));
+
+    std::vector<MdipcChannel> channels(num_channels);
+    for (uint32_t i = 0; i < num_channels; i++)
+    {
+        std::string name = base_name + std::to_string(i);
+        if (!createChannel(name, size) || !channels[i].open(name))
+        {
+            perror(name.c_str());
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    std::vector<std::thread> threads;
+    for (auto &chan : channels)
+        threads.emplace_back(channelLoop, &chan);
+    printf("serving %u channels at %s<N> for %u ports\n", num_channels, base_name.c_str(), num_ports);
+    fflush(stdout);
+    for (auto &t : threads)
+        t.join();
+    return 0;
+}
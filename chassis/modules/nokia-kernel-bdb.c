@@ -7,6 +7,11 @@
 #include <linux/delay.h>
 #include <linux/version.h>
 #include <linux/io.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/bitops.h>
+#include <linux/interrupt.h>
+#include <linux/wait.h>
 
 MODULE_AUTHOR("Nokia Corporation");
 MODULE_DESCRIPTION("BDE-BDB Helper Module");
@@ -23,6 +28,10 @@ MODULE_LICENSE("GPL");
 #define atomicDec(ptr)        __atomic_fetch_sub((uint32_t *)(ptr), (uint32_t)1, __ATOMIC_SEQ_CST)
 
 static void nokia_dump(struct seq_file *m);
+static void iproc_trace_dump(struct seq_file *m);
+static void iproc_trace_ctl(const char *cmd);
+static void bdb_setup(void);
+static void bdb_teardown(void);
 static int nokia_ioctl(unsigned int cmd, unsigned long arg);
 
 static int use_count = 0;
@@ -41,6 +50,14 @@ static int _proc_open(struct inode * inode, struct file * file)
 static ssize_t _proc_write(struct file *file, const char *buffer,
                    size_t count, loff_t *loff)
 {
+    char cmd[32];
+    size_t len = min(count, sizeof(cmd) - 1);
+
+    if (copy_from_user(cmd, buffer, len))
+        return -EFAULT;
+    cmd[len] = '\0';
+    iproc_trace_ctl(strim(cmd));
+
     return count;
 }
 
@@ -112,7 +129,9 @@ static int __init nokia_bdb_init(void)
         return rc;
     }
 
-    ent1 = proc_create(KERNEL_MOD_NAME, S_IRUGO | S_IWUGO, NULL, &_proc_fops);
+    bdb_setup();
+
+    ent1 = proc_create(KERNEL_MOD_NAME, S_IRUGO | S_IWUSR, NULL, &_proc_fops);
     
     printk(KINFO "proc_create 2 = %p, kern_major=%d\n", ent1, KERNEL_MAJOR);
 
@@ -121,7 +140,9 @@ static int __init nokia_bdb_init(void)
 
 static void __exit nokia_bdb_exit(void)
 {
+    /* drop the control entry first so no "trace start" can race the teardown */
     remove_proc_entry(KERNEL_MOD_NAME, NULL);
+    bdb_teardown();
     unregister_chrdev(KERNEL_MAJOR, KERNEL_MOD_NAME);
 
     printk(KERN_INFO "exit\n");
@@ -197,6 +218,14 @@ static int nokia_debug;
 module_param(nokia_debug, int, 0);
 MODULE_PARM_DESC(nokia_debug,"Set debug level (default 0)");
 
+static int bdb_irq = -1;
+module_param(bdb_irq, int, 0444);
+MODULE_PARM_DESC(bdb_irq,"cpuctl FPGA interrupt raised on BDB response, waiters sleep on it instead of polling (default -1, none)");
+
+static uint iproc_subwins = 0x80;
+module_param(iproc_subwins, uint, 0444);
+MODULE_PARM_DESC(iproc_subwins,"Bitmask of BAR0 subwindows 0-7 the iProc window cache may reprogram, 2 and 6 are never used (default 0x80)");
+
 
 #include <linux/mutex.h>
 
@@ -224,6 +253,23 @@ MODULE_PARM_DESC(nokia_debug,"Set debug level (default 0)");
 #define LUBDE_NOKIA_OP_BDB_INIT             _IO(LUBDE_MAGIC, 101)
 #define LUBDE_NOKIA_OP_BDB_READ             _IO(LUBDE_MAGIC, 102)
 #define LUBDE_NOKIA_OP_BDB_WRITE            _IO(LUBDE_MAGIC, 103)
+#define LUBDE_NOKIA_OP_BDB_BATCH            _IO(LUBDE_MAGIC, 104)
+
+/* LUBDE_NOKIA_OP_BDB_BATCH: p0 = user array of nokia_bdb_op_t, d0 = entries, returns d1 = failed entries */
+#define BDB_BATCH_MAX                       4096
+#define BDB_OP_READ                         0   /* 32-bit BDB read of addr on hw slot */
+#define BDB_OP_WRITE                        1
+#define BDB_OP_BDE_READ                     2   /* dev main register space, as LUBDE_READ_REG_16BIT_BUS */
+#define BDB_OP_BDE_WRITE                    3
+
+typedef struct {
+    uint32_t slot;
+    uint32_t dev;
+    uint32_t addr;
+    uint32_t op;
+    uint32_t value;
+    uint32_t rc;
+} nokia_bdb_op_t;
 
 #define BDB_BITS_DEFAULT                    (B_GEN_CONFIG_BDB_ENABLE | M_GEN_CONFIG_RTCCF_HOLD | M_GEN_CONFIG_RTCCF_ACTIVE | M_GEN_CONFIG_RTCCF_SETUP)
 
@@ -294,6 +340,11 @@ MODULE_PARM_DESC(nokia_debug,"Set debug level (default 0)");
 
 #define A64_XRS_SCRATCHPAD          0x00800500
 
+#define IPROC_SUBWIN_MAX            8
+#define IPROC_SUBWIN_NONE           0xffffffff
+#define IPROC_SUBWIN_RESERVED       ((1 << 2) | (1 << 6))   /* PAXB registers, fixed window */
+#define IPROC_TRACE_MAX             (64*1024)
+
 struct
 {
     int         is_valid;
@@ -305,7 +356,14 @@ struct
     uint32      hw_slot;
     uint32      hw_main_baseaddr;
     uint32      hw_iproc_baseaddr;
-    uint32      last_subwin_base;
+    struct {
+        uint32  base;
+        uint32  win;
+        uint32  used;
+    } subwin[IPROC_SUBWIN_MAX];
+    uint32      nsubwin;
+    uint32      subwin_clock;
+    uint32      subwin_hit, subwin_miss, subwin_evict;
     struct mutex iproc_lock;
 } nokia_dev[MAX_NOKIA_RAMONS];
 
@@ -319,11 +377,31 @@ static uint32 bde_read, bde_write, nok_read, nok_write, iproc_read_reg, iproc_wr
 static uint32 bdb_read_fail, bdb_write_fail;
 static uint32 bdb_read_flushes, bdb_write_flushes, bdb_sac_write_fail, bdb_fifo_depth_wait;
 static uint32 bdb_write_retries, bdb_write_retry_failures, bdb_read_retries, bdb_read_retry_failures;
-static uint32 max_retries = 3, max_wait_time;
+static uint32 max_retries = 3;
+static uint32 bdb_batches, bdb_batch_ops;
 
 
 static DEFINE_MUTEX(bdb_lock);
 static struct mutex bdb_slot_lock[MAX_HWSLOT+1];
+static DECLARE_WAIT_QUEUE_HEAD(bdb_wq);
+static uint32 bdb_irqs;
+
+/*
+ * Per-slot response latency. Bucket b counts responses that took less than 2^b us, the last bucket
+ * everything slower. ewma_ns sizes the busy-wait before a waiter sleeps.
+ */
+#define BDB_HIST_BUCKETS                    16
+#define BDB_SPIN_MIN_NS                     (2*1000)
+#define BDB_SPIN_MAX_NS                     (50*1000)
+#define BDB_SLEEP_US                        10
+static struct {
+    uint32      hist[BDB_HIST_BUCKETS];
+    uint64      total_ns;
+    uint32      count;
+    uint32      max_ns;
+    uint32      ewma_ns;
+    uint32      sleeps;
+} bdb_slot_stats[MAX_HWSLOT+1];
 
 static void nokia_dump(struct seq_file *m)
 {
@@ -333,16 +411,38 @@ static void nokia_dump(struct seq_file *m)
     seq_printf(m, " bde_read:    %10u  bde_write:   %10u\n", bde_read, bde_write);
     seq_printf(m, " nok_read:    %10u  nok_write:   %10u\n", nok_read, nok_write);
     seq_printf(m, " iproc_read:  %10u  iproc_write: %10u  cache_hit: %u\n", iproc_read_reg, iproc_write_reg, iproc_cache_hit);
-    seq_printf(m, " fifo_wait:  %6u  ack flush:   %6u  sac_write:  %6u  max_wait:   %u us\n", bdb_fifo_depth_wait, bdb_spurious_ack, bdb_sac_write_fail, max_wait_time/1000);
+    seq_printf(m, " fifo_wait:  %6u  ack flush:   %6u  sac_write:  %6u  irqs:       %u\n", bdb_fifo_depth_wait, bdb_spurious_ack, bdb_sac_write_fail, bdb_irqs);
     seq_printf(m, " read_fail:  %6u  read_flush:  %6u  read_retry: %4u  retry_fail: %u\n", bdb_read_fail,  bdb_read_flushes,  bdb_read_retries,  bdb_read_retry_failures);
     seq_printf(m, " write_fail: %6u  write_flush: %6u  write_retry:%4u  retry_fail: %u\n", bdb_write_fail, bdb_write_flushes, bdb_write_retries, bdb_write_retry_failures);
+    seq_printf(m, " batches:    %6u  batch_ops:   %10u\n", bdb_batches, bdb_batch_ops);
+
+    seq_printf(m, " response latency per slot (us buckets <1 <2 <4 ... <16384 >=16384):\n");
+    for (idx = 0; idx <= MAX_HWSLOT; idx++)
+    {
+        int b;
+
+        if (!bdb_slot_stats[idx].count)
+            continue;
+        seq_printf(m, "\tslot %2d: n %u avg %llu us max %u us sleeps %u |", idx, bdb_slot_stats[idx].count,
+                   div64_u64(bdb_slot_stats[idx].total_ns, bdb_slot_stats[idx].count * 1000ULL),
+                   bdb_slot_stats[idx].max_ns / 1000, bdb_slot_stats[idx].sleeps);
+        for (b = 0; b < BDB_HIST_BUCKETS; b++)
+            seq_printf(m, " %u", bdb_slot_stats[idx].hist[b]);
+        seq_printf(m, "\n");
+    }
 
     for (idx = 0; idx < MAX_NOKIA_RAMONS; idx++) 
     {
         if (IS_NOKIA_DEV(idx))
+        {
             seq_printf(m, "\t%d (swi) : PCI device %s:%d:%d on Nokia SFM module hwslot %d\n", idx, NOKIA_DEV_NAME, nokia_dev[idx].sfm_num, nokia_dev[idx].unit, nokia_dev[idx].hw_slot);
+            seq_printf(m, "\t    iproc subwins %u  hit %u  miss %u  evict %u\n", nokia_dev[idx].nsubwin,
+                       nokia_dev[idx].subwin_hit, nokia_dev[idx].subwin_miss, nokia_dev[idx].subwin_evict);
+        }
     }
 
+    iproc_trace_dump(m);
+
     msgCount = 100;
 }
 
@@ -387,34 +487,70 @@ uint32 bdbFifoDepth(uint32 hwSlot)
 #define B_GEN_CONFIG_RESP_WRACK     0x20000000
 #define B_GEN_CONFIG_RESP_ERROR     0x40000000
 
+static bool bdbResultReady(int hwSlot, uint32 * ctrl)
+{
+    void * bdb_regs = IOCTL_BASE + IOCTL_BDB_REGS_OFFSET;
+    uint32 bdbSlot;
+
+    *ctrl = read32_be(bdb_regs + BDB_CTRL_REG_OFF);
+    bdbSlot = bdb_parallel ? ((*ctrl & M_GEN_CONFIG_BDB_RESP_SLOT) >> S_GEN_CONFIG_BDB_RESP_SLOT) : hwSlot;
+
+    return (*ctrl & B_GEN_CONFIG_P_READ_DONE) && (hwSlot == bdbSlot);
+}
+
+static void bdbLatencyRecord(int hwSlot, uint64 ns)
+{
+    uint32 us = ns / 1000;
+    int b = us ? min(fls(us), BDB_HIST_BUCKETS - 1) : 0;
+
+    bdb_slot_stats[hwSlot].hist[b]++;
+    bdb_slot_stats[hwSlot].total_ns += ns;
+    bdb_slot_stats[hwSlot].count++;
+    if (ns > bdb_slot_stats[hwSlot].max_ns)
+        bdb_slot_stats[hwSlot].max_ns = min_t(uint64, ns, U32_MAX);
+    /* ewma with 1/8 weight, capped so one stuck response does not make every waiter spin */
+    bdb_slot_stats[hwSlot].ewma_ns += ((int32_t)min_t(uint64, ns, BDB_SPIN_MAX_NS) - (int32_t)bdb_slot_stats[hwSlot].ewma_ns) / 8;
+}
+
+/*
+ * Busy-wait for about twice the usual response time of the slot, then sleep until the response
+ * interrupt (bdb_irq) or for BDB_SLEEP_US at a time, so a slow or absent SFM does not burn a CPU
+ * for the whole BDB_TIMEOUT.
+ */
 static int bdbWaitForResult(int hwSlot, int * flushes)
     {
     void * bdb_regs = IOCTL_BASE + IOCTL_BDB_REGS_OFFSET;
-    uint32 ctrl, bdbSlot;
+    uint32 ctrl;
     uint64 nsecs = ktime_get_raw_ns();
     uint64 now = nsecs;
     uint64 timeout = BDB_TIMEOUT;
+    uint64 spin = clamp_t(uint64, 2ULL * bdb_slot_stats[hwSlot].ewma_ns, BDB_SPIN_MIN_NS, BDB_SPIN_MAX_NS);
     bool flushed = false;
 
     while (true)                                                   
     {   
-        uint64 old_now = now;                                                        
         now = ktime_get_raw_ns();
 
-        ctrl = read32_be(bdb_regs + BDB_CTRL_REG_OFF);
-        bdbSlot = bdb_parallel ? ((ctrl & M_GEN_CONFIG_BDB_RESP_SLOT) >> S_GEN_CONFIG_BDB_RESP_SLOT) : hwSlot;
-
-        if ((ctrl & B_GEN_CONFIG_P_READ_DONE) && (hwSlot == bdbSlot))
+        if (bdbResultReady(hwSlot, &ctrl))
         {
-            if (!flushed && max_wait_time < (old_now-nsecs))
-                max_wait_time = (old_now-nsecs);
+            if (!flushed)
+                bdbLatencyRecord(hwSlot, now - nsecs);
 
             return (ctrl & (B_GEN_CONFIG_RESP_ERROR|B_GEN_CONFIG_P_READ_ERR)) ? LUBDE_FAIL : LUBDE_SUCCESS;
         }
 
-                if ((now-nsecs) < timeout)
+        if ((now-nsecs) < timeout)
         {
-            ndelay(32*10);
+            if ((now-nsecs) < spin)
+                ndelay(32*10);
+            else
+            {
+                bdb_slot_stats[hwSlot].sleeps++;
+                if (bdb_irq >= 0)
+                    wait_event_timeout(bdb_wq, bdbResultReady(hwSlot, &ctrl), usecs_to_jiffies(BDB_SLEEP_US) + 1);
+                else
+                    usleep_range(BDB_SLEEP_US, 2*BDB_SLEEP_US);
+            }
             continue;
         }
 
@@ -432,6 +568,40 @@ static int bdbWaitForResult(int hwSlot, int * flushes)
     return LUBDE_FAIL;
 }
 
+static irqreturn_t bdb_isr(int irq, void * dev_id)
+{
+    void * bdb_regs = IOCTL_BASE + IOCTL_BDB_REGS_OFFSET;
+
+    if (!_cpuctl_base_addr || !(read32_be(bdb_regs + BDB_CTRL_REG_OFF) & B_GEN_CONFIG_P_READ_DONE))
+        return IRQ_NONE;
+
+    bdb_irqs++;
+    wake_up_all(&bdb_wq);
+
+    return IRQ_HANDLED;
+}
+
+static void bdb_setup(void)
+{
+    int i;
+
+    for (i=0; i<=MAX_HWSLOT; i++)
+        mutex_init(&bdb_slot_lock[i]);
+
+    if (bdb_irq >= 0 && request_irq(bdb_irq, bdb_isr, IRQF_SHARED, KERNEL_MOD_NAME, bdb_slot_stats))
+    {
+        printk(KWARN "can't get irq %d, polling for BDB responses\n", bdb_irq);
+        bdb_irq = -1;
+    }
+}
+
+static void bdb_teardown(void)
+{
+    if (bdb_irq >= 0)
+        free_irq(bdb_irq, bdb_slot_stats);
+    iproc_trace_ctl("trace clear");
+}
+
 int bdbReadWordRaw(uint32 hwSlot, uint32 addr, int wsize, void * ret)
 {
     void * bdb_regs   = IOCTL_BASE + IOCTL_BDB_REGS_OFFSET;
@@ -547,7 +717,7 @@ int bdbWriteWordRaw(uint32 hwSlot, uint32 addr, int wsize, void * data)
             bdb_fifo_depth_wait++;
 
             mutex_unlock(&bdb_lock);
-            ndelay(32*10);
+            usleep_range(1, BDB_SLEEP_US);
             mutex_lock(&bdb_lock);
         }
 
@@ -617,12 +787,354 @@ int bdbWrite32(int d, uint32 addr, uint32 data)
     return(bdbWriteWord(DEV_TO_RAMON_HWSLOT(d), addr, 4, &data));
 }
 
+/*
+ * Vectored BDB access. The whole batch runs under one bdb_lock hold (after the slot locks, taken in
+ * ascending order, in parallel mode). Without parallel mode writes are posted, so they are streamed
+ * into the BDB FIFO against a credit count and the FIFO depth is only re-read when the credits run
+ * out; reads still wait for their posted result one at a time.
+ */
+static uint32 bdbCtrlVal(uint32 hwSlot, uint32 addr)
+{
+    return BDB_BITS_DEFAULT | B_GEN_CONFIG_P_READ | (hwSlot << S_GEN_CONFIG_BDB_SLOT) | ((addr >> 27) << S_GEN_CONFIG_BDB_3127);
+}
+
+static bool bdbBatchResolve(nokia_bdb_op_t * op, uint32 * hwSlot, uint32 * addr)
+{
+    switch (op->op)
+    {
+    case BDB_OP_READ:
+    case BDB_OP_WRITE:
+        *hwSlot = op->slot;
+        *addr = op->addr;
+        return (op->slot <= MAX_HWSLOT);
+    case BDB_OP_BDE_READ:
+    case BDB_OP_BDE_WRITE:
+        if (!IS_NOKIA_DEV(op->dev))
+            return false;
+        *hwSlot = DEV_TO_RAMON_HWSLOT(op->dev);
+        *addr = nokia_dev[op->dev].hw_main_baseaddr + op->addr;
+        return (*hwSlot <= MAX_HWSLOT);
+    default:
+        return false;
+    }
+}
+
+static int bdbBatchRead32(uint32 hwSlot, uint32 addr, uint32 * ret)
+{
+    void * bdb_regs   = IOCTL_BASE + IOCTL_BDB_REGS_OFFSET;
+    void * bdb_window = IOCTL_BASE + IOCTL_BDB_WINDOW_OFFSET;
+    int rc, flushes = 0;
+
+    bdbFlushRead(hwSlot, true);
+    write32_be(bdb_regs + BDB_CTRL_REG_OFF, bdbCtrlVal(hwSlot, addr));
+    *ret = *(volatile uint32_t *)(bdb_window + (addr & ((1<<27)-1)));
+
+    rc = bdbWaitForResult(hwSlot, &flushes);
+    if (rc == LUBDE_SUCCESS)
+        *ret = *(volatile uint32_t *)(bdb_regs + BDB_POSTED_READ_REG_OFF + (addr & 3));
+
+    bdb_read_flushes += flushes;
+    return rc;
+}
+
+static int bdbBatchWrite32Acked(uint32 hwSlot, uint32 addr, uint32 data)
+{
+    void * bdb_regs   = IOCTL_BASE + IOCTL_BDB_REGS_OFFSET;
+    void * bdb_window = IOCTL_BASE + IOCTL_BDB_WINDOW_OFFSET;
+    int rc, flushes = 0;
+
+    bdbFlushRead(hwSlot, false);
+    while (bdbFifoDepth(hwSlot) >= (BDB_MIN_FIFO_DEPTH+4))
+    {
+        bdb_fifo_depth_wait++;
+        ndelay(32*10);
+    }
+    write32_be(bdb_regs + BDB_CTRL_REG_OFF, bdbCtrlVal(hwSlot, addr));
+    *(volatile uint32_t *)(bdb_window + (addr & ((1<<27)-1))) = data;
+
+    rc = bdbWaitForResult(hwSlot, &flushes);
+    read32(bdb_regs + BDB_POSTED_READ_REG_OFF);
+    bdb_write_flushes += flushes;
+
+    if (addr == A64_XRS_SCRATCHPAD && rc == LUBDE_FAIL)
+    {
+        bdb_sac_write_fail++;
+        rc = LUBDE_SUCCESS;
+    }
+    return rc;
+}
+
+static uint32 bdbRunBatch(nokia_bdb_op_t * ops, uint32 count)
+{
+    void * bdb_regs   = IOCTL_BASE + IOCTL_BDB_REGS_OFFSET;
+    void * bdb_window = IOCTL_BASE + IOCTL_BDB_WINDOW_OFFSET;
+    unsigned long slots = 0;
+    uint32 i, hwSlot, addr, present, depth;
+    uint32 last_ctrl = 0, credits = 0, failed = 0;
+    int rc, retries;
+
+    for (i = 0; i < count; i++)
+        if (bdbBatchResolve(&ops[i], &hwSlot, &addr))
+            slots |= 1UL << hwSlot;
+
+    if (bdb_parallel)
+        for_each_set_bit(hwSlot, &slots, MAX_HWSLOT+1)
+            mutex_lock(&bdb_slot_lock[hwSlot]);
+
+    mutex_lock(&bdb_lock);
+
+    present = bdbSignalReg();
+
+    for (i = 0; i < count; i++)
+    {
+        nokia_bdb_op_t * op = &ops[i];
+        bool read = (op->op == BDB_OP_READ || op->op == BDB_OP_BDE_READ);
+
+        rc = LUBDE_FAIL;
+        if (!bdbBatchResolve(op, &hwSlot, &addr) || !(present & (1U << hwSlot)))
+        {
+            op->rc = rc;
+            failed++;
+            continue;
+        }
+
+        if (read)
+        {
+            /* the read rewrites the control register and may flush the response */
+            last_ctrl = 0;
+            for (retries = max_retries; retries; retries--)
+            {
+                rc = bdbBatchRead32(hwSlot, addr, &op->value);
+                if (rc == LUBDE_SUCCESS)
+                    break;
+                bdb_read_retries++;
+            }
+            if (rc == LUBDE_FAIL)
+            {
+                bdb_read_retry_failures++;
+                bdb_read_fail++;
+            }
+            (op->op == BDB_OP_READ) ? nok_read++ : bde_read++;
+        }
+        else if (bdb_parallel)
+        {
+            for (retries = max_retries; retries; retries--)
+            {
+                rc = bdbBatchWrite32Acked(hwSlot, addr, op->value);
+                if (rc == LUBDE_SUCCESS)
+                    break;
+                bdb_write_retries++;
+            }
+            if (rc == LUBDE_FAIL)
+            {
+                bdb_write_retry_failures++;
+                bdb_write_fail++;
+            }
+            (op->op == BDB_OP_WRITE) ? nok_write++ : bde_write++;
+        }
+        else
+        {
+            uint32 ctrl = bdbCtrlVal(hwSlot, addr);
+
+            if (credits == 0)
+            {
+                bdbFlushRead(hwSlot, false);
+                while ((depth = bdbFifoDepth(hwSlot)) >= (BDB_MIN_FIFO_DEPTH+4))
+                    bdb_fifo_depth_wait++;
+                /* be conservative about how many FIFO entries one 32-bit write takes */
+                credits = ((BDB_MIN_FIFO_DEPTH+4) - depth + 1) / 2;
+            }
+            if (ctrl != last_ctrl)
+            {
+                write32_be(bdb_regs + BDB_CTRL_REG_OFF, ctrl);
+                last_ctrl = ctrl;
+            }
+            *(volatile uint32_t *)(bdb_window + (addr & ((1<<27)-1))) = op->value;
+            credits--;
+            rc = LUBDE_SUCCESS;
+            (op->op == BDB_OP_WRITE) ? nok_write++ : bde_write++;
+        }
+
+        op->rc = rc;
+        if (rc != LUBDE_SUCCESS)
+            failed++;
+    }
+
+    mutex_unlock(&bdb_lock);
+
+    if (bdb_parallel)
+        for_each_set_bit(hwSlot, &slots, MAX_HWSLOT+1)
+            mutex_unlock(&bdb_slot_lock[hwSlot]);
+
+    bdb_batches++;
+    bdb_batch_ops += count;
+
+    return failed;
+}
+
+static int bdbBatch(uint64_t uptr, uint32 count, uint32 * failed)
+{
+    nokia_bdb_op_t * ops;
+    size_t size = count * sizeof(nokia_bdb_op_t);
+    int rc = 0;
+
+    if (!_cpuctl_base_addr || count == 0 || count > BDB_BATCH_MAX)
+        return -EINVAL;
+
+    ops = kvmalloc(size, GFP_KERNEL);
+    if (!ops)
+        return -ENOMEM;
+
+    if (copy_from_user(ops, (void __user *)(uintptr_t)uptr, size))
+        rc = -EFAULT;
+    else
+    {
+        *failed = bdbRunBatch(ops, count);
+        if (copy_to_user((void __user *)(uintptr_t)uptr, ops, size))
+            rc = -EFAULT;
+    }
+
+    kvfree(ops);
+    return rc;
+}
+
 #define BAR0_PAXB_IMAP0_7                       (0x2c1c)
+#define BAR0_PAXB_IMAP0(_w)                     (0x2c00 + 4*(_w))
+
+/*
+ * Trace mode: "echo trace start > /proc/nokia-kernel-bdb" records every iProc access, "trace stop"
+ * ends it and "trace clear" drops it. While a trace is held the /proc dump replays it against an
+ * LRU of 1..IPROC_SUBWIN_MAX subwindows per device and shows the IMAP writes each size would need.
+ */
+static struct {
+    uint8_t dev;
+    uint32_t addr;
+} * iproc_trace;
+static uint32 iproc_trace_len;
+static bool iproc_trace_on;
+static DEFINE_MUTEX(iproc_trace_lock);
+
+static void iproc_trace_add(int d, uint32 addr)
+{
+    if (!iproc_trace_on)
+        return;
+    mutex_lock(&iproc_trace_lock);
+    if (iproc_trace && iproc_trace_len < IPROC_TRACE_MAX)
+    {
+        iproc_trace[iproc_trace_len].dev = d;
+        iproc_trace[iproc_trace_len].addr = addr;
+        iproc_trace_len++;
+    }
+    mutex_unlock(&iproc_trace_lock);
+}
+
+static void iproc_trace_ctl(const char *cmd)
+{
+    mutex_lock(&iproc_trace_lock);
+    if (!strcmp(cmd, "trace start"))
+    {
+        if (!iproc_trace)
+            iproc_trace = kvmalloc_array(IPROC_TRACE_MAX, sizeof(*iproc_trace), GFP_KERNEL);
+        iproc_trace_len = 0;
+        iproc_trace_on = (iproc_trace != NULL);
+    }
+    else if (!strcmp(cmd, "trace stop"))
+    {
+        iproc_trace_on = false;
+    }
+    else if (!strcmp(cmd, "trace clear"))
+    {
+        iproc_trace_on = false;
+        kvfree(iproc_trace);
+        iproc_trace = NULL;
+        iproc_trace_len = 0;
+    }
+    mutex_unlock(&iproc_trace_lock);
+}
+
+static uint32 iproc_trace_replay(uint32 nwin)
+{
+    static uint32 base[MAX_NOKIA_RAMONS][IPROC_SUBWIN_MAX];
+    static uint32 used[MAX_NOKIA_RAMONS][IPROC_SUBWIN_MAX];
+    uint32 t, i, lru, writes = 0, clock = 0;
+
+    memset(base, 0xff, sizeof(base));
+    memset(used, 0, sizeof(used));
+    for (t = 0; t < iproc_trace_len; t++)
+    {
+        uint32 d = iproc_trace[t].dev, subwin_base = iproc_trace[t].addr & ~0xfff;
+
+        if ((subwin_base == 0x10231000) || (subwin_base == 0x18013000))
+            continue;
+        for (i = 0, lru = 0; i < nwin; i++)
+        {
+            if (base[d][i] == subwin_base)
+                break;
+            if (used[d][i] < used[d][lru])
+                lru = i;
+        }
+        if (i == nwin)
+        {
+            i = lru;
+            base[d][i] = subwin_base;
+            writes++;
+        }
+        used[d][i] = ++clock;
+    }
+    return writes;
+}
+
+static void iproc_trace_dump(struct seq_file *m)
+{
+    uint32 nwin;
+
+    mutex_lock(&iproc_trace_lock);
+    if (iproc_trace_len)
+    {
+        seq_printf(m, " iproc trace: %u accesses%s\n", iproc_trace_len, iproc_trace_on ? " (recording)" : "");
+        for (nwin = 1; nwin <= IPROC_SUBWIN_MAX; nwin++)
+            seq_printf(m, "\t%u subwin%s: %u IMAP writes\n", nwin, nwin > 1 ? "s" : " ", iproc_trace_replay(nwin));
+    }
+    mutex_unlock(&iproc_trace_lock);
+}
+
+/*
+ * iProc accesses go through BAR0 subwindows whose PAXB IMAP registers select a 4K page of the iProc
+ * address space. Each device keeps an LRU set of the subwindows in iproc_subwins, so alternating
+ * between a few hot pages (CMIC, SBUS, counters) does not cost a remote IMAP write per access.
+ */
+static void iproc_subwin_init(int d)
+{
+    int w;
+
+    nokia_dev[d].nsubwin = 0;
+    nokia_dev[d].subwin_clock = 0;
+    nokia_dev[d].subwin_hit = nokia_dev[d].subwin_miss = nokia_dev[d].subwin_evict = 0;
+    for (w = 0; w < IPROC_SUBWIN_MAX; w++)
+    {
+        if (!(iproc_subwins & ~IPROC_SUBWIN_RESERVED & (1 << w)))
+            continue;
+        nokia_dev[d].subwin[nokia_dev[d].nsubwin].base = IPROC_SUBWIN_NONE;
+        nokia_dev[d].subwin[nokia_dev[d].nsubwin].win = w;
+        nokia_dev[d].subwin[nokia_dev[d].nsubwin].used = 0;
+        nokia_dev[d].nsubwin++;
+    }
+    if (nokia_dev[d].nsubwin == 0)
+    {
+        nokia_dev[d].subwin[0].base = IPROC_SUBWIN_NONE;
+        nokia_dev[d].subwin[0].win = 7;
+        nokia_dev[d].subwin[0].used = 0;
+        nokia_dev[d].nsubwin = 1;
+    }
+}
 
 static uint32 iproc_map_addr(int d, unsigned int addr)
 {
     uint32 data, subwin_base =(addr & ~0xfff);
     uint32 iprocBase = nokia_dev[d].hw_iproc_baseaddr;
+    uint32 i, lru = 0;
+
+    iproc_trace_add(d, addr);
 
     if ((subwin_base == 0x10231000) || (subwin_base == 0x18013000)) 
     {
@@ -630,16 +1142,32 @@ static uint32 iproc_map_addr(int d, unsigned int addr)
     }
     else 
     {
-        if (nokia_dev[d].last_subwin_base != subwin_base)
+        for (i = 0; i < nokia_dev[d].nsubwin; i++)
         {
-            bdbWrite32(d, iprocBase + BAR0_PAXB_IMAP0_7, subwin_base | 1);
-            bdbRead32(d, iprocBase + BAR0_PAXB_IMAP0_7, &data);
-            nokia_dev[d].last_subwin_base = subwin_base;
+            if (nokia_dev[d].subwin[i].base == subwin_base)
+                break;
+            if (nokia_dev[d].subwin[i].used < nokia_dev[d].subwin[lru].used)
+                lru = i;
         }
-        else
+
+        if (i < nokia_dev[d].nsubwin)
+        {
             iproc_cache_hit++;
+            nokia_dev[d].subwin_hit++;
+        }
+        else
+        {
+            i = lru;
+            nokia_dev[d].subwin_miss++;
+            if (nokia_dev[d].subwin[i].base != IPROC_SUBWIN_NONE)
+                nokia_dev[d].subwin_evict++;
+            bdbWrite32(d, iprocBase + BAR0_PAXB_IMAP0(nokia_dev[d].subwin[i].win), subwin_base | 1);
+            bdbRead32(d, iprocBase + BAR0_PAXB_IMAP0(nokia_dev[d].subwin[i].win), &data);
+            nokia_dev[d].subwin[i].base = subwin_base;
+        }
+        nokia_dev[d].subwin[i].used = ++nokia_dev[d].subwin_clock;
 
-        addr = 0x7000 + (addr & 0xfff);
+        addr = (nokia_dev[d].subwin[i].win << 12) + (addr & 0xfff);
     }
 
     return(iprocBase + addr);
@@ -648,7 +1176,7 @@ static uint32 iproc_map_addr(int d, unsigned int addr)
 static int nokia_ioctl(unsigned int cmd, unsigned long arg)
 {
     lubde_ioctl_t io;
-    int i, rc = 0;
+    int rc = 0;
 
     if (copy_from_user(&io, (void *)arg, sizeof(io))) 
         return -EFAULT;
@@ -728,9 +1256,6 @@ static int nokia_ioctl(unsigned int cmd, unsigned long arg)
         printk(KINFO "BDB (new) init @ %llx sz %x parallel %x\n", io.p0, io.d0, io.d1);
         _cpuctl_base_addr = ioremap(io.p0, io.d0);
         bdb_parallel = !!io.d1;
-        if (bdb_parallel)
-            for (i=0; i<=MAX_HWSLOT; i++)
-                mutex_init(&bdb_slot_lock[i]);
         break;
     case LUBDE_NOKIA_OP_BDB_READ:
         io.rc = bdbReadWord(io.dev, io.d0, io.d1, io.dx.buf);
@@ -750,6 +1275,13 @@ static int nokia_ioctl(unsigned int cmd, unsigned long arg)
             msgCount--;
         }
         break;
+    case LUBDE_NOKIA_OP_BDB_BATCH:
+        io.d1 = 0;
+        rc = bdbBatch(io.p0, io.d0, &io.d1);
+        if (rc)
+            return rc;
+        io.rc = io.d1 ? LUBDE_FAIL : LUBDE_SUCCESS;
+        break;
     case LUBDE_NOKIA_OP_ADD_UNIT:
         if (!VALID_DEVICE(io.dev))
             return -EINVAL;
@@ -763,7 +1295,7 @@ static int nokia_ioctl(unsigned int cmd, unsigned long arg)
             nokia_dev[io.dev].hw_main_baseaddr = io.dx.dw[0];
             nokia_dev[io.dev].hw_iproc_baseaddr = io.dx.dw[1];
             nokia_dev[io.dev].hw_slot = io.dx.dw[2];
-            nokia_dev[io.dev].last_subwin_base = -1;
+            iproc_subwin_init(io.dev);
             mutex_init(&nokia_dev[io.dev].iproc_lock);
             printk(KINFO "Create Nokia dev %d rev=%x sfmnum=%d hwslot=%d base1=%x base2=%x\n", io.dev, nokia_dev[io.dev].device_rev, nokia_dev[io.dev].sfm_num, nokia_dev[io.dev].hw_slot, nokia_dev[io.dev].hw_main_baseaddr, nokia_dev[io.dev].hw_iproc_baseaddr);
         }
@@ -23,12 +23,47 @@ try:
     import os
     import sys
     import inspect
+    import ctypes
+    import struct
 
 
 except ImportError as e:
     raise ImportError(str(e) + "- required module not found")
 logger = Logger()
 
+# futex-based ownership handoff from chassis/mdipc; without it msg_send sleep-polls for the response.
+# The library ships in the device directory, which pmon mounts as /usr/share/sonic/platform.
+MDIPC_LIB_NAME = 'libnokia_mdipc.so'
+PLATFORM_ROOT_DOCKER = '/usr/share/sonic/platform'
+
+
+def _mdipc_lib_path():
+    try:
+        platform_dir = device_info.get_path_to_platform_dir()
+    except Exception:
+        platform_dir = None
+    return os.path.join(platform_dir or PLATFORM_ROOT_DOCKER, MDIPC_LIB_NAME)
+
+
+try:
+    MDIPC_LIB = ctypes.CDLL(_mdipc_lib_path())
+    MDIPC_LIB.mdipc_wait_own.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_uint32]
+    MDIPC_LIB.mdipc_wait_own.restype = ctypes.c_int
+    MDIPC_LIB.mdipc_set_own.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+    MDIPC_LIB.mdipc_set_own.restype = None
+    MDIPC_LIB.mdipc_cache_open.argtypes = [ctypes.c_char_p]
+    MDIPC_LIB.mdipc_cache_gen.argtypes = [ctypes.c_uint32]
+    MDIPC_LIB.mdipc_cache_gen.restype = ctypes.c_uint32
+    MDIPC_LIB.mdipc_cache_invalidate.argtypes = [ctypes.c_uint32]
+    MDIPC_LIB.mdipc_cache_invalidate.restype = None
+    MDIPC_LIB.mdipc_cache_lookup.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_char_p, ctypes.c_uint32]
+    MDIPC_LIB.mdipc_cache_insert.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32, ctypes.c_char_p, ctypes.c_uint32, ctypes.c_uint32]
+    MDIPC_LIB.mdipc_cache_insert.restype = None
+    MDIPC_LIB.mdipc_cache_stats.argtypes = [ctypes.POINTER(ctypes.c_uint64), ctypes.c_uint32]
+    MDIPC_LIB.mdipc_cache_stats.restype = None
+except OSError:
+    MDIPC_LIB = None
+
 READ_TYPE = 0
 KEY_OFFSET = 1
 KEY_WIDTH = 2
@@ -58,9 +93,87 @@ MDIPC_READ  = 0
 MDIPC_WRITE = 1
 MDIPC_PRESENCE = 2
 MDIPC_WRITE_CDB_CHAIN = 3
+MDIPC_READ_MULTI = 4
 MDIPC_RSP_SUCCESS = 0
 MDIPC_RSP_FAIL = 1
 MDIPC_RSP_NOTPRESENT = 2
+MDIPC_TIMEOUT_US = 3000000
+
+# MDIPC_READ_MULTI: page is the descriptor count and num_bytes the total length. The data area holds
+# (bank, page, offset, num_bytes, status) descriptors followed by the bytes read for each in order.
+MDIPC_HDR_SIZE = 36
+MDIPC_DESC_FMT = '=5I'
+MDIPC_DESC_SIZE = struct.calcsize(MDIPC_DESC_FMT)
+MDIPC_MULTI_MAX_DESC = 32
+MDIPC_DESC_UNSERVED = 0xFFFFFFFF
+
+# Page halves shared by every process through the chassis/mdipc page cache. TTL class per half in ms,
+# CACHE_TTL_STATIC keeps identity pages until the module is removed or written.
+MDIPC_CACHE_NAME = '/var/run/redis/MDIPC_cache'
+MDIPC_CACHE_STATS = ['hits', 'misses', 'expired', 'inserts', 'evictions', 'invalidations', 'busy']
+CACHE_TTL_STATIC = 0
+CACHE_TTL_DOM = 500
+CACHE_TTL_DEFAULT = 2000
+
+
+def shared_cache_ttl(page, offset):
+    if (page == 0):
+        return CACHE_TTL_DOM if (offset < 128) else CACHE_TTL_STATIC
+    if (page == 1) or (page == 2):
+        return CACHE_TTL_STATIC
+    if (page == 0x11):
+        return CACHE_TTL_DOM
+    return CACHE_TTL_DEFAULT
+
+
+class SharedPageCache():
+    enabled = False
+    reported = False
+
+    @staticmethod
+    def open():
+        if (MDIPC_LIB is None):
+            # said once per process, so a pmon that cannot share the cache shows up in syslog
+            if (SharedPageCache.reported is False):
+                logger.log_warning("SharedPageCache: {} not loaded, caching per process only".format(_mdipc_lib_path()))
+                SharedPageCache.reported = True
+            return
+        if (SharedPageCache.enabled is False):
+            SharedPageCache.enabled = (MDIPC_LIB.mdipc_cache_open(MDIPC_CACHE_NAME.encode()) == 0)
+            if (SharedPageCache.enabled is False) and (SharedPageCache.reported is False):
+                logger.log_warning("SharedPageCache: {} unavailable, caching per process only".format(MDIPC_CACHE_NAME))
+                SharedPageCache.reported = True
+
+    @staticmethod
+    def gen(port):
+        return MDIPC_LIB.mdipc_cache_gen(port) if SharedPageCache.enabled else 0
+
+    @staticmethod
+    def invalidate(port):
+        if SharedPageCache.enabled:
+            MDIPC_LIB.mdipc_cache_invalidate(port)
+
+    @staticmethod
+    def lookup(port, page, offset):
+        if (SharedPageCache.enabled is False):
+            return None
+        buf = ctypes.create_string_buffer(128)
+        if (MDIPC_LIB.mdipc_cache_lookup(port, 0, page, offset, shared_cache_ttl(page, offset), buf, 128) != 0):
+            return None
+        return bytearray(buf.raw)
+
+    @staticmethod
+    def insert(port, page, offset, data, gen):
+        if SharedPageCache.enabled and (data is not None) and (len(data) == 128):
+            MDIPC_LIB.mdipc_cache_insert(port, 0, page, offset, bytes(data), 128, gen)
+
+    @staticmethod
+    def stats():
+        if (SharedPageCache.enabled is False):
+            return None
+        stats = (ctypes.c_uint64 * len(MDIPC_CACHE_STATS))()
+        MDIPC_LIB.mdipc_cache_stats(stats, len(MDIPC_CACHE_STATS))
+        return dict(zip(MDIPC_CACHE_STATS, stats))
 
 
 class MDIPC_CHAN():
@@ -84,6 +197,9 @@ class MDIPC_CHAN():
         try:
            self.fd = os.open(self.name, os.O_RDWR | os.O_NOFOLLOW | os.O_CLOEXEC)
            self.mm = mmap.mmap(self.fd, 0)
+           self.own_addr = None
+           if MDIPC_LIB is not None:
+              self.own_addr = ctypes.addressof(ctypes.c_uint32.from_buffer(self.mm))
            logger.log_warning("MDIPC_CHAN: file {} size {} fd {} successfully opened".format(self.name, self.mm.size(), self.fd))
 
         except os.error:
@@ -98,6 +214,8 @@ class MDIPC_CHAN():
 
 class MDIPC():
     channels = []
+    # None until the NDK has answered an MDIPC_READ_MULTI
+    multi_supported = None
     initialized = False
     lock_held = False
     signals_initialized = False
@@ -112,6 +230,7 @@ class MDIPC():
             chan = MDIPC_CHAN(x)
             MDIPC.channels.append(chan)
 
+        SharedPageCache.open()
         MDIPC.initialized = True
         self.stat_no_channel_avail = 0
         self.Tmutex = threading.RLock()
@@ -157,6 +276,7 @@ class MDIPC():
             logger.log_warning("MDIPC ({} {}) channel {} local: msgs {} success {} fail {} notpresent {} unknown {} minrspwait {} maxrspwait {} long_rsp {} timeouts {} already_in_use {}".format(pid, tid, chan.index, chan.stat_num_msgs,
                 chan.stat_num_success, chan.stat_num_fail, chan.stat_num_notpresent, chan.stat_num_unknown, min_rsp_wait, chan.stat_max_rsp_wait, chan.stat_long_rsp, chan.stat_num_timeouts, chan.stat_already_in_use))
         logger.log_warning("MDIPC ({} {}) no_channel_avail {} lock_held {}".format(pid, tid, self.stat_no_channel_avail, self.lock_held))
+        logger.log_warning("MDIPC ({} {}) shared page cache {}".format(pid, tid, SharedPageCache.stats()))
 
     def dump_stats_signal(self, signum, frame):
         logger.log_warning("MDIPC got USR1 signal")
@@ -238,6 +358,32 @@ class MDIPC():
         # signal.signal(signum, self.sighandlers[signum])
         sys.exit()
 
+    def handoff(self, index, msg):
+        # over it goes 
+        own_addr = MDIPC.channels[index].own_addr
+        if (own_addr is not None):
+            MDIPC_LIB.mdipc_set_own(own_addr, MDIPC_OWN_NDK)
+        else:
+            msg[0:4] = MDIPC_OWN_NDK.to_bytes(4, sys.byteorder)
+        handoff_time = int(time.monotonic_ns() / 1000)
+        MDIPC.channels[index].stat_num_msgs += 1
+
+        # wait for response now...
+        timed_out = False
+        sleep_time = .001           # 1ms
+        sleep_iters = 0
+        if (own_addr is not None):
+            # releases the GIL while it waits
+            timed_out = (MDIPC_LIB.mdipc_wait_own(own_addr, MDIPC_OWN_NOS_RSP, MDIPC_TIMEOUT_US) != 0)
+        while (own_addr is None) and (timed_out != True):
+            time.sleep(sleep_time)
+            if (msg[0:4] == MDIPC_OWN_NOS_RSP.to_bytes(4, sys.byteorder)):
+               break
+            sleep_iters+=1
+            if (sleep_iters > 3000):
+               timed_out = True       
+        return timed_out, handoff_time, sleep_iters
+
     def msg_send(self, op, hw_port_id, page, offset, num_bytes, data=None):
 
         start_time = int(time.monotonic_ns() / 1000)
@@ -283,22 +429,7 @@ class MDIPC():
             self.free_channel(index)
             return MDIPC_RSP_FAIL, None
 
-        # over it goes 
-        msg[0:4] = MDIPC_OWN_NDK.to_bytes(4, sys.byteorder)
-        handoff_time = int(time.monotonic_ns() / 1000)
-        MDIPC.channels[index].stat_num_msgs += 1
-
-        # wait for response now...
-        timed_out = False
-        sleep_time = .001           # 1ms
-        sleep_iters = 0
-        while (timed_out != True):
-            time.sleep(sleep_time)
-            if (msg[0:4] == MDIPC_OWN_NOS_RSP.to_bytes(4, sys.byteorder)):
-               break
-            sleep_iters+=1
-            if (sleep_iters > 3000):
-               timed_out = True       
+        timed_out, handoff_time, sleep_iters = self.handoff(index, msg)
 
         done_time = int(time.monotonic_ns() / 1000)
         delta_time = done_time - handoff_time
@@ -343,6 +474,87 @@ class MDIPC():
         self.free_channel(index)
         return status, ret_data
 
+    def msg_send_multi(self, hw_port_id, descs):
+        """
+        Read a list of (bank, page, offset, num_bytes) descriptors in one round trip.
+        Returns the message status and a (status, data) pair per descriptor, or None
+        in place of the list when the request did not get a per-descriptor answer.
+        Descriptors past what fits the channel are left MDIPC_DESC_UNSERVED for the
+        caller's single page reads.
+        """
+        if (MDIPC.multi_supported is False) or (len(descs) == 0) or (len(descs) > MDIPC_MULTI_MAX_DESC):
+            return MDIPC_RSP_FAIL, None
+
+        index = self.obtain_channel()
+        if (index is None):
+            self.stat_no_channel_avail += 1
+            logger.log_error("msg_send_multi ({} {}): no free channel available!".format(os.getpid(), threading.get_native_id()))
+            return MDIPC_RSP_FAIL, None
+
+        chan = MDIPC.channels[index]
+        space = chan.mm.size() - MDIPC_HDR_SIZE
+        fit = 0
+        for desc in descs:
+            space -= MDIPC_DESC_SIZE + desc[3]
+            if (space < 0):
+                break
+            fit += 1
+        if (fit == 0):
+            self.free_channel(index)
+            return MDIPC_RSP_FAIL, None
+        unserved = [(MDIPC_DESC_UNSERVED, None)] * (len(descs) - fit)
+        descs = descs[:fit]
+        table = len(descs) * MDIPC_DESC_SIZE
+        num_bytes = sum(desc[3] for desc in descs)
+
+        msg = memoryview(chan.mm)
+        msgID = int.from_bytes(msg[4:8],sys.byteorder) + 1
+        msg[4:8] = msgID.to_bytes(4, sys.byteorder)
+        msg[8:12] = threading.get_native_id().to_bytes(4, sys.byteorder)
+        msg[12:16] = hw_port_id.to_bytes(4, sys.byteorder)
+        msg[16:20] = MDIPC_READ_MULTI.to_bytes(4, sys.byteorder)
+        msg[20:24] = len(descs).to_bytes(4, sys.byteorder)
+        msg[24:28] = (0).to_bytes(4, sys.byteorder)
+        msg[28:32] = num_bytes.to_bytes(4, sys.byteorder)
+        msg[32:36] = msgID.to_bytes(4, sys.byteorder)       # status validation check
+        pos = MDIPC_HDR_SIZE
+        for bank, page, offset, length in descs:
+            msg[pos:pos+MDIPC_DESC_SIZE] = struct.pack(MDIPC_DESC_FMT, bank, page, offset, length, MDIPC_DESC_UNSERVED)
+            pos += MDIPC_DESC_SIZE
+
+        timed_out, handoff_time, sleep_iters = self.handoff(index, msg)
+        if (timed_out == True):
+            chan.stat_num_timeouts += 1
+            logger.log_error("msg_send_multi ({}): timeout for hw_port_id {} with {} descriptors".format(index, hw_port_id, len(descs)))
+            self.free_channel(index)
+            return MDIPC_RSP_FAIL, None
+
+        status = int.from_bytes(msg[32:36],sys.byteorder)
+        results = []
+        pos = MDIPC_HDR_SIZE + table
+        for i, desc in enumerate(descs):
+            desc_status = struct.unpack_from(MDIPC_DESC_FMT, msg, MDIPC_HDR_SIZE + i * MDIPC_DESC_SIZE)[4]
+            results.append((desc_status, bytearray(msg[pos:pos+desc[3]]) if (desc_status == MDIPC_RSP_SUCCESS) else None))
+            pos += desc[3]
+        self.free_channel(index)
+
+        if all(result[0] == MDIPC_DESC_UNSERVED for result in results):
+            if (status == MDIPC_RSP_FAIL) and (MDIPC.multi_supported is None):
+                MDIPC.multi_supported = False
+                logger.log_warning("msg_send_multi: NDK does not serve MDIPC_READ_MULTI, using single page reads")
+            if (status == MDIPC_RSP_NOTPRESENT):
+                chan.stat_num_notpresent += 1
+            else:
+                chan.stat_num_fail += 1
+            return status, None
+
+        MDIPC.multi_supported = True
+        if (status == MDIPC_RSP_SUCCESS):
+            chan.stat_num_success += 1
+        else:
+            chan.stat_num_fail += 1
+        return status, results + unserved
+
 
 # caching modes
 CACHE_NORMAL  = 0
@@ -405,6 +617,11 @@ class CachePage():
         self.pending = threading.get_native_id()
         self.Tmutex.release()
 
+        chunks = self.page_chunks()
+        if (self.shared_fill(chunks) == True):
+            return True
+        gen = SharedPageCache.gen(self.sfp_index)
+
         offset = 128
         num_bytes = 128
 
@@ -453,6 +670,7 @@ class CachePage():
         if (self.page_num != 0):
             self.cache_page_data = data
 
+        self.shared_publish(chunks, gen)
         self.pending = 0
         
         if (verbose):
@@ -465,6 +683,48 @@ class CachePage():
            self.cache_page0_admin = False
         self.cache_page_valid = False
 
+    # used by Sfp.cache_pages_multi to fill several pages from one MDIPC_READ_MULTI
+    def page_claim(self):
+        with self.Tmutex:
+            if (self.pending != 0):
+                return False
+            self.pending = threading.get_native_id()
+            return True
+
+    def page_chunks(self):
+        if (self.page_num != 0):
+            return [128]
+        if (self.cache_page0_admin == True):
+            return [0]
+        return [0, 128]
+
+    def page_fill(self, chunks):
+        if (chunks is not None):
+            base = 0 if (self.page_num == 0) else 128
+            for offset, data in chunks:
+                self.cache_page_data[offset-base:offset-base+len(data)] = data
+            if (self.page_num == 0):
+                self.cache_page0_admin = True
+            self.cache_page_valid = True
+            self.cache_page_ts = time.time()
+        self.pending = 0
+
+    # fill from / publish to the page cache shared with the other processes
+    def shared_fill(self, chunks):
+        found = []
+        for offset in chunks:
+            data = SharedPageCache.lookup(self.sfp_index, self.page_num, offset)
+            if (data is None):
+                return False
+            found.append((offset, data))
+        self.page_fill(found)
+        return True
+
+    def shared_publish(self, chunks, gen):
+        base = 0 if (self.page_num == 0) else 128
+        for offset in chunks:
+            SharedPageCache.insert(self.sfp_index, self.page_num, offset, self.cache_page_data[offset-base:offset-base+128], gen)
+
 
 class Sfp(SfpOptoeBase):
     """
@@ -480,6 +740,8 @@ class Sfp(SfpOptoeBase):
     presence = RawArray('I', 100)
     sfp_event_live = RawValue('I', 0)
     initialized = [False] * 100
+    # pages refreshed together with one MDIPC_READ_MULTI when any of them misses in smart_cache
+    multi_pages = [0, 1, 2]
 
     # used by sfp_event to synchronize presence info
     @staticmethod
@@ -491,6 +753,7 @@ class Sfp(SfpOptoeBase):
         for inst in Sfp.instances:
             if (inst.index == port):
                 inst.page_cache_flush(True)
+                SharedPageCache.invalidate(inst.index)
                 lastPresence = Sfp.presence[inst.index]
 
                 if (status == '0'):
@@ -532,6 +795,7 @@ class Sfp(SfpOptoeBase):
         self.index = index
         self._version_info = device_info.get_sonic_version_info()
         self.lastPresence = False
+        self.presence_seen = False
         self.cache_override_disable = True
         pid = os.getpid()
         tid = threading.get_native_id()
@@ -599,10 +863,15 @@ class Sfp(SfpOptoeBase):
             logger.log_warning("MDIPC ({} {}) get_presence status changed for SFP{} from {} to {}".format(os.getpid(), threading.get_native_id(), self.index, lastPresence, status))
             Sfp.presence[self.index] = status
             self.page_cache_flush(True)
+            # the first answer in a process is not a transition, it must not drop what others cached
+            if (self.presence_seen == True):
+                SharedPageCache.invalidate(self.index)
             if (status) and (Sfp.precache):
                 logger.log_warning("caching page0 for SFP{} due to lastPresence {}".format(self.index, status))
                 self.cache_page0.cache_page()
 
+        self.presence_seen = True
+
         if (status):
             return True
         else:
@@ -899,10 +1168,42 @@ class Sfp(SfpOptoeBase):
               if (Sfp.debug) or (self.debug):
                  logger.log_warning("###   SFP{} smart_cache skipping page {} offset {} num_bytes {}".format(self.index, page, offset, num_bytes))
               return
+           if (page in Sfp.multi_pages) and (MDIPC.multi_supported is not False) and (self.page_cache[page].cache_page_fresh() == False):
+              self.cache_pages_multi(Sfp.multi_pages)
            self.page_cache[page].cache_page(CACHE_NORMAL, self.debug)
         else:
            logger.log_error("###   SFP{} smart_cache page {} offset {} num_bytes {} out of range!".format(self.index, page, offset, num_bytes))
 
+    def cache_pages_multi(self, pages):
+        claimed = []
+        for page in pages:
+            inst = self.page_cache[page]
+            if (inst.cache_page_fresh() == False) and (inst.page_claim() == True):
+                if (inst.shared_fill(inst.page_chunks()) == False):
+                    claimed.append(inst)
+        if (len(claimed) == 0):
+            return
+        gen = SharedPageCache.gen(self.index)
+
+        descs = []
+        for inst in claimed:
+            for offset in inst.page_chunks():
+                descs.append((0, inst.page_num, offset, 128))
+        status, results = Sfp.MDIPC_hdl.msg_send_multi(self.index, descs)
+        if (Sfp.debug) or (self.debug):
+            logger.log_warning("###   SFP{} cache_pages_multi pages {} status {}".format(self.index, [inst.page_num for inst in claimed], status))
+
+        # a page is cached only when all of its chunks were read, the rest is left to cache_page
+        i = 0
+        for inst in claimed:
+            chunks = []
+            for offset in inst.page_chunks():
+                if (results is not None) and (results[i][0] == MDIPC_RSP_SUCCESS):
+                    chunks.append((offset, results[i][1]))
+                    SharedPageCache.insert(self.index, inst.page_num, offset, results[i][1], gen)
+                i += 1
+            inst.page_fill(chunks if (len(chunks) == len(inst.page_chunks())) else None)
+
     def override_cache(self, page, offset, num_bytes):
         if (page == 0) and ((offset >= 3) and (offset <= 84)):
             return True
@@ -1089,5 +1390,6 @@ class Sfp(SfpOptoeBase):
                 logger.log_warning("     data:    {}".format(bytes(write_buffer)))
 
         self.page_cache_flush()
+        SharedPageCache.invalidate(self.index)
 
         return True
@@ -0,0 +1,88 @@
+//  PMBus value decoding shared by the Nokia PSU drivers
+//
+//  Copyright (C) 2025 Nokia Corporation.
+//
+//  The platform modules are built one directory at a time, so this is header only; a platform Makefile
+//  picks it up with ccflags-y += -I$(src)/../../common/modules.
+//
+
+#ifndef _NOKIA_PMBUS_H_
+#define _NOKIA_PMBUS_H_
+
+#include <linux/types.h>
+#include <linux/bitops.h>
+#include <linux/hwmon.h>
+#include <linux/kernel.h>
+
+#define PMBUS_SCALE_UNIT                (1)
+#define PMBUS_SCALE_MILLI               (1000)
+#define PMBUS_SCALE_MICRO               (1000000)
+
+/*
+ * Left shift for each 5-bit two's complement exponent, biased by 16 so the whole range -16..15 is a left
+ * shift followed by the same >> 16; no branch on the sign of the exponent.
+ */
+static const u8 pmbus_exponent_shift[32] = {
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,     /* 0 .. 15 */
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,     /* -16 .. -1 */
+};
+
+/* value * 2^exponent, truncated toward zero like the integer division the drivers used to do */
+static inline long pmbus_apply_exponent(s64 value, u8 exponent)
+{
+    s64 shifted = value * ((s64)1 << pmbus_exponent_shift[exponent & 0x1f]);
+
+    shifted += (shifted >> 63) & 0xffff;
+    return shifted >> 16;
+}
+
+/* LINEAR11: 5-bit exponent over an 11-bit signed mantissa, both two's complement */
+static inline long pmbus_linear11(u16 raw, s32 scale)
+{
+    return pmbus_apply_exponent((s64)sign_extend32(raw & 0x7ff, 10) * scale, raw >> 11);
+}
+
+/* LINEAR16 (READ_VOUT): unsigned mantissa, exponent in the low 5 bits of VOUT_MODE. scale up to MILLI. */
+static inline long pmbus_linear16(u16 raw, u8 vout_mode, s32 scale)
+{
+    return pmbus_apply_exponent((s64)raw * scale, vout_mode);
+}
+
+enum pmbus_format
+{
+    PMBUS_LINEAR11,
+    PMBUS_LINEAR16,
+};
+
+/*
+ * One row per hwmon channel a PSU driver exports. index is the driver's own slot for the raw register
+ * value; scale converts to hwmon units (mV, mA, uW, millidegree C, RPM).
+ */
+struct pmbus_sensor
+{
+    const char *label;
+    enum hwmon_sensor_types type;
+    u8  channel;
+    u8  format;
+    u8  index;
+    s32 scale;
+};
+
+static inline long pmbus_sensor_value(const struct pmbus_sensor *sensor, u16 raw, u8 vout_mode)
+{
+    return (sensor->format == PMBUS_LINEAR16) ? pmbus_linear16(raw, vout_mode, sensor->scale) :
+                                                pmbus_linear11(raw, sensor->scale);
+}
+
+static inline const struct pmbus_sensor *pmbus_sensor_find(const struct pmbus_sensor *table, int count,
+                                                           enum hwmon_sensor_types type, int channel)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        if ((table[i].type == type) && (table[i].channel == channel))
+            return &table[i];
+    return NULL;
+}
+
+#endif /* _NOKIA_PMBUS_H_ */
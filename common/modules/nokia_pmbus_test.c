@@ -0,0 +1,116 @@
+//  KUnit test of the PMBus decoding in nokia_pmbus.h
+//
+//  Copyright (C) 2025 Nokia Corporation.
+//
+
+#include <linux/module.h>
+#include <kunit/test.h>
+#include "nokia_pmbus.h"
+
+struct linear11_vector
+{
+    u16  raw;
+    s32  scale;
+    long expected;
+};
+
+struct linear16_vector
+{
+    u16  raw;
+    u8   vout_mode;
+    s32  scale;
+    long expected;
+};
+
+static const struct linear11_vector linear11_vectors[] = {
+    {0xF8C8, PMBUS_SCALE_MILLI,   100000},      /* 200 * 2^-1 */
+    {0xEA4E, PMBUS_SCALE_MILLI,   73750},       /* 590 * 2^-3 */
+    {0xD3FF, PMBUS_SCALE_MILLI,   15984},       /* 1023 * 2^-6, truncated */
+    {0xFFFD, PMBUS_SCALE_UNIT,    -1},          /* -3 * 2^-1, truncated toward zero */
+    {0x0FFF, PMBUS_SCALE_UNIT,    -2},          /* -1 * 2^1 */
+    {0x0001, PMBUS_SCALE_MICRO,   1000000},
+    {0x7BFF, PMBUS_SCALE_UNIT,    33521664},    /* 1023 * 2^15 */
+    {0x8400, PMBUS_SCALE_MILLI,   -15},         /* -1024000 * 2^-16, truncated toward zero */
+    {0x0000, PMBUS_SCALE_MICRO,   0},
+};
+
+static const struct linear16_vector linear16_vectors[] = {
+    {0x1800, 0x17, PMBUS_SCALE_MILLI, 12000},   /* 6144 * 2^-9 */
+    {0x00C5, 0x1C, PMBUS_SCALE_MILLI, 12312},   /* 197 * 2^-4, truncated */
+    {0x0003, 0x02, PMBUS_SCALE_MILLI, 12000},   /* 3 * 2^2 */
+    {0xFFFF, 0x10, PMBUS_SCALE_MILLI, 999},     /* 65535 * 2^-16 */
+};
+
+static void pmbus_linear11_vectors_test(struct kunit *test)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(linear11_vectors); i++)
+        KUNIT_EXPECT_EQ_MSG(test, pmbus_linear11(linear11_vectors[i].raw, linear11_vectors[i].scale),
+                            linear11_vectors[i].expected, "raw 0x%04x", linear11_vectors[i].raw);
+}
+
+static void pmbus_linear16_vectors_test(struct kunit *test)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(linear16_vectors); i++)
+        KUNIT_EXPECT_EQ_MSG(test, pmbus_linear16(linear16_vectors[i].raw, linear16_vectors[i].vout_mode,
+                                                 linear16_vectors[i].scale),
+                            linear16_vectors[i].expected, "raw 0x%04x mode 0x%02x",
+                            linear16_vectors[i].raw, linear16_vectors[i].vout_mode);
+}
+
+/* the branching decode the PSU drivers each carried, widened to s64 so it cannot overflow */
+static s64 linear11_reference(u16 raw, s32 scale)
+{
+    int exponent = sign_extend32(raw >> 11, 4);
+    s64 mantissa = sign_extend32(raw & 0x7ff, 10);
+
+    return (exponent >= 0) ? (mantissa << exponent) * scale : (mantissa * scale) / (1 << -exponent);
+}
+
+static void pmbus_linear11_exhaustive_test(struct kunit *test)
+{
+    static const s32 scales[] = {PMBUS_SCALE_UNIT, PMBUS_SCALE_MILLI, PMBUS_SCALE_MICRO};
+    int i, raw;
+
+    for (i = 0; i < ARRAY_SIZE(scales); i++)
+        for (raw = 0; raw <= 0xffff; raw++)
+            if (pmbus_linear11(raw, scales[i]) != linear11_reference(raw, scales[i]))
+                KUNIT_FAIL(test, "raw 0x%04x scale %d: %ld, expected %lld", raw, scales[i],
+                           pmbus_linear11(raw, scales[i]), linear11_reference(raw, scales[i]));
+}
+
+static void pmbus_sensor_test(struct kunit *test)
+{
+    static const struct pmbus_sensor sensors[] = {
+        {"vin",  hwmon_in,    0, PMBUS_LINEAR11, 0, PMBUS_SCALE_MILLI},
+        {"vout", hwmon_in,    1, PMBUS_LINEAR16, 1, PMBUS_SCALE_MILLI},
+        {"pin",  hwmon_power, 0, PMBUS_LINEAR11, 2, PMBUS_SCALE_MICRO},
+    };
+    static const u16 raw[] = {0xF8C8, 0x1800, 0xEA4E};
+    const struct pmbus_sensor *vout = pmbus_sensor_find(sensors, ARRAY_SIZE(sensors), hwmon_in, 1);
+
+    KUNIT_ASSERT_PTR_EQ(test, vout, &sensors[1]);
+    KUNIT_EXPECT_NULL(test, pmbus_sensor_find(sensors, ARRAY_SIZE(sensors), hwmon_curr, 0));
+    KUNIT_EXPECT_EQ(test, pmbus_sensor_value(vout, raw[vout->index], 0x17), 12000);
+    KUNIT_EXPECT_EQ(test, pmbus_sensor_value(&sensors[2], raw[sensors[2].index], 0x17), 73750000);
+}
+
+static struct kunit_case nokia_pmbus_test_cases[] = {
+    KUNIT_CASE(pmbus_linear11_vectors_test),
+    KUNIT_CASE(pmbus_linear16_vectors_test),
+    KUNIT_CASE(pmbus_linear11_exhaustive_test),
+    KUNIT_CASE(pmbus_sensor_test),
+    {}
+};
+
+static struct kunit_suite nokia_pmbus_test_suite = {
+    .name = "nokia_pmbus",
+    .test_cases = nokia_pmbus_test_cases,
+};
+kunit_test_suite(nokia_pmbus_test_suite);
+
+MODULE_DESCRIPTION("KUnit test of the Nokia PSU PMBus decoding");
+MODULE_LICENSE("GPL");
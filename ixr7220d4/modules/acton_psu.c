@@ -8,6 +8,7 @@
 #include <linux/i2c.h>
 #include <linux/hwmon.h>
 #include <linux/hwmon-sysfs.h>
+#include "nokia_pmbus.h"
 #include <linux/err.h>
 #include <linux/mutex.h>
 #include <linux/sysfs.h>
@@ -160,14 +161,6 @@ static struct attribute *accton_i2c_psu_attributes[] = {
     NULL
 };
 
-static int two_complement_to_int(u16 data, u8 valid_bit, int mask)
-{
-    u16  valid_data  = data & mask;
-    bool is_negative = valid_data >> (valid_bit - 1);
-
-    return is_negative ? (-(((~valid_data) & mask) + 1)) : valid_data;
-}
-
 static ssize_t set_fan_duty_cycle(struct device *dev, struct device_attribute *da,
 			const char *buf, size_t count)
 {
@@ -200,7 +193,6 @@ static ssize_t show_linear(struct device *dev, struct device_attribute *da,
     struct accton_i2c_psu_data *data = accton_i2c_psu_update_device(dev);
 
     u16 value = 0;
-    int exponent, mantissa;
     int multiplier = 0;
 
     switch (attr->index) {
@@ -236,16 +228,12 @@ static ssize_t show_linear(struct device *dev, struct device_attribute *da,
         break;
     }
 
-    exponent = two_complement_to_int(value >> 11, 5, 0x1f);
-    mantissa = two_complement_to_int(value & 0x7ff, 11, 0x7ff);
-
     if(!multiplier)
         multiplier = PMBUS_LITERAL_DATA_MULTIPLIER;
     if(attr->index==PSU_P_OUT_UV)
         multiplier = 1000000;
 
-    return (exponent >= 0) ? sprintf(buf, "%d\n", (mantissa << exponent) * multiplier) :
-                             sprintf(buf, "%d\n", (mantissa * multiplier) / (1 << -exponent));
+    return sprintf(buf, "%ld\n", pmbus_linear11(value, multiplier));
 }
 
 static ssize_t show_fan_fault(struct device *dev, struct device_attribute *da,
@@ -263,13 +251,8 @@ static ssize_t show_vout(struct device *dev, struct device_attribute *da,
              char *buf)
 {
     struct accton_i2c_psu_data *data = accton_i2c_psu_update_device(dev);
-    int exponent, mantissa;
-
-    exponent = two_complement_to_int(data->vout_mode, 5, 0x1f);
-    mantissa = data->v_out;
 
-    return (exponent > 0) ? sprintf(buf, "%d\n", (mantissa << exponent) * PMBUS_LITERAL_DATA_MULTIPLIER) :
-                            sprintf(buf, "%d\n", (mantissa * PMBUS_LITERAL_DATA_MULTIPLIER) / (1 << -exponent));
+    return sprintf(buf, "%ld\n", pmbus_linear16(data->v_out, data->vout_mode, PMBUS_LITERAL_DATA_MULTIPLIER));
 }
 
 static ssize_t show_byte(struct device *dev, struct device_attribute *da,
@@ -33,6 +33,7 @@
 #include <linux/sysfs.h>
 #include <linux/hwmon.h>
 #include <linux/hwmon-sysfs.h>
+#include "nokia_pmbus.h"
 #include <linux/err.h>
 #include <linux/of_device.h>
 #include <linux/of.h>
@@ -72,7 +73,6 @@ struct dps_1600ab_29_a_data {
 	u8	mfr_serial[16];
 };
 
-static int two_complement_to_int(u16 data, u8 valid_bit, int mask);
 static ssize_t set_fan_duty_cycle_input(struct device *dev, struct device_attribute \
                                 *dev_attr, const char *buf, size_t count);
 static ssize_t for_linear_data(struct device *dev, struct device_attribute \
@@ -139,14 +139,6 @@ static ssize_t for_r_member_data(struct device *dev, struct device_attribute \
 	return sprintf(buf, "0x%02X\n", psu_member_data);
 }
 
-static int two_complement_to_int(u16 data, u8 valid_bit, int mask)
-{
-	u16  valid_data  = data & mask;
-    	bool is_negative = valid_data >> (valid_bit - 1);
-
-    	return is_negative ? (-(((~valid_data) & mask) + 1)) : valid_data;
-}
-
 static ssize_t set_fan_duty_cycle_input(struct device *dev, struct device_attribute \
 				*dev_attr, const char *buf, size_t count)
 {
@@ -181,7 +173,6 @@ static ssize_t for_linear_data(struct device *dev, struct device_attribute \
 	struct dps_1600ab_29_a_data *data = dps_1600ab_29_a_update_device(dev);
 
 	u16 value = 0;
-	int exponent, mantissa;
 	int multiplier = 1000;
 	
 	switch (attr->index) {
@@ -217,12 +208,7 @@ static ssize_t for_linear_data(struct device *dev, struct device_attribute \
 		break;
 	}
 
-	exponent = two_complement_to_int(value >> 11, 5, 0x1f);
-	mantissa = two_complement_to_int(value & 0x7ff, 11, 0x7ff);
-
-	return (exponent >= 0) ? sprintf(buf, "%d\n",	\
-		(mantissa << exponent) * multiplier) :	\
-	    sprintf(buf, "%d\n", (mantissa * multiplier) / (1 << -exponent));	
+	return sprintf(buf, "%ld\n", pmbus_linear11(value, multiplier));
 }
 
 static ssize_t for_fan_target(struct device *dev, struct device_attribute \
@@ -240,15 +226,8 @@ static ssize_t for_vout_data(struct device *dev, struct device_attribute \
 		 					*dev_attr, char *buf)
 {
 	struct dps_1600ab_29_a_data *data = dps_1600ab_29_a_update_device(dev);
-	int exponent, mantissa;
-	int multiplier = 1000;
-		
-	exponent = two_complement_to_int(data->vout_mode, 5, 0x1f);
-	mantissa = data->in2_input;
-	
-	return (exponent > 0) ? sprintf(buf, "%d\n", \
-                (mantissa * multiplier) / (1 << exponent)): \
-        sprintf(buf, "%d\n", (mantissa * multiplier) / (1 << -exponent));
+
+	return sprintf(buf, "%ld\n", pmbus_linear16(data->in2_input, data->vout_mode, PMBUS_SCALE_MILLI));
 }
 
 static ssize_t for_ascii(struct device *dev, struct device_attribute \
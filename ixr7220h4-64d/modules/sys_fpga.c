@@ -31,6 +31,12 @@
 #include <linux/pci.h>
 #include <linux/time64.h>
 #include <linux/delay.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/wait.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <linux/kobject.h>
 
 /***********************************************
  *       variable define
@@ -82,6 +88,7 @@
 
 #define QSFP_NUM_OF_PORT 64
 #define SFP_NUM_OF_PORT  2
+#define FPGA_PORT_NUM    (QSFP_NUM_OF_PORT + SFP_NUM_OF_PORT)
 #define FPGA_NUM 3
 
 #define TRANSCEIVER_PRESENT_ATTR_ID(index)    MODULE_PRESENT_##index
@@ -148,6 +155,7 @@
 
 /* I2C Controller Management Registers */
 #define PCIE_FPGA_I2C_MGMT_RTC0_PROFILE_0         0x2008
+#define PCIE_FPGA_I2C_MGMT_RTC0_INTR_EN_0         0x200C    /* assumed, only written with i2c_irq=1 */
 
 /* I2C Real Time Control Registers */
 #define PCIE_FPGA_I2C_CONTROL_RTC0_CONFIG_0       0x2050
@@ -160,6 +168,16 @@
 
 #define PCIE_FPGA_I2C_MAX_LEN                     128
 #define PCIE_FPGA_I2C_NEW_TRIGGER_VALUE           0x80000000
+#define PCIE_FPGA_I2C_DONE_CLEAR                  0x3
+
+/*
+ * Done wait: woken by the RTC done interrupt, the status is re-read every
+ * poll slice in case the interrupt is missing. Observed completions take
+ * 0.5~10 ms, the old poll loop gave up after 500 x (50~100) us.
+ */
+#define PCIE_FPGA_I2C_DONE_SLICE_US               100
+#define PCIE_FPGA_I2C_DONE_TIMEOUT_US             50000
+#define PCIE_FPGA_I2C_EEPROM_WRITE_US             1000
 
 /* Show system date time */
 #define DATETIME_LEN  50
@@ -183,8 +201,50 @@ typedef struct pci_fpga_device_s {
 	u32  sfp_output_data;
 	u16  aslpc_cpld1_offset;
 	u16  aslpc_cpld2_offset;
+	int  irq;                   /* RTC done interrupt, -1: polled */
 } pci_fpga_device_t;
 
+/* per port RTC transaction latency, reset by writing to debugfs i2c_latency */
+struct fpga_i2c_stats {
+	u64  xfers;
+	u64  irq_done;              /* completions signalled by the interrupt */
+	u64  errors;
+	u64  timeouts;
+	u64  ns;
+	u64  max_ns;
+	u64  last_ns;
+};
+
+/*
+ * EEPROM page cache, one per port, indexed by the 128-byte slice of the
+ * eeprom bin file. Identification pages stay until the port is invalidated
+ * (presence change, reset, eeprom write), all others for eeprom_cache_ms.
+ */
+#define EEPROM_CACHE_SLOTS 8
+
+struct eeprom_cache_slot {
+	int            slice;       /* -1: empty */
+	unsigned long  filled;      /* jiffies */
+	u8             data[OPTOE_PAGE_SIZE];
+};
+
+struct eeprom_cache_stats {
+	u64  hits;
+	u64  misses;
+	u64  expired;
+	u64  prefetched;
+	u64  invalidations;
+	u64  selects_skipped;       /* page select writes saved by cur_page */
+};
+
+struct eeprom_cache {
+	struct bin_attribute      *attr;       /* for the prefetch work */
+	int                       cur_page;    /* selected on the paged address, -1: unknown */
+	u8                        identifier;  /* of the last lower page read */
+	struct eeprom_cache_slot  slot[EEPROM_CACHE_SLOTS];
+	struct eeprom_cache_stats stats;
+};
+
 /*fpga port status*/
 struct sys_fpga_data {
 	struct platform_device    *pdev;
@@ -199,12 +259,66 @@ struct sys_fpga_data {
 	u32                       udb_cpld2_ver;
 	u32                       ldb_cpld1_ver;
 	u32                       ldb_cpld2_ver;
+	/* one RTC transaction at a time, serialized by update_lock */
+	wait_queue_head_t         i2c_wq;
+	spinlock_t                i2c_lock;
+	struct eeprom_bin_private_data *i2c_busy;  /* port waiting for done */
+	u32                       i2c_done;        /* its done status, 0: pending */
+	bool                      i2c_by_irq;
+	struct fpga_i2c_stats     i2c_stats[FPGA_PORT_NUM];
+	struct dentry             *debugfs;
+	struct eeprom_cache       *eeprom_cache;   /* [FPGA_PORT_NUM] */
+	bool                      present_valid;
+	u64                       qsfp_present_map; /* bit (port - 1), 1: absent */
+	u32                       sfp_present_map;
+	struct work_struct        prefetch_work;
+	DECLARE_BITMAP(prefetch_pending, FPGA_PORT_NUM);
+	/* presence changes not yet notified, same layout as the maps */
+	u64                       qsfp_present_changed;
+	u32                       sfp_present_changed;
+	struct delayed_work       present_work;
+	/* ports whose eeprom size is retried, by port_num - 1 */
+	DECLARE_BITMAP(resize_pending, FPGA_PORT_NUM);
+	unsigned long             resize_until[FPGA_PORT_NUM];  /* In jiffies */
 };
 
 static struct sys_fpga_data  *fpga_ctl = NULL;
 
 struct mutex update_lock;
 
+/* off until PCIE_FPGA_I2C_MGMT_RTC0_INTR_EN_0 is confirmed against the FPGA register map */
+static bool i2c_irq = false;
+module_param(i2c_irq, bool, 0444);
+MODULE_PARM_DESC(i2c_irq, "Wait for the FPGA I2C done interrupt instead of polling (default: false)");
+
+static unsigned int eeprom_cache_ms = 1000;
+module_param(eeprom_cache_ms, uint, 0644);
+MODULE_PARM_DESC(eeprom_cache_ms, "Max age of cached volatile EEPROM pages in ms, 0 disables the page cache (default: 1000)");
+
+/*
+ * No presence change interrupt is documented for the UDB/LDB FPGA, so the
+ * present registers are polled from a work item instead.
+ */
+static unsigned int present_poll_ms = 100;
+module_param(present_poll_ms, uint, 0444);
+MODULE_PARM_DESC(present_poll_ms, "Presence poll period in ms for module_present_all notifications, 0 disables them (default: 100)");
+
+/*
+ * A module is often still initialising when its presence edge is seen, so the
+ * eeprom file size is re-read on every presence poll for this long after the
+ * insertion while it still has the size of an empty port.
+ */
+static unsigned int eeprom_resize_ms = 5000;
+module_param(eeprom_resize_ms, uint, 0644);
+MODULE_PARM_DESC(eeprom_resize_ms, "How long after an insertion the eeprom file size is retried, in ms (default: 5000)");
+
+/* serializes the eeprom bin file re-creation against the port remove */
+static DEFINE_MUTEX(eeprom_resize_lock);
+
+static bool eeprom_prefetch = false;
+module_param(eeprom_prefetch, bool, 0644);
+MODULE_PARM_DESC(eeprom_prefetch, "Read the common DOM pages ahead after a lower page read (default: false)");
+
 struct eeprom_bin_private_data {
 	int    port_num;
 	int    fpga_type;
@@ -212,12 +326,14 @@ struct eeprom_bin_private_data {
 	int    sfp_support_a2;
 	int    i2c_slave_addr;
 	int    i2c_mgmt_rtc0_profile;
+	int    i2c_mgmt_rtc0_intr_en;
 	int    i2c_contrl_rtc0_config_0;
 	int    i2c_contrl_rtc0_config_1;
 	int    i2c_contrl_rtc0_stats;
 	int    i2c_rtc_read_data;
 	int    i2c_rtc_write_data;
 	void   __iomem *data_base_addr;
+	struct kobject *kobj;        /* of the port device, while the eeprom file exists */
 };
 
 struct pcie_fpga_dev_platform_data {
@@ -267,6 +383,7 @@ struct pcie_fpga_dev_platform_data {
 	.fpga_type                   = PCIE_FPGA_TYPE_UDB,               \
 	.i2c_slave_addr              = 0x50,                             \
 	.i2c_mgmt_rtc0_profile       = PCIE_FPGA_I2C_MGMT_RTC0_PROFILE_0   + 0x100*(c-1),     \
+	.i2c_mgmt_rtc0_intr_en       = PCIE_FPGA_I2C_MGMT_RTC0_INTR_EN_0   + 0x100*(c-1),     \
 	.i2c_contrl_rtc0_config_0    = PCIE_FPGA_I2C_CONTROL_RTC0_CONFIG_0 + 0x100*(c-1),     \
 	.i2c_contrl_rtc0_config_1    = PCIE_FPGA_I2C_CONTROL_RTC0_CONFIG_1 + 0x100*(c-1),     \
 	.i2c_contrl_rtc0_stats       = PCIE_FPGA_I2C_CONTROL_RTC0_STATUS_0 + 0x100*(c-1),     \
@@ -323,6 +440,7 @@ struct pcie_fpga_dev_platform_data {
 	.fpga_type                   = PCIE_FPGA_TYPE_LDB,                                    \
 	.i2c_slave_addr              = 0x50,                                                  \
 	.i2c_mgmt_rtc0_profile       = PCIE_FPGA_I2C_MGMT_RTC0_PROFILE_0   + 0x100*(c-1),     \
+	.i2c_mgmt_rtc0_intr_en       = PCIE_FPGA_I2C_MGMT_RTC0_INTR_EN_0   + 0x100*(c-1),     \
 	.i2c_contrl_rtc0_config_0    = PCIE_FPGA_I2C_CONTROL_RTC0_CONFIG_0 + 0x100*(c-1),     \
 	.i2c_contrl_rtc0_config_1    = PCIE_FPGA_I2C_CONTROL_RTC0_CONFIG_1 + 0x100*(c-1),     \
 	.i2c_contrl_rtc0_stats       = PCIE_FPGA_I2C_CONTROL_RTC0_STATUS_0 + 0x100*(c-1),     \
@@ -568,7 +686,8 @@ enum eeprom_page_type_e {
 enum port_sysfs_attributes {
 	PORT_SYSFS_NAME_ID = 1,
 	PORT_SYSFS_PORT_NAME_ID,
-	PORT_SYSFS_DEV_CLASS_ID
+	PORT_SYSFS_DEV_CLASS_ID,
+	PORT_SYSFS_EEPROM_CACHE_ID
 };
 
 /***********************************************
@@ -589,6 +708,8 @@ static ssize_t port_write(struct device *dev, struct device_attribute *da,
 static int fpga_i2c_ready_to_read(struct bin_attribute *attr, int page_type, 
 					int i2c_slave_addr);
 
+static void fpga_eeprom_cache_invalidate(int port_num);
+
 static ssize_t show_qsfp_reset(struct device *dev, 
                 struct device_attribute *devattr, char *buf);
 
@@ -1602,10 +1723,15 @@ static SENSOR_DEVICE_ATTR(port_name, S_IRUGO, port_read, NULL,
 static SENSOR_DEVICE_ATTR(dev_class, S_IRUGO|S_IWUSR, port_read, port_write,
 			PORT_SYSFS_DEV_CLASS_ID); 
 
+/* page cache hit/miss counters */
+static SENSOR_DEVICE_ATTR(eeprom_cache, S_IRUGO, port_read, NULL,
+			PORT_SYSFS_EEPROM_CACHE_ID);
+
 static struct attribute *fpga_eeprom_attributes[] = {
 	&sensor_dev_attr_name.dev_attr.attr,
 	&sensor_dev_attr_port_name.dev_attr.attr,
 	&sensor_dev_attr_dev_class.dev_attr.attr,
+	&sensor_dev_attr_eeprom_cache.dev_attr.attr,
 	NULL
 };
 
@@ -1659,6 +1785,8 @@ static ssize_t set_qsfp_reset(struct device *dev, struct device_attribute *devat
     }
 
     fpga_ctl->reset_list[sda->index] = usr_val;
+    /* sfp_event reads these along with module_present_all, wake it too */
+    sysfs_notify(&dev->kobj, NULL, "module_present_all");
     return count;
 }
 
@@ -1864,6 +1992,7 @@ static ssize_t set_reset(struct device *dev, struct device_attribute *devattr, c
 	u32 mask = 0;
 	u8 usr_val = 0;
 	u32 usr_val32 = 0;
+	int port_num = 0;
 
     int ret = kstrtou8(buf, 10, &usr_val);
     if (ret != 0) {
@@ -1880,6 +2009,7 @@ static ssize_t set_reset(struct device *dev, struct device_attribute *devattr, c
 		reg_val = reg_val & mask;
 		usr_val32 = usr_val << (sda->index - MODULE_RESET_1);
 		iowrite32((reg_val | usr_val32), fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_UDB].data_base_addr + QSFP_RESET_REG_OFFSET);
+		port_num = sda->index - MODULE_RESET_1 + 1;
 		break;
 	case MODULE_RESET_33 ... MODULE_RESET_64:
 	    mask = (~(1 << (sda->index - MODULE_RESET_33))) & 0xFFFFFFFF;
@@ -1887,12 +2017,18 @@ static ssize_t set_reset(struct device *dev, struct device_attribute *devattr, c
 		reg_val = reg_val & mask;
 		usr_val32 = usr_val << (sda->index - MODULE_RESET_33);
 		iowrite32((reg_val | usr_val32), fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_LDB].data_base_addr + QSFP_RESET_REG_OFFSET);
+		port_num = sda->index - MODULE_RESET_33 + 33;
 		break;	
 	default:
 		return -EINVAL;
 		break;
 	}
 
+	/* a reset module reloads its pages and restarts on page 0 */
+	mutex_lock(&update_lock);
+	fpga_eeprom_cache_invalidate(port_num);
+	mutex_unlock(&update_lock);
+
 	return count;
 }
 
@@ -2359,6 +2495,157 @@ static ssize_t set_group_led_pres(struct device *dev, struct device_attribute *d
 	return count;
 }
 
+/*
+ * Drop everything cached for a port (port_num from 1) and forget its
+ * selected page. Callers hold update_lock.
+ */
+static void fpga_eeprom_cache_invalidate(int port_num)
+{
+	int i;
+	struct eeprom_cache *cache = NULL;
+
+	if((port_num < 1) || (port_num > FPGA_PORT_NUM))
+		return;
+
+	cache = &fpga_ctl->eeprom_cache[port_num - 1];
+	for(i = 0; i < EEPROM_CACHE_SLOTS; i++)
+		cache->slot[i].slice = -1;
+	cache->cur_page = -1;
+	cache->stats.invalidations++;
+	clear_bit(port_num - 1, fpga_ctl->prefetch_pending);
+}
+
+/*
+ * Compare the freshly read present registers with the last ones, drop the
+ * cache of every port that changed and leave it for fpga_present_work().
+ */
+static void fpga_port_present_update(void)
+{
+	int port;
+	u64 qsfp_map;
+	u32 sfp_map;
+	u64 changed;
+
+	qsfp_map = 
+		((u64)fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_LDB].qsfp_present << 32) |
+		fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_UDB].qsfp_present;
+	sfp_map = 
+		(SFP_PORT0_ABS(fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_LDB].sfp_input_data) & 0x1) |
+		((SFP_PORT1_ABS(fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_LDB].sfp_input_data) & 0x1) << 1);
+
+	if(fpga_ctl->present_valid) {
+		changed = qsfp_map ^ fpga_ctl->qsfp_present_map;
+		fpga_ctl->qsfp_present_changed |= changed;
+		for(port = 0; changed && (port < QSFP_NUM_OF_PORT); port++)
+			if((changed >> port) & 0x1)
+				fpga_eeprom_cache_invalidate(port + 1);
+
+		changed = sfp_map ^ fpga_ctl->sfp_present_map;
+		fpga_ctl->sfp_present_changed |= changed;
+		for(port = 0; changed && (port < SFP_NUM_OF_PORT); port++)
+			if((changed >> port) & 0x1)
+				fpga_eeprom_cache_invalidate(FPGA_LDB_SFP_PORT1_NO + port);
+	}
+
+	fpga_ctl->qsfp_present_map = qsfp_map;
+	fpga_ctl->sfp_present_map = sfp_map;
+	fpga_ctl->present_valid = true;
+}
+
+/* SFP A0h, QSFP/CMIS upper page 00h~02h: identification and thresholds */
+static bool fpga_eeprom_cache_static(struct eeprom_bin_private_data *pdata, 
+				     int slice)
+{
+	if(pdata->port_num > FPGA_QSFP_PORT_NUM)
+		return slice <= 1;
+
+	return (slice >= 1) && (slice <= 3);
+}
+
+static struct eeprom_cache_slot *fpga_eeprom_cache_find(
+		struct eeprom_bin_private_data *pdata, int slice)
+{
+	int i;
+	struct eeprom_cache *cache = &fpga_ctl->eeprom_cache[pdata->port_num - 1];
+
+	for(i = 0; i < EEPROM_CACHE_SLOTS; i++)
+		if(cache->slot[i].slice == slice)
+			return &cache->slot[i];
+
+	return NULL;
+}
+
+static bool fpga_eeprom_cache_fresh(struct eeprom_bin_private_data *pdata,
+				    struct eeprom_cache_slot *slot)
+{
+	if(fpga_eeprom_cache_static(pdata, slot->slice))
+		return true;
+
+	return time_before(jiffies, slot->filled + msecs_to_jiffies(eeprom_cache_ms));
+}
+
+static struct eeprom_cache_slot *fpga_eeprom_cache_lookup(
+		struct eeprom_bin_private_data *pdata, int slice)
+{
+	struct eeprom_cache *cache = &fpga_ctl->eeprom_cache[pdata->port_num - 1];
+	struct eeprom_cache_slot *slot = NULL;
+
+	if(!eeprom_cache_ms)
+		return NULL;
+
+	slot = fpga_eeprom_cache_find(pdata, slice);
+	if(!slot) {
+		cache->stats.misses++;
+		return NULL;
+	}
+	if(!fpga_eeprom_cache_fresh(pdata, slot)) {
+		cache->stats.expired++;
+		slot->slice = -1;
+		return NULL;
+	}
+	cache->stats.hits++;
+
+	return slot;
+}
+
+/* same slice, else a free slot, else the oldest one */
+static void fpga_eeprom_cache_insert(struct eeprom_bin_private_data *pdata,
+				     int slice, u8 *data)
+{
+	int i;
+	struct eeprom_cache *cache = &fpga_ctl->eeprom_cache[pdata->port_num - 1];
+	struct eeprom_cache_slot *slot = NULL;
+
+	if(!eeprom_cache_ms)
+		return;
+
+	slot = fpga_eeprom_cache_find(pdata, slice);
+	if(!slot)
+		slot = fpga_eeprom_cache_find(pdata, -1);
+	if(!slot) {
+		slot = &cache->slot[0];
+		for(i = 1; i < EEPROM_CACHE_SLOTS; i++)
+			if(time_before(cache->slot[i].filled, slot->filled))
+				slot = &cache->slot[i];
+	}
+
+	slot->slice = slice;
+	slot->filled = jiffies;
+	memcpy(slot->data, data, OPTOE_PAGE_SIZE);
+}
+
+static ssize_t fpga_eeprom_cache_stats_show(struct eeprom_bin_private_data *pdata,
+					    char *buf)
+{
+	struct eeprom_cache_stats *st = 
+		&fpga_ctl->eeprom_cache[pdata->port_num - 1].stats;
+
+	return sprintf(buf, "hits %llu\nmisses %llu\nexpired %llu\nprefetched %llu\n"
+		       "invalidations %llu\nselects_skipped %llu\n",
+		       st->hits, st->misses, st->expired, st->prefetched,
+		       st->invalidations, st->selects_skipped);
+}
+
 static ssize_t fpga_read_sfp_ddm_status_value(struct bin_attribute *eeprom)
 {
 	u32 reg_val = 0;
@@ -2398,13 +2685,10 @@ static ssize_t fpga_read_sfp_ddm_status_value(struct bin_attribute *eeprom)
 	return 0;
 }
 
-static ssize_t fpga_read_port_status_value(struct bin_attribute *eeprom)
+static void fpga_update_port_status(void)
 {
 	int i = 0;
 
-	if(time_before(jiffies, fpga_ctl->last_updated + HZ / 2))
-		return 0;
-
 	for(i = 0; i < ARRAY_SIZE(fpga_ctl->pci_fpga_dev)-1; i++){
 		/*Update present*/
 		fpga_ctl->pci_fpga_dev[i].qsfp_present = 
@@ -2430,8 +2714,17 @@ static ssize_t fpga_read_port_status_value(struct bin_attribute *eeprom)
 				ioread32(fpga_ctl->pci_fpga_dev[i].data_base_addr + 
 					 QSFP_RESET_REG_OFFSET);
 	}
+	fpga_port_present_update();
 
 	fpga_ctl->last_updated = jiffies;
+}
+
+static ssize_t fpga_read_port_status_value(struct bin_attribute *eeprom)
+{
+	if(time_before(jiffies, fpga_ctl->last_updated + HZ / 2))
+		return 0;
+
+	fpga_update_port_status();
 
 	return 0;
 }
@@ -2464,6 +2757,8 @@ static ssize_t fpga_write_port_value(int fpga_type, int set_type, int bit_num,
 	case PCIE_FPGA_SET_RESET:
 		iowrite32(val_set, fpga_ctl->pci_fpga_dev[fpga_type].data_base_addr + 
 			  QSFP_RESET_REG_OFFSET);
+		if(bit_num < 32)
+			fpga_eeprom_cache_invalidate(fpga_type * 32 + bit_num + 1);
 		break;
 	case PCIE_FPGA_SET_TX_DISABLE:
 		iowrite32(val_set, fpga_ctl->pci_fpga_dev[fpga_type].data_base_addr + 
@@ -2726,6 +3021,9 @@ static ssize_t port_read(struct device *dev, struct device_attribute *da, char *
 	case PORT_SYSFS_DEV_CLASS_ID:
 		ret = sprintf(buf, "%d\n", pdata->dev_class);
 		break;
+	case PORT_SYSFS_EEPROM_CACHE_ID:
+		ret = fpga_eeprom_cache_stats_show(pdata->eeprom_bin.private, buf);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -2764,121 +3062,179 @@ static ssize_t port_write(struct device *dev, struct device_attribute *da,
 }
 
 /*
- * eeprom read function
+ * RTC done status of the port in flight, latched by whichever of the
+ * interrupt or the waiter sees it first. Acknowledging it right away keeps
+ * a level triggered line from firing again.
  */
-static int fpga_i2c_ready_to_read(struct bin_attribute *attr,
-				int page_type, int i2c_slave_addr)
+static u32 fpga_i2c_done_latch(struct eeprom_bin_private_data *pdata)
 {
-	int  cnt = 0;
-	int  chk_state_cnt = 0;
-	u32  i2c_new_trigger_val = 0;
-	u32  flag = 0;
+	u32 flag;
+
+	flag = ioread32(pdata->data_base_addr + pdata->i2c_contrl_rtc0_stats);
+	if(flag) {
+		iowrite32(PCIE_FPGA_I2C_DONE_CLEAR, pdata->data_base_addr +
+			  pdata->i2c_contrl_rtc0_stats);
+		fpga_ctl->i2c_done = flag;
+		fpga_ctl->i2c_busy = NULL;
+	}
+
+	return flag;
+}
+
+static irqreturn_t fpga_i2c_isr(int irq, void *dev_id)
+{
+	pci_fpga_device_t *fpga_dev = dev_id;
 	struct eeprom_bin_private_data *pdata = NULL;
+	u32 flag = 0;
+
+	spin_lock(&fpga_ctl->i2c_lock);
+	pdata = fpga_ctl->i2c_busy;
+	if(pdata && (pdata->data_base_addr == fpga_dev->data_base_addr)) {
+		flag = fpga_i2c_done_latch(pdata);
+		if(flag)
+			fpga_ctl->i2c_by_irq = true;
+	}
+	spin_unlock(&fpga_ctl->i2c_lock);
 
-	pdata = attr->private;
+	if(!flag)
+		return IRQ_NONE;
 
-	/*Select i2c protocol profile*/
-	iowrite32(0x1, pdata->data_base_addr + pdata->i2c_mgmt_rtc0_profile);
+	wake_up(&fpga_ctl->i2c_wq);
+	return IRQ_HANDLED;
+}
+
+static u32 fpga_i2c_done(struct eeprom_bin_private_data *pdata)
+{
+	unsigned long flags;
+	u32 flag;
+
+	spin_lock_irqsave(&fpga_ctl->i2c_lock, flags);
+	flag = fpga_ctl->i2c_done;
+	if(!flag && (fpga_ctl->i2c_busy == pdata))
+		flag = fpga_i2c_done_latch(pdata);
+	spin_unlock_irqrestore(&fpga_ctl->i2c_lock, flags);
+
+	return flag;
+}
+
+/*
+ * Start one RTC transaction and wait for its done status.
+ * Return the status (1: done) or -EAGAIN on timeout.
+ */
+static int fpga_i2c_xfer(struct eeprom_bin_private_data *pdata,
+			 u32 config_0, u32 config_1)
+{
+	int  flag = 0;
+	u64  dur;
+	ktime_t start;
+	unsigned long flags;
+	struct fpga_i2c_stats *st = NULL;
+	bool irq = fpga_ctl->pci_fpga_dev[pdata->fpga_type].irq >= 0;
 
-	/*clean read data*/
-	for(cnt = 0 ; cnt < 32; cnt++)
-		iowrite32(0x0, pdata->data_base_addr + 
-			 (pdata->i2c_rtc_read_data + (4 * cnt)));
+	st = &fpga_ctl->i2c_stats[pdata->port_num - 1];
 
 	/*clean done status*/
-	iowrite32(0x3, pdata->data_base_addr + pdata->i2c_contrl_rtc0_stats);
+	iowrite32(PCIE_FPGA_I2C_DONE_CLEAR, pdata->data_base_addr + 
+		  pdata->i2c_contrl_rtc0_stats);
+
+	spin_lock_irqsave(&fpga_ctl->i2c_lock, flags);
+	fpga_ctl->i2c_busy = pdata;
+	fpga_ctl->i2c_done = 0;
+	fpga_ctl->i2c_by_irq = false;
+	spin_unlock_irqrestore(&fpga_ctl->i2c_lock, flags);
 
-	/*set read slave addr*/
-	iowrite32(0x10000080|(i2c_slave_addr << 8), pdata->data_base_addr + 
+	/*set slave addr and length*/
+	iowrite32(config_0, pdata->data_base_addr + 
 		  pdata->i2c_contrl_rtc0_config_0);
 
 	/*triger*/
-	if(page_type == EEPROM_LOWER_PAGE)
-		i2c_new_trigger_val = PCIE_FPGA_I2C_NEW_TRIGGER_VALUE;
-	else
-		i2c_new_trigger_val = PCIE_FPGA_I2C_NEW_TRIGGER_VALUE + 0x80;
-
-	iowrite32(i2c_new_trigger_val, pdata->data_base_addr + 
+	start = ktime_get();
+	iowrite32(config_1, pdata->data_base_addr + 
 		  pdata->i2c_contrl_rtc0_config_1);
 
-	/*read done status*/
-	while( 1 ) {
-		flag = ioread32(pdata->data_base_addr + 
-				pdata->i2c_contrl_rtc0_stats);
-		if(flag == 0) {
-		/*In normal case:
-		observed chk_state_cnt(10~120) times can get i2c rtc0 done status. */
-			if( chk_state_cnt > 500 ) {
-				flag = -EAGAIN;
-				break;
-			}
-			usleep_range(50, 100);
-			chk_state_cnt++;
-			continue;
-		} else {
+	/*wait done status*/
+	while((flag = fpga_i2c_done(pdata)) == 0) {
+		if(ktime_us_delta(ktime_get(), start) > PCIE_FPGA_I2C_DONE_TIMEOUT_US) {
+			spin_lock_irqsave(&fpga_ctl->i2c_lock, flags);
+			fpga_ctl->i2c_busy = NULL;
+			iowrite32(PCIE_FPGA_I2C_DONE_CLEAR, pdata->data_base_addr + 
+				  pdata->i2c_contrl_rtc0_stats);
+			spin_unlock_irqrestore(&fpga_ctl->i2c_lock, flags);
+			flag = -EAGAIN;
 			break;
 		}
+		if(irq)
+			wait_event_hrtimeout(fpga_ctl->i2c_wq, 
+				READ_ONCE(fpga_ctl->i2c_done) != 0,
+				us_to_ktime(PCIE_FPGA_I2C_DONE_SLICE_US));
+		else
+			usleep_range(50, 100);
 	}
-	msleep(1);
+	dur = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	/* only updated under update_lock; a reset from debugfs may race, that's fine */
+	st->xfers++;
+	st->ns += dur;
+	st->last_ns = dur;
+	if(dur > st->max_ns)
+		st->max_ns = dur;
+	if(fpga_ctl->i2c_by_irq)
+		st->irq_done++;
+	if(flag == -EAGAIN)
+		st->timeouts++;
+	else if(flag != 1)
+		st->errors++;
 
 	return flag;
 }
 
-static int fpga_i2c_set_data(struct bin_attribute *attr, loff_t offset, char *data, int i2c_slave_addr)
+/*
+ * eeprom read function
+ */
+static int fpga_i2c_ready_to_read(struct bin_attribute *attr,
+				int page_type, int i2c_slave_addr)
 {
-	int cnt = 0;
-	int chk_state_cnt = 0;
-	struct eeprom_bin_private_data *pdata = NULL;
-	u32  flag = 0;
 	u32  i2c_new_trigger_val = 0;
+	struct eeprom_bin_private_data *pdata = NULL;
 
 	pdata = attr->private;
 
 	/*Select i2c protocol profile*/
 	iowrite32(0x1, pdata->data_base_addr + pdata->i2c_mgmt_rtc0_profile);
 
-	/*clean read data*/
-	for( cnt=0 ; cnt < (PCIE_FPGA_I2C_MAX_LEN/4); cnt++){
-		iowrite32(0x0, pdata->data_base_addr + 
-			  (pdata->i2c_rtc_write_data + (4 * cnt)));
-	}
+	/*
+	 * No need to clean the read data: a done transaction fills all
+	 * PCIE_FPGA_I2C_MAX_LEN bytes and a failed one is never read back.
+	 */
 
-	/* Prepare date to set into data registor*/
-	iowrite32(data[0], pdata->data_base_addr + pdata->i2c_rtc_write_data);
+	if(page_type == EEPROM_LOWER_PAGE)
+		i2c_new_trigger_val = PCIE_FPGA_I2C_NEW_TRIGGER_VALUE;
+	else
+		i2c_new_trigger_val = PCIE_FPGA_I2C_NEW_TRIGGER_VALUE + 0x80;
 
-	/*clean done status*/
-	iowrite32(0x3, pdata->data_base_addr + pdata->i2c_contrl_rtc0_stats);
+	/*read PCIE_FPGA_I2C_MAX_LEN bytes from slave addr*/
+	return fpga_i2c_xfer(pdata, 0x10000080 | (i2c_slave_addr << 8), 
+			     i2c_new_trigger_val);
+}
 
-	/*set write slave addr*/
-	iowrite32(EEPROM_ALLOW_SET_LEN | (i2c_slave_addr << 8), 
-		  pdata->data_base_addr + pdata->i2c_contrl_rtc0_config_0);
+static int fpga_i2c_set_data(struct bin_attribute *attr, loff_t offset, char *data, int i2c_slave_addr)
+{
+	struct eeprom_bin_private_data *pdata = NULL;
 
-	/*triger*/
-	i2c_new_trigger_val = PCIE_FPGA_I2C_NEW_TRIGGER_VALUE + offset;
-	iowrite32(i2c_new_trigger_val, pdata->data_base_addr + 
-		  pdata->i2c_contrl_rtc0_config_1);
+	pdata = attr->private;
 
-	/*read done status*/
-	while(1) {
-		flag = ioread32(pdata->data_base_addr + 
-				pdata->i2c_contrl_rtc0_stats);
-		if(flag == 0) {
-			/*In normal case:
-			observed chk_state_cnt(10~120) times can get i2c rtc0 done status. */
-			if(chk_state_cnt > 500) {
-				flag = -EAGAIN;
-				break;
-			}
-			usleep_range(50, 100);
-			chk_state_cnt++;
-			continue;
-		} else {
-			break;
-		}
-	}
-	msleep(1);
+	/*Select i2c protocol profile*/
+	iowrite32(0x1, pdata->data_base_addr + pdata->i2c_mgmt_rtc0_profile);
 
-	return flag;
+	/*
+	 * Prepare date to set into data registor: only the word carrying the
+	 * EEPROM_ALLOW_SET_LEN byte is sent, the rest is never looked at.
+	 */
+	iowrite32(data[0], pdata->data_base_addr + pdata->i2c_rtc_write_data);
+
+	/*write to slave addr*/
+	return fpga_i2c_xfer(pdata, EEPROM_ALLOW_SET_LEN | (i2c_slave_addr << 8), 
+			     PCIE_FPGA_I2C_NEW_TRIGGER_VALUE + offset);
 }
 
 static ssize_t fpga_i2c_read_data(struct bin_attribute *attr, u8 *data)
@@ -2941,19 +3297,171 @@ static int get_port_present_status(struct bin_attribute *attr)
 	return present;
 }
 
+/*
+ * Select a page on the paged address of the port (0x51 on SFP), skipping
+ * the write when the module is known to be on it already.
+ */
+static int fpga_eeprom_select_page(struct bin_attribute *attr, int page, 
+				   int i2c_slave_addr)
+{
+	int state;
+	char set_page_num[1] = {0};
+	struct eeprom_bin_private_data *pdata = attr->private;
+	struct eeprom_cache *cache = &fpga_ctl->eeprom_cache[pdata->port_num - 1];
+
+	if(cache->cur_page == page) {
+		cache->stats.selects_skipped++;
+		return 1;
+	}
+
+	set_page_num[0] = page;
+	state = fpga_i2c_set_data(attr, OPTOE_PAGE_SELECT_REG, set_page_num,
+				  i2c_slave_addr);
+	cache->cur_page = (state == 1) ? page : -1;
+
+	return state;
+}
+
+/* read one 128-byte slice of the eeprom bin file from the module */
+static int fpga_eeprom_fetch(struct bin_attribute *attr, int slice, u8 *data)
+{
+	int state = 0;
+	int page_num;
+	struct eeprom_bin_private_data *pdata = attr->private;
+
+	if(slice == 0){
+		if((state = fpga_i2c_ready_to_read(attr, EEPROM_LOWER_PAGE, 
+			pdata->i2c_slave_addr)) != 1)
+			return state;
+	} else if((slice == 1) && (pdata->port_num > FPGA_QSFP_PORT_NUM)){
+		/*sfp a0 upper half, not paged*/
+		if((state = fpga_i2c_ready_to_read(attr, EEPROM_UPPER_PAGE, 
+			pdata->i2c_slave_addr)) != 1)
+			return state;
+	} else if( pdata->port_num <= FPGA_QSFP_PORT_NUM){ /*qsfp page0~0xff*/
+		page_num = slice - 1;
+		if( (state = fpga_eeprom_select_page(attr, page_num, 
+			pdata->i2c_slave_addr)) != 1)
+			return state;
+
+		if((state = fpga_i2c_ready_to_read(attr, 
+			EEPROM_UPPER_PAGE, 
+			pdata->i2c_slave_addr)) != 1)
+			return state;
+	} else {/*sfp support a2(0x51), cat behind a0(0x50)*/
+		page_num = slice - 1;
+		if(page_num == 1){ /*a2 lower page*/
+			if((state = fpga_i2c_ready_to_read(attr, 
+				EEPROM_LOWER_PAGE, 
+				TWO_ADDR_0X51)) != 1)
+				return state;
+		} else { /*a2 page0, then page from 1*/
+			if((state = fpga_eeprom_select_page(attr, 
+				page_num - 2, TWO_ADDR_0X51)) != 1)
+				return state;
+
+			if((state = fpga_i2c_ready_to_read(attr, 
+				EEPROM_UPPER_PAGE, TWO_ADDR_0X51)) != 1)
+				return state;
+		}
+	}
+	fpga_i2c_read_data(attr, data);
+
+	return state;
+}
+
+/* upper pages read ahead after a lower page miss, by module identifier */
+static const u8 cmis_prefetch_pages[] = {0x00, 0x01, 0x02};
+static const u8 sff8636_prefetch_pages[] = {0x00, 0x03};
+
+/*
+ * Slices holding clear-on-read latched flags: the lower page of both CMIS and
+ * SFF-8636, and the CMIS lane (11h) and VDM (2Ch~2Fh) flag pages. Reading one
+ * nobody asked for would drop its flag events, so prefetch never does.
+ */
+static bool fpga_eeprom_slice_latched(u8 identifier, int slice)
+{
+	if(slice == 0)
+		return true;
+	if(identifier != QSFPDD_TYPE)
+		return false;
+
+	return (slice - 1 == 0x11) || ((slice - 1 >= 0x2C) && (slice - 1 <= 0x2F));
+}
+
+static void fpga_eeprom_prefetch_queue(struct bin_attribute *attr, u8 *lower)
+{
+	struct eeprom_bin_private_data *pdata = attr->private;
+	struct eeprom_cache *cache = &fpga_ctl->eeprom_cache[pdata->port_num - 1];
+
+	if(!eeprom_prefetch || !eeprom_cache_ms || !pdata->pageable ||
+	   (pdata->port_num > FPGA_QSFP_PORT_NUM))
+		return;
+
+	cache->attr = attr;
+	cache->identifier = lower[0];
+	if(!test_and_set_bit(pdata->port_num - 1, fpga_ctl->prefetch_pending))
+		schedule_work(&fpga_ctl->prefetch_work);
+}
+
+static void fpga_eeprom_prefetch_port(int port)
+{
+	int i, cnt;
+	const u8 *pages;
+	u8 data[OPTOE_PAGE_SIZE];
+	struct eeprom_cache *cache = &fpga_ctl->eeprom_cache[port];
+	struct eeprom_bin_private_data *pdata = cache->attr->private;
+	struct eeprom_cache_slot *slot = NULL;
+
+	if(!get_port_present_status(cache->attr))
+		return;
+
+	if(cache->identifier == QSFPDD_TYPE) {
+		pages = cmis_prefetch_pages;
+		cnt = ARRAY_SIZE(cmis_prefetch_pages);
+	} else {
+		pages = sff8636_prefetch_pages;
+		cnt = ARRAY_SIZE(sff8636_prefetch_pages);
+	}
+
+	for(i = 0; i < cnt; i++) {
+		if(fpga_eeprom_slice_latched(cache->identifier, pages[i] + 1))
+			continue;
+		slot = fpga_eeprom_cache_find(pdata, pages[i] + 1);
+		if(slot && fpga_eeprom_cache_fresh(pdata, slot))
+			continue;
+		if(fpga_eeprom_fetch(cache->attr, pages[i] + 1, data) != 1)
+			break;
+		fpga_eeprom_cache_insert(pdata, pages[i] + 1, data);
+		cache->stats.prefetched++;
+	}
+}
+
+/* one port per update_lock hold, so readers get in between */
+static void fpga_eeprom_prefetch_work(struct work_struct *work)
+{
+	int port;
+
+	for(port = 0; port < FPGA_PORT_NUM; port++) {
+		if(!test_and_clear_bit(port, fpga_ctl->prefetch_pending))
+			continue;
+		mutex_lock(&update_lock);
+		fpga_eeprom_prefetch_port(port);
+		mutex_unlock(&update_lock);
+	}
+}
+
 static ssize_t
 sfp_eeprom_read(struct file *filp, struct kobject *kobj,
              struct bin_attribute *attr,
-             char *buf, loff_t off, size_t count, int *page)
+             char *buf, loff_t off, size_t count)
 {
 	int state = 0;
-	int page_num, slice;
-	char set_page_num[1] = {0};
+	int slice;
 	struct eeprom_bin_private_data *pdata = NULL;
+	struct eeprom_cache_slot *slot = NULL;
 	pdata = attr->private;
 
-	ssize_t byte_cnt;
-
 	u8 data[128] = {0};
 
 	slice = off / OPTOE_PAGE_SIZE;
@@ -2961,72 +3469,19 @@ sfp_eeprom_read(struct file *filp, struct kobject *kobj,
 	if ((off + count) > (slice * OPTOE_PAGE_SIZE + OPTOE_PAGE_SIZE))
 		count = slice * OPTOE_PAGE_SIZE + OPTOE_PAGE_SIZE - off;
 
-	if(slice == 0){
-		if((state = fpga_i2c_ready_to_read(attr, EEPROM_LOWER_PAGE, 
-			pdata->i2c_slave_addr)) != 1)
-			goto exit_err;
-
-		byte_cnt = fpga_i2c_read_data(attr, &data[0]);
-	} else if(slice == 1){
-		if((state = fpga_i2c_ready_to_read(attr, EEPROM_UPPER_PAGE, 
-			pdata->i2c_slave_addr)) != 1)
-			goto exit_err;
+	slot = fpga_eeprom_cache_lookup(pdata, slice);
+	if(slot) {
+		memcpy(buf, &slot->data[off%128], count);
+		return count;
+	}
 
-		byte_cnt = fpga_i2c_read_data(attr, &data[0]);
-	} else {
-		page_num = slice - 1;
-		if( pdata->port_num <= FPGA_QSFP_PORT_NUM){ /*qsfp page1~0xff*/
-			set_page_num[0] = page_num;
-			if( (state = fpga_i2c_set_data(attr, 
-				OPTOE_PAGE_SELECT_REG, set_page_num, 
-				pdata->i2c_slave_addr)) != 1)
-				goto exit_err;
+	if((state = fpga_eeprom_fetch(attr, slice, data)) != 1)
+		goto exit_err;
 
-			if((state = fpga_i2c_ready_to_read(attr, 
-				EEPROM_UPPER_PAGE, 
-				pdata->i2c_slave_addr)) != 1)
-				goto exit_err;
+	fpga_eeprom_cache_insert(pdata, slice, data);
+	if(slice == 0)
+		fpga_eeprom_prefetch_queue(attr, data);
 
-			byte_cnt = fpga_i2c_read_data(attr, &data[byte_cnt]);
-			*page = page_num;
-		} else {/*sfp support a2(0x51), cat behind a0(0x50)*/
-			if(page_num == 1){ /*a2 lower page*/
-				if((state = fpga_i2c_ready_to_read(attr, 
-					EEPROM_LOWER_PAGE, 
-					TWO_ADDR_0X51)) != 1)
-					goto exit_err;
-
-				byte_cnt = fpga_i2c_read_data(attr, &data[0]);
-			} else if (page_num == 2){ /*a2 page0*/
-				set_page_num[0] = 0;
-				if((state = fpga_i2c_set_data(attr, 
-					OPTOE_PAGE_SELECT_REG, set_page_num,
-					TWO_ADDR_0X51))!=1)
-					goto exit_err;
-
-				if((state = fpga_i2c_ready_to_read(attr, 
-					EEPROM_UPPER_PAGE, TWO_ADDR_0X51)) != 1)
-					goto exit_err;
-
-				byte_cnt = fpga_i2c_read_data(attr, &data[0]);
-			} else {
-				set_page_num[0] = page_num - 2;
-				if((state = fpga_i2c_set_data(attr, 
-					OPTOE_PAGE_SELECT_REG, set_page_num,
-					TWO_ADDR_0X51) != 1)) /*set page from 1*/
-					goto exit_err;
-
-				if((state = fpga_i2c_ready_to_read(attr, 
-					EEPROM_UPPER_PAGE, 
-					TWO_ADDR_0X51)) != 1)
-					goto exit_err;
-
-				byte_cnt = fpga_i2c_read_data(attr, 
-						&data[byte_cnt]);
-				*page = page_num-2;
-			}
-		}
-	}
 	memcpy(buf, &data[off%128], count);
 
 	return count;
@@ -3042,13 +3497,7 @@ static ssize_t sfp_bin_read(struct file *filp, struct kobject *kobj,
 	char *buf, loff_t off, size_t count)
 {
 	int present;
-	int page = 0;
-	int state = 0;
-	int i2c_slave_addr;
-	char set_page_num[1] ={0};
 	ssize_t retval = 0;
-	struct eeprom_bin_private_data *pdata = NULL;
-	pdata = attr->private;
 
 	if (unlikely(!count))
 		return count;
@@ -3070,8 +3519,7 @@ static ssize_t sfp_bin_read(struct file *filp, struct kobject *kobj,
 	while (count) {
 		ssize_t status;
 
-		status = sfp_eeprom_read(filp, kobj, attr, buf, off, count, 
-						&page);
+		status = sfp_eeprom_read(filp, kobj, attr, buf, off, count);
 		if (status <= 0) {
 			if (retval == 0)
 				retval = status;
@@ -3084,32 +3532,13 @@ static ssize_t sfp_bin_read(struct file *filp, struct kobject *kobj,
 		retval += status;
 	}
 	/*
-	 * return the page register to page 0 - why?
-	 * We either have to set the page register to 0 on every access
-	 * to it, or restore it to 0 whenever we change it.  Otherwise,
-	 * accesses to page 0 would actually go to whatever the last page
-	 * was.  Assume more accesses to page 0 than all other pages
-	 * combined, so less total accesses if we always leave it at page 0
+	 * Leave the page register where the last access put it: it is
+	 * tracked in cur_page and every upper page access, page 0 included,
+	 * selects its page only when it differs.
 	 */
-	if((page > 0) && (pdata->pageable)) {
-		i2c_slave_addr =
-		(pdata->port_num > FPGA_QSFP_PORT_NUM) ? 
-					TWO_ADDR_0X51 : pdata->i2c_slave_addr;
-
-		if((state = fpga_i2c_set_data(attr, OPTOE_PAGE_SELECT_REG, 
-			set_page_num, i2c_slave_addr)) != 1) { /*set page to 0*/
-			mutex_unlock(&update_lock);
-			goto exit_err;
-		}
-	}
 	mutex_unlock(&update_lock);
 
 	return retval;
-
-exit_err:
-	pcie_debug("%s ERROR(%d): Port%d pcie get done status failed!!!", show_date_time(), state, pdata->port_num);
-
-	return -EBUSY;
 }
 
 static ssize_t
@@ -3125,7 +3554,16 @@ sfp_eeprom_write(struct bin_attribute *attr, char *buf, loff_t off, size_t count
 	page_num = slice - 1;
 	offset = off;
 
-	if(page_num > 0){
+	if(pdata->port_num <= FPGA_QSFP_PORT_NUM) {
+		/*qsfp: the upper half is whatever page is selected*/
+		if(page_num >= 0) {
+			if((state = fpga_eeprom_select_page(attr, page_num, 
+					pdata->i2c_slave_addr)) != 1)
+				goto exit_err;
+
+			offset = OPTOE_PAGE_SIZE + (off % OPTOE_PAGE_SIZE);
+		}
+	} else if(page_num > 0){
 		set_page_num[0] = page_num;
 		if((state = fpga_i2c_set_data(attr, OPTOE_PAGE_SELECT_REG, 
 				set_page_num, pdata->i2c_slave_addr)) != 1)
@@ -3134,11 +3572,21 @@ sfp_eeprom_write(struct bin_attribute *attr, char *buf, loff_t off, size_t count
 		offset = OPTOE_PAGE_SIZE + (off % OPTOE_PAGE_SIZE);
 	}
 
-	if((state = fpga_i2c_set_data(attr, offset, buf, 
-			pdata->i2c_slave_addr)) != 1)
+	state = fpga_i2c_set_data(attr, offset, buf, pdata->i2c_slave_addr);
+
+	/* the write may land anywhere, including the page select register */
+	fpga_eeprom_cache_invalidate(pdata->port_num);
+	if(state != 1)
 		goto exit_err;
 
-	if(page_num > 0){
+	/*
+	 * Give the module its internal write cycle before the next access;
+	 * page select writes are register writes and need none.
+	 */
+	usleep_range(PCIE_FPGA_I2C_EEPROM_WRITE_US, 
+		     PCIE_FPGA_I2C_EEPROM_WRITE_US + 100);
+
+	if((pdata->port_num > FPGA_QSFP_PORT_NUM) && (page_num > 0)){
 		set_page_num[0] = 0;
 		if((state = fpga_i2c_set_data(attr, OPTOE_PAGE_SELECT_REG, 
 				set_page_num, pdata->i2c_slave_addr)) != 1)
@@ -3221,64 +3669,306 @@ static int check_qsfp_eeprom_pageable(struct bin_attribute *eeprom)
 	return pdata->pageable;
 }
 
-static int sfp_sysfs_eeprom_init(struct kobject *kobj, 
-				struct bin_attribute *eeprom)
+/*
+ * eeprom file size for the module in the port, read from its paging
+ * support. Called with update_lock held.
+ */
+static ssize_t sfp_eeprom_size(struct bin_attribute *eeprom)
 {
-	int err;
 	int ret;
 	int present = 0;
+	ssize_t size;
 	struct eeprom_bin_private_data *pdata = NULL;
 
 	pdata = eeprom->private;
 
-	sysfs_bin_attr_init(eeprom);
-	eeprom->attr.name   = EEPROM_SYSFS_NAME;
-	eeprom->attr.mode   = S_IWUSR | S_IRUGO;
-	eeprom->read        = sfp_bin_read;
-	eeprom->write       = sfp_bin_write;
-
-	mutex_lock(&update_lock);
-
 	present = get_port_present_status(eeprom);
 
 	if(pdata->port_num > FPGA_QSFP_PORT_NUM){ /*sfp*/
 		if( !present ) { /*unpresent*/
-			eeprom->size = TWO_ADDR_NO_0X51_SIZE;
+			size = TWO_ADDR_NO_0X51_SIZE;
 		} else {
 			ret = fpga_read_sfp_ddm_status_value(eeprom); /*check support_a2 and pageable*/
 			if(ret < 0) {
 				pcie_err("Err: PCIE device port eeprom is empty");
-				mutex_unlock(&update_lock);
 				return ret;
 			}
 
 			if(!(pdata->sfp_support_a2))/*no A2(0x51)*/
-				eeprom->size = TWO_ADDR_NO_0X51_SIZE;
+				size = TWO_ADDR_NO_0X51_SIZE;
 			else
-				eeprom->size = ((pdata->sfp_support_a2) && 
+				size = ((pdata->sfp_support_a2) && 
 						(!pdata->pageable) ) ? 
 						TWO_ADDR_EEPROM_UNPAGED_SIZE :
 						TWO_ADDR_EEPROM_SIZE;
 		}
 	} else { /*qsfp*/
 		if(!present)/*unpresent*/
-			eeprom->size = OPTOE_ARCH_PAGES;
+			size = OPTOE_ARCH_PAGES;
 		else
-			eeprom->size = (check_qsfp_eeprom_pageable(eeprom)) ? 
+			size = (check_qsfp_eeprom_pageable(eeprom)) ? 
 					ONE_ADDR_EEPROM_SIZE : 
 					ONE_ADDR_EEPROM_UNPAGED_SIZE;
 	}
 
+	return size;
+}
+
+static int sfp_sysfs_eeprom_init(struct kobject *kobj, 
+				struct bin_attribute *eeprom)
+{
+	int err;
+	ssize_t size;
+	struct eeprom_bin_private_data *pdata = NULL;
+
+	pdata = eeprom->private;
+
+	sysfs_bin_attr_init(eeprom);
+	eeprom->attr.name   = EEPROM_SYSFS_NAME;
+	eeprom->attr.mode   = S_IWUSR | S_IRUGO;
+	eeprom->read        = sfp_bin_read;
+	eeprom->write       = sfp_bin_write;
+
+	mutex_lock(&update_lock);
+	size = sfp_eeprom_size(eeprom);
 	mutex_unlock(&update_lock);
+	if(size < 0)
+		return size;
+	eeprom->size = size;
 
 	/* Create eeprom file */
 	err = sysfs_create_bin_file(kobj, eeprom);
 	if (err)
 		return err;
 
+	mutex_lock(&eeprom_resize_lock);
+	pdata->kobj = kobj;
+	mutex_unlock(&eeprom_resize_lock);
+
+	return 0;
+}
+
+static struct bin_attribute *fpga_port_eeprom(int port_num)
+{
+	if(port_num <= FPGA_UDB_QSFP_PORT_NUM)
+		return &pcie_udb_dev_platform_data[port_num - 1].eeprom_bin;
+
+	return &pcie_ldb_dev_platform_data[port_num - FPGA_UDB_QSFP_PORT_NUM - 1].eeprom_bin;
+}
+
+/*
+ * A port probed empty has a 256-byte eeprom file; give it the size of the
+ * module inserted since, the way an unbind/bind of the port device would.
+ * Returns 1 if the file was re-created, -EAGAIN if the port is present but
+ * its module still reads as the size of an empty port, 0 otherwise.
+ */
+static int sfp_eeprom_resize(int port_num)
+{
+	int ret = 0;
+	int present = 0;
+	ssize_t size = 0;
+	ssize_t empty_size = (port_num > FPGA_QSFP_PORT_NUM) ? 
+				TWO_ADDR_NO_0X51_SIZE : OPTOE_ARCH_PAGES;
+	struct bin_attribute *eeprom = fpga_port_eeprom(port_num);
+	struct eeprom_bin_private_data *pdata = eeprom->private;
+
+	mutex_lock(&eeprom_resize_lock);
+	if(!pdata->kobj)
+		goto exit;
+
+	mutex_lock(&update_lock);
+	present = get_port_present_status(eeprom);
+	if(present)
+		size = sfp_eeprom_size(eeprom);
+	mutex_unlock(&update_lock);
+	if(present && ((size <= 0) || (size == empty_size)))
+		ret = -EAGAIN;
+	if((size <= 0) || (size == eeprom->size))
+		goto exit;
+
+	/* drains readers of the old file, they take update_lock */
+	sysfs_remove_bin_file(pdata->kobj, eeprom);
+	eeprom->size = size;
+	if(sysfs_create_bin_file(pdata->kobj, eeprom)) {
+		pcie_err("Port%d cannot re-create eeprom file", port_num);
+		pdata->kobj = NULL;
+		goto exit;
+	}
+	pcie_info("Port%d eeprom size %zd", port_num, size);
+	if(ret == 0)
+		ret = 1;
+
+exit:
+	mutex_unlock(&eeprom_resize_lock);
+	return ret;
+}
+
+static void fpga_eeprom_resize_arm(int port_num)
+{
+	fpga_ctl->resize_until[port_num - 1] = jiffies + 
+				msecs_to_jiffies(eeprom_resize_ms);
+	set_bit(port_num - 1, fpga_ctl->resize_pending);
+}
+
+/*
+ * Poll the present registers; on a change fix up the eeprom files of the
+ * inserted ports first, then wake the pollers of module_present_all. A port
+ * whose module is not readable yet is retried on the following polls and
+ * notified again once its eeprom file has been resized.
+ */
+static void fpga_present_work(struct work_struct *work)
+{
+	int port, ret;
+	bool resized = false;
+	u64 qsfp_changed;
+	u32 sfp_changed;
+	char present_all[32];
+	char *envp[] = { "EVENT=MODULE_PRESENCE", present_all, NULL };
+
+	mutex_lock(&update_lock);
+	fpga_update_port_status();
+	qsfp_changed = fpga_ctl->qsfp_present_changed;
+	sfp_changed = fpga_ctl->sfp_present_changed;
+	fpga_ctl->qsfp_present_changed = 0;
+	fpga_ctl->sfp_present_changed = 0;
+	snprintf(present_all, sizeof(present_all), "PRESENT_ALL=0x%.1x%.16llx",
+		 fpga_ctl->sfp_present_map, fpga_ctl->qsfp_present_map);
+	mutex_unlock(&update_lock);
+
+	for(port = 0; port < QSFP_NUM_OF_PORT; port++)
+		if((qsfp_changed >> port) & 0x1)
+			fpga_eeprom_resize_arm(port + 1);
+	for(port = 0; port < SFP_NUM_OF_PORT; port++)
+		if((sfp_changed >> port) & 0x1)
+			fpga_eeprom_resize_arm(FPGA_LDB_SFP_PORT1_NO + port);
+
+	for_each_set_bit(port, fpga_ctl->resize_pending, FPGA_PORT_NUM) {
+		ret = sfp_eeprom_resize(port + 1);
+		if(ret > 0)
+			resized = true;
+		if((ret != -EAGAIN) || 
+		   time_after(jiffies, fpga_ctl->resize_until[port]))
+			clear_bit(port, fpga_ctl->resize_pending);
+	}
+
+	if(qsfp_changed || sfp_changed || resized) {
+		sysfs_notify(&fpga_ctl->pdev->dev.kobj, NULL, "module_present_all");
+		kobject_uevent_env(&fpga_ctl->pdev->dev.kobj, KOBJ_CHANGE, envp);
+	}
+
+	schedule_delayed_work(&fpga_ctl->present_work, 
+			      msecs_to_jiffies(present_poll_ms));
+}
+
+static int fpga_i2c_latency_show(struct seq_file *m, void *v)
+{
+	int port;
+	struct fpga_i2c_stats *st;
+
+	seq_printf(m, "%-6s %10s %10s %8s %8s %8s %8s %8s\n", "port", "xfers",
+		   "irq_done", "errors", "timeouts", "avg_us", "max_us", "last_us");
+	for(port = 0; port < ARRAY_SIZE(fpga_ctl->i2c_stats); port++) {
+		st = &fpga_ctl->i2c_stats[port];
+		if(!st->xfers)
+			continue;
+		seq_printf(m, "%-6d %10llu %10llu %8llu %8llu %8llu %8llu %8llu\n",
+			   port + 1, st->xfers, st->irq_done, st->errors, 
+			   st->timeouts, div64_u64(st->ns, st->xfers * NSEC_PER_USEC),
+			   div64_u64(st->max_ns, NSEC_PER_USEC),
+			   div64_u64(st->last_ns, NSEC_PER_USEC));
+	}
+
 	return 0;
 }
 
+static int fpga_i2c_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fpga_i2c_latency_show, inode->i_private);
+}
+
+/* any write clears the counters */
+static ssize_t fpga_i2c_latency_write(struct file *file, 
+		const char __user *ubuf, size_t count, loff_t *ppos)
+{
+	memset(fpga_ctl->i2c_stats, 0, sizeof(fpga_ctl->i2c_stats));
+
+	return count;
+}
+
+static const struct file_operations fpga_i2c_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = fpga_i2c_latency_open,
+	.read = seq_read,
+	.write = fpga_i2c_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void fpga_i2c_intr_enable(int fpga_no, u32 enable)
+{
+	int port_index;
+
+	if(fpga_no == PCI_SUBSYSTEM_ID_UDB) {
+		for(port_index = 0; port_index < FPGA_UDB_QSFP_PORT_NUM; port_index++)
+			iowrite32(enable, 
+				fpga_ctl->pci_fpga_dev[fpga_no].data_base_addr +
+				pcie_udb_eeprom_bin_private_data[port_index].i2c_mgmt_rtc0_intr_en);
+	} else {
+		for(port_index = 0; port_index < (FPGA_LDB_QSFP_PORT_NUM + FPGA_LDB_SFP_PORT_NUM); port_index++)
+			iowrite32(enable, 
+				fpga_ctl->pci_fpga_dev[fpga_no].data_base_addr +
+				pcie_ldb_eeprom_bin_private_data[port_index].i2c_mgmt_rtc0_intr_en);
+	}
+}
+
+/*
+ * Hook the RTC done interrupt of the UDB and LDB FPGA. A FPGA without a
+ * usable vector is left at -1 and its transactions are polled.
+ */
+static void fpga_i2c_irq_setup(void)
+{
+	int fpga_no, irq;
+	pci_fpga_device_t *fpga_dev = NULL;
+
+	for(fpga_no = PCI_SUBSYSTEM_ID_UDB; fpga_no <= PCI_SUBSYSTEM_ID_LDB; fpga_no++) {
+		fpga_dev = &fpga_ctl->pci_fpga_dev[fpga_no];
+		fpga_dev->irq = -1;
+		if(!i2c_irq)
+			continue;
+
+		if(pci_alloc_irq_vectors(fpga_dev->fpga_pdev, 1, 1, 
+					 PCI_IRQ_MSI | PCI_IRQ_INTX) < 0) {
+			pcie_info("[%s] no interrupt, polling i2c done", FPGA_NAME[fpga_no]);
+			continue;
+		}
+		irq = pci_irq_vector(fpga_dev->fpga_pdev, 0);
+		if(request_irq(irq, fpga_i2c_isr, IRQF_SHARED, FPGA_NAME[fpga_no], fpga_dev)) {
+			pcie_err("[%s] cannot request irq %d, polling i2c done", FPGA_NAME[fpga_no], irq);
+			pci_free_irq_vectors(fpga_dev->fpga_pdev);
+			continue;
+		}
+		fpga_dev->irq = irq;
+		fpga_i2c_intr_enable(fpga_no, 1);
+		pcie_info("[%s] i2c done on irq %d", FPGA_NAME[fpga_no], irq);
+	}
+}
+
+static void fpga_i2c_irq_teardown(void)
+{
+	int fpga_no;
+	pci_fpga_device_t *fpga_dev = NULL;
+
+	for(fpga_no = PCI_SUBSYSTEM_ID_UDB; fpga_no <= PCI_SUBSYSTEM_ID_LDB; fpga_no++) {
+		fpga_dev = &fpga_ctl->pci_fpga_dev[fpga_no];
+		if(fpga_dev->irq < 0)
+			continue;
+		fpga_i2c_intr_enable(fpga_no, 0);
+		free_irq(fpga_dev->irq, fpga_dev);
+		pci_free_irq_vectors(fpga_dev->fpga_pdev);
+		fpga_dev->irq = -1;
+	}
+}
+
 static int sys_fpga_stat_probe (struct platform_device *pdev)
 {
 	int cnt = 0, status = 0, port_index = 0;
@@ -3449,6 +4139,12 @@ static int sys_fpga_stat_probe (struct platform_device *pdev)
 
     for (cnt=0;cnt<QSFP_NUM_OF_PORT;cnt++) fpga_ctl->reset_list[cnt] = 0;
 
+	fpga_i2c_irq_setup();
+
+	fpga_ctl->debugfs = debugfs_create_dir(DRVNAME, NULL);
+	debugfs_create_file("i2c_latency", 0644, fpga_ctl->debugfs, NULL, 
+			    &fpga_i2c_latency_fops);
+
 	return 0;
 
 exit_pci_iounmap:
@@ -3471,6 +4167,12 @@ exit_pci_disable:
 static void sys_fpga_stat_remove(struct platform_device *pdev)
 {
 	int cnt = 0;
+
+	debugfs_remove_recursive(fpga_ctl->debugfs);
+	fpga_ctl->debugfs = NULL;
+	cancel_work_sync(&fpga_ctl->prefetch_work);
+	fpga_i2c_irq_teardown();
+
 	sysfs_remove_group(&pdev->dev.kobj, &fpga_port_stat_group);
 
 	for(cnt = (FPGA_NUM - 1); cnt >= 0; cnt--) {
@@ -3527,9 +4229,16 @@ static void __exit sys_fpga_sfp_remove(struct platform_device *pdev)
 {
 	struct pcie_fpga_dev_platform_data *pdata = NULL;
 
+	struct eeprom_bin_private_data *eeprom_pdata = NULL;
+
 	pdata = pdev->dev.platform_data;
+	eeprom_pdata = pdata->eeprom_bin.private;
 
-	sysfs_remove_bin_file(&pdev->dev.kobj, &pdata->eeprom_bin);
+	mutex_lock(&eeprom_resize_lock);
+	if(eeprom_pdata->kobj)
+		sysfs_remove_bin_file(&pdev->dev.kobj, &pdata->eeprom_bin);
+	eeprom_pdata->kobj = NULL;
+	mutex_unlock(&eeprom_resize_lock);
 	sysfs_remove_group(&pdev->dev.kobj, &fpga_eeprom_group);
 
 }
@@ -3567,6 +4276,7 @@ static int __init sys_fpga_init(void)
 	int err_cnt;
 
 	int udb_fpga_cnt = 0, ldb_fpga_cnt = 0, ldb_fpga_sfp_ddm_cnt = 0;
+	int port_index, slot_index;
 
 	/*Step1.
 	*Init UDB, LDB port status driver*/
@@ -3578,6 +4288,25 @@ static int __init sys_fpga_init(void)
 		platform_driver_unregister(&pcie_fpga_port_stat_driver);
 		goto exit;
 	}
+	init_waitqueue_head(&fpga_ctl->i2c_wq);
+	spin_lock_init(&fpga_ctl->i2c_lock);
+	fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_UDB].irq = -1;
+	fpga_ctl->pci_fpga_dev[PCI_SUBSYSTEM_ID_LDB].irq = -1;
+
+	fpga_ctl->eeprom_cache = vcalloc(FPGA_PORT_NUM, sizeof(struct eeprom_cache));
+	if (!fpga_ctl->eeprom_cache) {
+		status = -ENOMEM;
+		kfree(fpga_ctl);
+		fpga_ctl = NULL;
+		goto exit;
+	}
+	for (port_index = 0; port_index < FPGA_PORT_NUM; port_index++) {
+		fpga_ctl->eeprom_cache[port_index].cur_page = -1;
+		for (slot_index = 0; slot_index < EEPROM_CACHE_SLOTS; slot_index++)
+			fpga_ctl->eeprom_cache[port_index].slot[slot_index].slice = -1;
+	}
+	INIT_WORK(&fpga_ctl->prefetch_work, fpga_eeprom_prefetch_work);
+	INIT_DELAYED_WORK(&fpga_ctl->present_work, fpga_present_work);
 
 	status = platform_driver_register(&pcie_fpga_port_stat_driver);
 	if (status < 0)
@@ -3631,6 +4360,11 @@ static int __init sys_fpga_init(void)
 	}
 	pcie_info("Init LDB_FPGA driver and device.");
 
+	/*Step3. Presence change notification*/
+	if (present_poll_ms)
+		schedule_delayed_work(&fpga_ctl->present_work, 
+				      msecs_to_jiffies(present_poll_ms));
+
 	return 0;
 
 exit_ldb_fpga:
@@ -3644,6 +4378,7 @@ exit_udb_fpga:
 	platform_driver_unregister(&pcie_udb_fpga_driver);
 exit_pci:
 	platform_driver_unregister(&pcie_fpga_port_stat_driver);
+	vfree(fpga_ctl->eeprom_cache);
 	kfree(fpga_ctl);
 exit:
 	return status;
@@ -3653,6 +4388,8 @@ static void __exit sys_fpga_exit(void)
 {
 	int i = 0;
 
+	cancel_delayed_work_sync(&fpga_ctl->present_work);
+
 	/*LDB qsfp port33-64, sfp port65-66*/
 	for (i = 0; i < ARRAY_SIZE(pcie_ldb_qsfp_device); i++)
 		platform_device_unregister(&pcie_ldb_qsfp_device[i]);
@@ -3671,6 +4408,7 @@ static void __exit sys_fpga_exit(void)
 	platform_device_unregister(fpga_ctl->pdev);
 	platform_driver_unregister(&pcie_fpga_port_stat_driver);
 	pcie_info("Remove FPGA status driver.");
+	vfree(fpga_ctl->eeprom_cache);
 	kfree(fpga_ctl);
 }
 
@@ -29,7 +29,6 @@ UDB_NAME = "/sys/devices/platform/pcie_udb_fpga_device.{}/eeprom"
 LDB_NAME = "/sys/devices/platform/pcie_ldb_fpga_device.{}/eeprom"
 SCM_PATH = "/sys/bus/i2c/devices/51-0035/"
 SYS_LED_PATH = "/sys/devices/platform/sys_fpga/led_sys"
-MAX_SELECT_DELAY = 10
 
 # Device counts
 FAN_DRAWERS = 4
@@ -166,9 +165,9 @@ class Chassis(ChassisBase):
         if wait_for_ever:
             # xrcvd will call this monitor loop in the "SYSTEM_READY" state
             # sonic_logger.log_info(" wait_for_ever get_change_event %d" % timeout)
-            timeout = MAX_SELECT_DELAY
+            # check_sfp_status blocks in poll() until sys_fpga notifies a change
             while True:
-                status = self.sfp_event.check_sfp_status(port_dict, timeout)
+                status = self.sfp_event.check_sfp_status(port_dict, 0)
                 if port_dict:
                     break
         else:
@@ -4,7 +4,7 @@
 try:
     import os
     import time
-    import subprocess
+    import select
     from sonic_py_common import logger
     from sonic_platform.sysfs import read_sysfs_file, write_sysfs_file
 except ImportError as e:
@@ -22,10 +22,12 @@ PORT_START = 1
 PORT_END = 66
 
 REG_DIR = "/sys/devices/platform/sys_fpga/"
-DRIVER_PATH = "/sys/bus/platform/drivers/pcie_{}_fpga_device/"
-PORT_NAME = "pcie_{}_fpga_device.{}"
 EEPROM_PATH = "/sys/devices/platform/pcie_{}_fpga_device.{}/eeprom"
 
+# sys_fpga notifies module_present_all on presence change and qsfp reset
+# handshake; the timeout only guards against a lost notification
+PRESENT_EVENT_MAX_WAIT = 10
+
 SYSLOG_IDENTIFIER = "sfp_event"
 sonic_logger = logger.Logger(SYSLOG_IDENTIFIER)
 sonic_logger.set_min_log_priority_info()
@@ -36,6 +38,8 @@ class SfpEvent:
     def __init__(self):
         self.handle = None
         self.modprs_list = []
+        self.present_file = None
+        self.poller = None
 
     def initialize(self):
         """
@@ -43,6 +47,11 @@ class SfpEvent:
         """
         # Get Transceiver status
         time.sleep(5)
+        # Arm the notification before the first read so no change is lost
+        self.present_file = open(REG_DIR + "module_present_all", 'r')
+        self.present_file.read()
+        self.poller = select.poll()
+        self.poller.register(self.present_file, select.POLLPRI | select.POLLERR)
         self.modprs_list = self._get_transceiver_status()
         sonic_logger.log_info(f"Initial SFP presence={str(self.modprs_list)}")
         if self.modprs_list[PORT_END-2]:
@@ -63,6 +72,19 @@ class SfpEvent:
         """
         Deinitialize SFP
         """
+        if self.present_file is not None:
+            self.poller.unregister(self.present_file)
+            self.present_file.close()
+            self.present_file = None
+
+    def _wait_present_event(self, timeout):
+        """
+        Block until sys_fpga notifies module_present_all or timeout (secs)
+        passes, then re-arm the notification by reading the attribute again
+        """
+        self.poller.poll(timeout * 1000)
+        self.present_file.seek(0)
+        self.present_file.read()
 
     def _get_transceiver_status(self):
         port_status = []
@@ -122,10 +144,9 @@ class SfpEvent:
                                 prefix = "ldb"
                                 port_index = i - QSFP_PORT_NUM // 2
                             eeprom_file = EEPROM_PATH.format(prefix, port_index)
-                            if os.path.getsize(eeprom_file) == 256:
-                                port_name = PORT_NAME.format(prefix, port_index)
-                                subprocess.run(f"echo {port_name} > {DRIVER_PATH.format(prefix)}"+"unbind", shell=True)
-                                subprocess.run(f"echo {port_name} > {DRIVER_PATH.format(prefix)}"+"bind", shell=True)
+                            # sys_fpga re-sizes the eeprom file before notifying,
+                            # still 256 bytes means the module could not be read
+                            # yet; sys_fpga retries it and notifies again once resized
                             if os.path.getsize(eeprom_file) == 256:
                                 port_change[i+1] = '0'
                                 port_status[i] = False
@@ -148,13 +169,10 @@ class SfpEvent:
                 return True, port_change
 
             if forever:
-                time.sleep(1)
+                self._wait_present_event(PRESENT_EVENT_MAX_WAIT)
             else:
                 timeout = end_time - time.time()
-                if timeout >= 1:
-                    time.sleep(1)  # We poll at 1 second granularity
-                else:
-                    if timeout > 0:
-                        time.sleep(timeout)
+                if timeout <= 0:
                     return True, {}
+                self._wait_present_event(timeout)
         return False, {}
@@ -32,15 +32,29 @@
 #include <linux/dmi.h>
 #include <linux/fs.h>
 #include <linux/delay.h>
+#include <linux/workqueue.h>
 #include <asm/uaccess.h>
 
 #define DRVNAME "h6_fan"
 
-#define I2C_RW_RETRY_COUNT			 (10)
-#define I2C_RW_RETRY_INTERVAL		  (60)	/* ms */
+#define I2C_RW_RETRY_COUNT			 (3)
+#define I2C_RW_RETRY_INTERVAL		  (5)	/* ms */
 
-static struct h6_fan_data *h6_fan_update_device(struct device
-							      *dev);
+static unsigned int poll_ms = 200;
+module_param(poll_ms, uint, S_IRUGO);
+MODULE_PARM_DESC(poll_ms, "Presence and tach poll period in ms for fan status notifications, 0 disables them (default: 200)");
+
+static unsigned int tach_fault_ms = 600;
+module_param(tach_fault_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(tach_fault_ms, "How long a driven rotor of a present fan must read 0 rpm before it is faulted, in ms (default: 600)");
+
+static unsigned int spinup_ms = 5000;
+module_param(spinup_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(spinup_ms, "How long a fan module must be present before its tach is checked, in ms (default: 5000)");
+
+struct h6_fan_data;
+static int h6_fan_update_device(struct h6_fan_data *data,
+				unsigned long classes);
 static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
 			      char *buf);
 static ssize_t set_duty_cycle(struct device *dev, struct device_attribute *da,
@@ -78,15 +92,45 @@ static const u8 fan_reg[] = {
 	0x27,			/* rear fan 3 speed(rpm) */
 };
 
+/* fan_reg[] grouped by how fast the registers change, each refreshed on its own
+ */
+enum fan_reg_class {
+	FAN_CLASS_VERSION,
+	FAN_CLASS_PRESENT,
+	FAN_CLASS_LED,
+	FAN_CLASS_PWM,
+	FAN_CLASS_SPEED,
+	FAN_CLASS_NUM
+};
+
+#define FAN_CLASS_STATUS	(BIT(FAN_CLASS_PRESENT) | BIT(FAN_CLASS_PWM) | \
+				 BIT(FAN_CLASS_SPEED))
+
+struct fan_reg_class_info {
+	u8 first;		/* fan_reg[] index */
+	u8 last;
+	unsigned int ttl_ms;	/* 0: read once */
+};
+
+#define FAN_ROTOR_NUM		8
+
 /* Each client has this additional data */
 struct h6_fan_data {
 	struct i2c_client *client;
 	struct device *hwmon_dev;
 	struct mutex update_lock;
-	char valid;		/* != 0 if registers are valid */
-	unsigned long last_updated;	/* In jiffies */
+	unsigned long class_valid;	/* BIT(fan_reg_class) if reg_val is valid */
+	unsigned long class_updated[FAN_CLASS_NUM];	/* In jiffies */
 	u8 reg_val[ARRAY_SIZE(fan_reg)];	/* Register value */
 	u8 reg_addr;
+	u8 present_mask;	/* bit per fan module */
+	u8 fault_mask;		/* bit per rotor, fanN_fault */
+	unsigned long present_since[FAN_ROTOR_NUM / 2];	/* In jiffies, 0 if absent */
+	unsigned long stalled_since[FAN_ROTOR_NUM];	/* In jiffies, 0 if turning */
+	bool notified_valid;
+	u8 present_notified;
+	u8 fault_notified;
+	struct delayed_work poll_work;
 };
 
 enum fan_id {
@@ -143,11 +187,29 @@ enum sysfs_fan_attributes {
 	FAN2_LED,
 	FAN3_LED,
 	FAN4_LED,
+	FAN1_FAULT,
+	FAN2_FAULT,
+	FAN3_FAULT,
+	FAN4_FAULT,
+	FAN5_FAULT,
+	FAN6_FAULT,
+	FAN7_FAULT,
+	FAN8_FAULT,
+	FAN_PRESENT_ALL,
+	FAN_FAULT_ALL,
 	FAN_FW_VERSION,
 	FAN_PCB_VERSION,
 	FAN_ACCESS
 };
 
+static const struct fan_reg_class_info fan_reg_class[FAN_CLASS_NUM] = {
+	[FAN_CLASS_VERSION] = { FAN_PCB_REG, FAN_MINOR_VERSION_REG, 0 },
+	[FAN_CLASS_PRESENT] = { FAN_PRESENT_REG, FAN_PRESENT_REG, 3000 },
+	[FAN_CLASS_LED] = { FAN_LED_REG, FAN_LED_REG, 3000 },
+	[FAN_CLASS_PWM] = { FAN1_FRONT_PWM_REG, FAN4_REAR_PWM_REG, 1500 },
+	[FAN_CLASS_SPEED] = { FAN1_FRONT_SPEED_RPM_REG, FAN4_REAR_SPEED_RPM_REG, 500 },
+};
+
 enum fan_led_light_mode {
 	FAN_LED_MODE_OFF,
 	FAN_LED_MODE_RED = 10,
@@ -171,6 +233,10 @@ enum fan_led_light_mode {
 								FAN##index2##_RPM); \
 	static SENSOR_DEVICE_ATTR(fan##index##_led, S_IRUGO, fan_show_value, NULL,\
 								FAN##index##_LED); \
+	static SENSOR_DEVICE_ATTR(fan##index##_fault, S_IRUGO, fan_show_value, NULL, \
+								FAN##index##_FAULT); \
+	static SENSOR_DEVICE_ATTR(fan##index2##_fault, S_IRUGO, fan_show_value, NULL, \
+								FAN##index2##_FAULT); \
 
 #define DECLARE_FAN_ATTR(index, index2) \
 	&sensor_dev_attr_fan##index##_present.dev_attr.attr, \
@@ -178,7 +244,17 @@ enum fan_led_light_mode {
 	&sensor_dev_attr_fan##index2##_pwm.dev_attr.attr, \
 	&sensor_dev_attr_fan##index##_input.dev_attr.attr, \
 	&sensor_dev_attr_fan##index2##_input.dev_attr.attr, \
-	&sensor_dev_attr_fan##index##_led.dev_attr.attr
+	&sensor_dev_attr_fan##index##_led.dev_attr.attr, \
+	&sensor_dev_attr_fan##index##_fault.dev_attr.attr, \
+	&sensor_dev_attr_fan##index2##_fault.dev_attr.attr
+
+#define DECLARE_FAN_STATUS_SENSOR_DEV_ATTR() \
+	static SENSOR_DEVICE_ATTR(fan_present_all, S_IRUGO, fan_show_value, NULL, FAN_PRESENT_ALL); \
+	static SENSOR_DEVICE_ATTR(fan_fault_all, S_IRUGO, fan_show_value, NULL, FAN_FAULT_ALL)
+
+#define DECLARE_FAN_STATUS_ATTR() \
+	&sensor_dev_attr_fan_present_all.dev_attr.attr, \
+	&sensor_dev_attr_fan_fault_all.dev_attr.attr
 
 #define DECLARE_FAN_FW_VERSION_SENSOR_DEV_ATTR() \
 	static SENSOR_DEVICE_ATTR(version, S_IRUGO, fan_show_value, NULL, FAN_FW_VERSION)
@@ -199,6 +275,7 @@ DECLARE_FAN_SENSOR_DEVICE_ATTR(1, 5);
 DECLARE_FAN_SENSOR_DEVICE_ATTR(2, 6);
 DECLARE_FAN_SENSOR_DEVICE_ATTR(3, 7);
 DECLARE_FAN_SENSOR_DEVICE_ATTR(4, 8);
+DECLARE_FAN_STATUS_SENSOR_DEV_ATTR();
 DECLARE_FAN_FW_VERSION_SENSOR_DEV_ATTR();
 DECLARE_FAN_PCB_VERSION_SENSOR_DEV_ATTR();
 DECLARE_FAN_ACCESS_SENSOR_DEV_ATTR();
@@ -209,6 +286,7 @@ static struct attribute *h6_fan_attributes[] = {
 	DECLARE_FAN_ATTR(2, 6),
 	DECLARE_FAN_ATTR(3, 7),
 	DECLARE_FAN_ATTR(4, 8),
+	DECLARE_FAN_STATUS_ATTR(),
 	DECLARE_FAN_FW_VERSION_ATTR(),
 	DECLARE_FAN_PCB_VERSION_ATTR(),
 	DECLARE_FAN_ACCESS_ATTR(),
@@ -226,7 +304,8 @@ static int h6_fan_read_value(struct i2c_client *client, u8 reg)
 	while (retry) {
 		status = i2c_smbus_read_byte_data(client, reg);
 		if (unlikely(status < 0)) {
-			msleep(I2C_RW_RETRY_INTERVAL);
+			usleep_range(I2C_RW_RETRY_INTERVAL * 1000,
+				     I2C_RW_RETRY_INTERVAL * 1000 + 1000);
 			retry--;
 			continue;
 		}
@@ -245,7 +324,8 @@ static int h6_fan_write_value(struct i2c_client *client, u8 reg,
 	while (retry) {
 		status = i2c_smbus_write_byte_data(client, reg, value);
 		if (unlikely(status < 0)) {
-			msleep(I2C_RW_RETRY_INTERVAL);
+			usleep_range(I2C_RW_RETRY_INTERVAL * 1000,
+				     I2C_RW_RETRY_INTERVAL * 1000 + 1000);
 			retry--;
 			continue;
 		}
@@ -312,7 +392,7 @@ static ssize_t set_duty_cycle(struct device *dev, struct device_attribute *da,
 					  fan_reg[FAN1_FRONT_PWM_REG + idx],
 					  reg_val);
 		/* force update register */
-		data->valid = 0;
+		data->class_valid &= ~BIT(FAN_CLASS_PWM);
 		mutex_unlock(&data->update_lock);
 		break;
 	default:
@@ -370,7 +450,7 @@ static ssize_t set_fan_led(struct device *dev, struct device_attribute *da,
 		h6_fan_write_value(data->client, fan_reg[FAN_LED_REG],
 					  reg_val);
 		/* force update register */
-		data->valid = 0;
+		data->class_valid &= ~BIT(FAN_CLASS_LED);
 		mutex_unlock(&data->update_lock);
 		break;
 	default:
@@ -380,16 +460,39 @@ static ssize_t set_fan_led(struct device *dev, struct device_attribute *da,
 	return count;
 }
 
+static unsigned long fan_attr_classes(int index)
+{
+	switch (index) {
+	case FAN_PCB_VERSION:
+	case FAN_FW_VERSION:
+		return BIT(FAN_CLASS_VERSION);
+	case FAN1_PWM ... FAN8_PWM:
+		return BIT(FAN_CLASS_PWM);
+	case FAN1_RPM ... FAN8_RPM:
+		return BIT(FAN_CLASS_SPEED);
+	case FAN1_PRESENT ... FAN4_PRESENT:
+		return BIT(FAN_CLASS_PRESENT);
+	case FAN1_LED ... FAN4_LED:
+		return BIT(FAN_CLASS_LED);
+	case FAN1_FAULT ... FAN_FAULT_ALL:
+		return FAN_CLASS_STATUS;
+	default:
+		return 0;
+	}
+}
+
 static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
 			      char *buf)
 {
 	struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-	struct h6_fan_data *data = h6_fan_update_device(dev);
+	struct h6_fan_data *data = dev_get_drvdata(dev);
 	ssize_t ret = 0;
 	u8 idx, reg_val;
+	int status;
 
-	if (!data->valid) {
-		return ret;
+	status = h6_fan_update_device(data, fan_attr_classes(attr->index));
+	if (status < 0) {
+		return status;
 	}
 
 	switch (attr->index) {
@@ -421,6 +524,16 @@ static ssize_t fan_show_value(struct device *dev, struct device_attribute *da,
 			      reg_val_to_led(data->reg_val[FAN_LED_REG],
 					       attr->index - FAN1_LED));
 		break;
+	case FAN1_FAULT ... FAN8_FAULT:
+		ret = sprintf(buf, "%d\n",
+			      (data->fault_mask >> (attr->index - FAN1_FAULT)) & 0x1);
+		break;
+	case FAN_PRESENT_ALL:
+		ret = sprintf(buf, "0x%x\n", data->present_mask);
+		break;
+	case FAN_FAULT_ALL:
+		ret = sprintf(buf, "0x%02x\n", data->fault_mask);
+		break;
 	default:
 		break;
 	}
@@ -472,7 +585,7 @@ static ssize_t reg_write(struct device *dev, struct device_attribute *da,
 		/* Write value to register */
 		mutex_lock(&data->update_lock);
 		h6_fan_write_value(data->client, input[0], input[1]);
-		data->valid = 0;
+		data->class_valid = 0;
 		mutex_unlock(&data->update_lock);
 		break;
 	case 1:
@@ -492,40 +605,162 @@ static const struct attribute_group h6_fan_group = {
 
 __ATTRIBUTE_GROUPS(h6_fan);
 
-static struct h6_fan_data *h6_fan_update_device(struct device
-							      *dev)
+/* Refresh the classes in the mask whose TTL ran out, caller holds update_lock */
+static int h6_fan_update_classes(struct h6_fan_data *data,
+				 unsigned long classes)
 {
-	struct h6_fan_data *data = dev_get_drvdata(dev);
+	int cls, i;
 
-	mutex_lock(&data->update_lock);
+	for_each_set_bit(cls, &classes, FAN_CLASS_NUM) {
+		const struct fan_reg_class_info *info = &fan_reg_class[cls];
 
-	if (time_after(jiffies, data->last_updated + HZ + HZ / 2) ||
-	    !data->valid) {
-		int i;
+		if (test_bit(cls, &data->class_valid) &&
+		    (!info->ttl_ms ||
+		     time_before(jiffies, data->class_updated[cls] +
+				 msecs_to_jiffies(info->ttl_ms))))
+			continue;
 
-		dev_dbg(dev, "Starting h6_fan update\n");
-		data->valid = 0;
+		dev_dbg(&data->client->dev, "Starting h6_fan update, class %d\n", cls);
+		clear_bit(cls, &data->class_valid);
 
-		/* Update fan data */
-		for (i = 0; i < ARRAY_SIZE(data->reg_val); i++) {
+		for (i = info->first; i <= info->last; i++) {
 			int status = h6_fan_read_value(data->client, fan_reg[i]);
 			if (status < 0) {
-				data->valid = 0;
-				mutex_unlock(&data->update_lock);
-				dev_dbg(dev, "reg %d, err %d\n", fan_reg[i],
-					status);
-				return data;
-			} else {
-				data->reg_val[i] = status;
+				dev_dbg(&data->client->dev, "reg %d, err %d\n",
+					fan_reg[i], status);
+				return status;
 			}
+			data->reg_val[i] = status;
+		}
+
+		data->class_updated[cls] = jiffies;
+		set_bit(cls, &data->class_valid);
+	}
+
+	return 0;
+}
+
+/*
+ * A rotor is faulted once its fan module has been present for spinup_ms, it is
+ * driven (pwm != 0) and its tach has read 0 rpm for tach_fault_ms; caller holds
+ * update_lock.
+ */
+static void h6_fan_update_status(struct h6_fan_data *data)
+{
+	u8 fault = 0, spun_up = 0;
+	int rotor, id;
+
+	data->present_mask = 0;
+	for (id = 0; id < FAN_ROTOR_NUM / 2; id++) {
+		if (!reg_val_to_is_present(data->reg_val[FAN_PRESENT_REG], id)) {
+			data->present_since[id] = 0;
+			continue;
 		}
+		data->present_mask |= BIT(id);
+		if (!data->present_since[id])
+			data->present_since[id] = jiffies | 1;
+		if (time_after_eq(jiffies, data->present_since[id] +
+				  msecs_to_jiffies(spinup_ms)))
+			spun_up |= BIT(id);
+	}
 
-		data->last_updated = jiffies;
-		data->valid = 1;
+	for (rotor = 0; rotor < FAN_ROTOR_NUM; rotor++) {
+		bool stalled = ((spun_up >> (rotor / 2)) & 0x1) &&
+			       (data->reg_val[FAN1_FRONT_PWM_REG + rotor] & FAN_DUTY_CYCLE_REG_MASK) &&
+			       !data->reg_val[FAN1_FRONT_SPEED_RPM_REG + rotor];
+
+		if (!stalled) {
+			data->stalled_since[rotor] = 0;
+			continue;
+		}
+		if (!data->stalled_since[rotor])
+			data->stalled_since[rotor] = jiffies | 1;
+		if (time_after_eq(jiffies, data->stalled_since[rotor] +
+				  msecs_to_jiffies(tach_fault_ms)))
+			fault |= BIT(rotor);
 	}
+	data->fault_mask = fault;
+}
+
+static int h6_fan_update_device(struct h6_fan_data *data,
+				unsigned long classes)
+{
+	int status;
 
+	mutex_lock(&data->update_lock);
+	status = h6_fan_update_classes(data, classes);
+	if (!status && (classes & FAN_CLASS_STATUS) == FAN_CLASS_STATUS)
+		h6_fan_update_status(data);
 	mutex_unlock(&data->update_lock);
-	return data;
+
+	return status;
+}
+
+static void h6_fan_notify(struct h6_fan_data *data, u8 present_changed,
+			  u8 fault_changed)
+{
+	struct kobject *kobj = &data->hwmon_dev->kobj;
+	char name[16], present_all[24], fault_all[24];
+	char *envp[] = { "EVENT=FAN_STATUS", present_all, fault_all, NULL };
+	int i;
+
+	for (i = 0; i < FAN_ROTOR_NUM; i++) {
+		if ((present_changed >> i) & 0x1) {
+			snprintf(name, sizeof(name), "fan%d_present", i + 1);
+			sysfs_notify(kobj, NULL, name);
+		}
+		if ((fault_changed >> i) & 0x1) {
+			snprintf(name, sizeof(name), "fan%d_fault", i + 1);
+			sysfs_notify(kobj, NULL, name);
+		}
+	}
+	if (present_changed)
+		sysfs_notify(kobj, NULL, "fan_present_all");
+	if (fault_changed)
+		sysfs_notify(kobj, NULL, "fan_fault_all");
+
+	snprintf(present_all, sizeof(present_all), "PRESENT_ALL=0x%x", data->present_notified);
+	snprintf(fault_all, sizeof(fault_all), "FAULT_ALL=0x%02x", data->fault_notified);
+	kobject_uevent_env(kobj, KOBJ_CHANGE, envp);
+}
+
+/*
+ * The fan CPLD raises no interrupt, so poll presence and tach here and wake the
+ * pollers of fanN_present, fanN_fault and the *_all files on a change.
+ */
+static void h6_fan_poll_work(struct work_struct *work)
+{
+	struct h6_fan_data *data = container_of(to_delayed_work(work),
+						struct h6_fan_data, poll_work);
+	u8 present_changed = 0, fault_changed = 0;
+
+	mutex_lock(&data->update_lock);
+	/* presence and tach are due every poll, pwm keeps its TTL */
+	data->class_valid &= ~(BIT(FAN_CLASS_PRESENT) | BIT(FAN_CLASS_SPEED));
+	if (h6_fan_update_classes(data, FAN_CLASS_STATUS) == 0) {
+		h6_fan_update_status(data);
+		if (data->notified_valid) {
+			present_changed = data->present_mask ^ data->present_notified;
+			fault_changed = data->fault_mask ^ data->fault_notified;
+		}
+
+		if (present_changed)
+			dev_info(&data->client->dev, "fan present 0x%x -> 0x%x\n",
+				 data->present_notified, data->present_mask);
+		if (fault_changed)
+			dev_warn(&data->client->dev, "fan tach fault 0x%02x -> 0x%02x\n",
+				 data->fault_notified, data->fault_mask);
+
+		data->present_notified = data->present_mask;
+		data->fault_notified = data->fault_mask;
+		data->notified_valid = true;
+	}
+	mutex_unlock(&data->update_lock);
+
+	if (present_changed || fault_changed)
+		h6_fan_notify(data, present_changed, fault_changed);
+
+	schedule_delayed_work(&data->poll_work, msecs_to_jiffies(poll_ms));
 }
 
 static int h6_fan_probe(struct i2c_client *client)
@@ -545,9 +780,10 @@ static int h6_fan_probe(struct i2c_client *client)
 	}
 
 	i2c_set_clientdata(client, data);
-	data->valid = 0;
+	data->class_valid = 0;
 	data->client = client;
 	mutex_init(&data->update_lock);
+	INIT_DELAYED_WORK(&data->poll_work, h6_fan_poll_work);
 
 	dev_info(&client->dev, "chip found\n");
 
@@ -562,6 +798,9 @@ static int h6_fan_probe(struct i2c_client *client)
 	dev_info(&client->dev, "%s: fan '%s'\n",
 		 dev_name(data->hwmon_dev), client->name);
 
+	if (poll_ms)
+		schedule_delayed_work(&data->poll_work, 0);
+
 	return 0;
 
  exit_free:
@@ -573,6 +812,7 @@ static int h6_fan_probe(struct i2c_client *client)
 static void h6_fan_remove(struct i2c_client *client)
 {
 	struct h6_fan_data *data = i2c_get_clientdata(client);
+	cancel_delayed_work_sync(&data->poll_work);
 	hwmon_device_unregister(data->hwmon_dev);
 	kfree(data);
 
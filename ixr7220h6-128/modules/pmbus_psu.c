@@ -15,6 +15,9 @@
 #include <linux/hwmon-sysfs.h>
 #include <linux/err.h>
 #include <linux/delay.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include "nokia_pmbus.h"
 
 /* PSU parameter */
 #define PSU_REG_OPERATION               (0x01)
@@ -46,30 +49,80 @@
 /* thermal in PSU */
 #define	PSU_THERMAL_NUMBER              (3)
 
+static uint snapshot_ms = 500;
+module_param(snapshot_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(snapshot_ms, "How long one telemetry snapshot is served to every attribute, in ms (default 500)");
+
+static uint vout_settle_ms = 30;
+module_param(vout_settle_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(vout_settle_ms, "Quiet time the PSU gets after a READ_VOUT before it is read again, in ms (default 30)");
+
 /* Address scanned */
 static const unsigned short normal_i2c[] = { 0x58, 0x59, 0x5a, 0x5b, I2C_CLIENT_END };
 
+/* Registers of one telemetry snapshot, in the order they are read; READ_VOUT goes last so the settle follows it */
+enum psu_snapshot_index
+{
+    PSU_SNAP_VOUT_MODE,
+    PSU_SNAP_FAN_STATUS,
+    PSU_SNAP_VIN,
+    PSU_SNAP_IIN,
+    PSU_SNAP_IOUT,
+    PSU_SNAP_PIN,
+    PSU_SNAP_POUT,
+    PSU_SNAP_TEMP1,
+    PSU_SNAP_TEMP2,
+    PSU_SNAP_TEMP3,
+    PSU_SNAP_FAN_SPEED,
+    PSU_SNAP_VOUT,
+    PSU_SNAP_REGS,
+};
+
+struct reg_data_len
+{
+    u8 reg;
+    u8 len;
+};
+
+static const struct reg_data_len psu_snapshot_regs[PSU_SNAP_REGS] = {
+    [PSU_SNAP_VOUT_MODE]  = {PSU_REG_RW_VOUT_MODE,  1},
+    [PSU_SNAP_FAN_STATUS] = {PSU_REG_RO_FAN_STATUS, 1},
+    [PSU_SNAP_VIN]        = {PSU_REG_RO_VIN,        2},
+    [PSU_SNAP_IIN]        = {PSU_REG_RO_IIN,        2},
+    [PSU_SNAP_IOUT]       = {PSU_REG_RO_IOUT,       2},
+    [PSU_SNAP_PIN]        = {PSU_REG_RO_PIN,        2},
+    [PSU_SNAP_POUT]       = {PSU_REG_RO_POUT,       2},
+    [PSU_SNAP_TEMP1]      = {PSU_REG_RO_TEMP1,      2},
+    [PSU_SNAP_TEMP2]      = {PSU_REG_RO_TEMP2,      2},
+    [PSU_SNAP_TEMP3]      = {PSU_REG_RO_TEMP3,      2},
+    [PSU_SNAP_FAN_SPEED]  = {PSU_REG_RO_FAN_SPEED,  2},
+    [PSU_SNAP_VOUT]       = {PSU_REG_RO_VOUT,       2},
+};
+
+#define PSU_SNAPSHOT_VERSION            (1)
+
+/* Layout of the psu_snapshot binary attribute */
+struct psu_snapshot
+{
+    u32 version;                        /* PSU_SNAPSHOT_VERSION */
+    u32 valid;                          /* bit n set if entry n read back in this pass */
+    u64 timestamp_ns;                   /* ktime_get_ns() at the end of the pass */
+    u8  reg[PSU_SNAP_REGS];             /* PMBus command of each entry */
+    u16 raw[PSU_SNAP_REGS];             /* register value, 0 if it did not read back */
+    s32 value[PSU_SNAP_REGS];           /* what the matching text attribute prints */
+} __packed;
+
 /* This is additional data */
 struct psu_data
 {
     struct mutex update_lock;
     char valid;
+    char combined;              /* adapter takes the whole pass as one i2c_transfer */
     unsigned long last_updated; /* In jiffies */
-    /* Registers value */
-    u8  vout_mode;
-    u16 v_in;
-    u16 v_out;
-    u16 i_in;
-    u16 i_out;
-    u16 p_in;
-    u16 p_out;
-    u16 temp_input[PSU_THERMAL_NUMBER];
-    u8  fan_fault;
-    u16 fan_speed[PSU_FAN_NUMBER];
+    unsigned long quiet_until;  /* In jiffies, end of the settle after READ_VOUT */
+    struct psu_snapshot snap;
 };
 
-static int     two_complement_to_int(u16 data, u8 valid_bit, int mask);
-static int     calculate_return_value(int value);
 static ssize_t for_vin(struct device *dev, struct device_attribute *dev_attr, char *buf);
 static ssize_t for_iin(struct device *dev, struct device_attribute *dev_attr, char *buf);
 static ssize_t for_iout(struct device *dev, struct device_attribute *dev_attr, char *buf);
@@ -84,7 +137,7 @@ static ssize_t for_vout_data(struct device *dev, struct device_attribute *dev_at
 static int     psu_read_byte(struct i2c_client *client, u8 reg);
 static int     psu_read_word(struct i2c_client *client, u8 reg);
 static int     psu_read_block(struct i2c_client *client, u8 command, u8 *data);
-static struct  psu_data *psu_update_device(struct device *dev, u8 reg);
+static struct  psu_data *psu_update_device(struct device *dev);
 static ssize_t for_serial(struct device *dev, struct device_attribute *dev_attr, char *buf);
 static ssize_t for_model(struct device *dev, struct device_attribute *dev_attr, char *buf);
 
@@ -106,114 +159,84 @@ enum psu_sysfs_attributes
     PSU_MFR_SERIAL,
 };
 
-static int two_complement_to_int(u16 data, u8 valid_bit, int mask)
-{
-    u16  valid_data  = data & mask;
-    bool is_negative = valid_data >> (valid_bit - 1);
-
-    return is_negative ? (-(((~valid_data) & mask) + 1)) : valid_data;
-}
-
-static int calculate_return_value(int value)
-{
-    int multiplier = 1000;
-    int exponent = 0, mantissa = 0;
-
-    exponent = two_complement_to_int(value >> 11, 5, 0x1f);
-    mantissa = two_complement_to_int(value & 0x7ff, 11, 0x7ff);
-
-    return (exponent >= 0) ? (mantissa << exponent) * multiplier : (mantissa * multiplier) / (1 << -exponent);
-
-}
-
 static ssize_t for_vin(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_VIN);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->v_in));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_VIN]);
 }
 
 static ssize_t for_iin(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_IIN);
-
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->i_in));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_IIN]);
 }
 
 static ssize_t for_iout(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_IOUT);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->i_out));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_IOUT]);
 }
 
 static ssize_t for_pin(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_PIN);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->p_in));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_PIN]);
 }
 
 static ssize_t for_pout(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_POUT);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->p_out));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_POUT]);
 }
 
 static ssize_t for_temp1(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_TEMP1);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->temp_input[0]));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_TEMP1]);
 }
 
 static ssize_t for_temp2(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_TEMP2);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->temp_input[1]));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_TEMP2]);
 }
 
 static ssize_t for_temp3(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_TEMP3);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->temp_input[2]));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_TEMP3]);
 }
 
 static ssize_t for_fan_speed(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_FAN_SPEED);
+    struct psu_data *data = psu_update_device(dev);
 
-    return sprintf(buf, "%d\n", calculate_return_value(data->fan_speed[0])/1000);
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_FAN_SPEED]);
 }
 
 static ssize_t for_vout_data(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RW_VOUT_MODE);
-    int exponent = 0, mantissa = 0;
-    int multiplier = 1000;
-
-    data = psu_update_device(dev, PSU_REG_RO_VOUT);
-    mdelay(30);
-    exponent = two_complement_to_int(data->vout_mode, 5, 0x1f);
-    mantissa = data->v_out;
+    struct psu_data *data = psu_update_device(dev);
 
-    return (exponent > 0) ? sprintf(buf, "%d\n", \
-        mantissa * (1 << exponent)) : \
-        sprintf(buf, "%d\n", (mantissa * multiplier) / (1 << -exponent));
+    return sprintf(buf, "%d\n", data->snap.value[PSU_SNAP_VOUT]);
 }
 
 static ssize_t for_fan_fault(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
     struct sensor_device_attribute *attr = to_sensor_dev_attr(dev_attr);
-    struct psu_data *data = psu_update_device(dev, PSU_REG_RO_FAN_STATUS);
+    struct psu_data *data = psu_update_device(dev);
     
     u8 shift = (attr->index == PSU_FAN1_FAULT) ? PSU_FAN1_FAULT_BIT : (PSU_FAN1_FAULT_BIT - (attr->index - PSU_FAN1_FAULT));
 
-    return sprintf(buf, "%d\n", data->fan_fault >> shift);
+    return sprintf(buf, "%d\n", data->snap.raw[PSU_SNAP_FAN_STATUS] >> shift);
 }
 
 static ssize_t for_model(struct device *dev, struct device_attribute *dev_attr, char *buf)
@@ -288,88 +311,112 @@ abort:
     return result;
 }
 
-struct reg_data_byte
+/*
+ * Every snapshot register in one i2c_transfer: a command write and a repeated-start read per register, so the
+ * adapter is locked once per pass and nothing else reaches the PSU in between.
+ */
+static int psu_read_combined(struct i2c_client *client, u8 *rx)
 {
-    u8 reg;
-    u8 *value;
-};
+    struct i2c_msg msgs[2 * PSU_SNAP_REGS];
+    u8 cmd[PSU_SNAP_REGS];
+    int i, status;
+
+    for (i = 0; i < PSU_SNAP_REGS; i++)
+    {
+        cmd[i] = psu_snapshot_regs[i].reg;
+        msgs[2 * i].addr = client->addr;
+        msgs[2 * i].flags = 0;
+        msgs[2 * i].len = 1;
+        msgs[2 * i].buf = &cmd[i];
+        msgs[2 * i + 1].addr = client->addr;
+        msgs[2 * i + 1].flags = I2C_M_RD;
+        msgs[2 * i + 1].len = psu_snapshot_regs[i].len;
+        msgs[2 * i + 1].buf = &rx[2 * i];
+    }
+
+    status = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
+    if (status < 0)
+        return status;
+    return (status == ARRAY_SIZE(msgs)) ? 0 : -EIO;
+}
 
-struct reg_data_word
+/* The values the text attributes print, worked out once per pass */
+static void psu_decode_snapshot(struct psu_snapshot *snap)
 {
-    u8 reg;
-    u16 *value;
-};
+    int i;
+
+    for (i = PSU_SNAP_VIN; i < PSU_SNAP_REGS; i++)
+        snap->value[i] = pmbus_linear11(snap->raw[i], PMBUS_SCALE_MILLI);
 
-static struct psu_data *psu_update_device(struct device *dev, u8 reg)
+    snap->value[PSU_SNAP_FAN_STATUS] = snap->raw[PSU_SNAP_FAN_STATUS];
+    snap->value[PSU_SNAP_FAN_SPEED] = pmbus_linear11(snap->raw[PSU_SNAP_FAN_SPEED], PMBUS_SCALE_UNIT);
+
+    /* READ_VOUT is LINEAR16 with the exponent in VOUT_MODE */
+    snap->value[PSU_SNAP_VOUT_MODE] = sign_extend32(snap->raw[PSU_SNAP_VOUT_MODE] & 0x1f, 4);
+    snap->value[PSU_SNAP_VOUT] = pmbus_linear16(snap->raw[PSU_SNAP_VOUT], snap->raw[PSU_SNAP_VOUT_MODE], PMBUS_SCALE_MILLI);
+}
+
+/*
+ * Reads the whole snapshot at most once per snapshot_ms; every attribute is served from it. The PSU gets
+ * vout_settle_ms of quiet after a pass, which only ever costs a sleep here when snapshot_ms is set below it.
+ */
+static struct psu_data *psu_update_device(struct device *dev)
 {
     struct i2c_client *client = to_i2c_client(dev);
     struct psu_data *data = i2c_get_clientdata(client);
     
     mutex_lock(&data->update_lock);
 
-    if (time_after(jiffies, data->last_updated)) 
+    if (!data->valid || time_after(jiffies, data->last_updated + msecs_to_jiffies(snapshot_ms)))
     {
+        struct psu_snapshot *snap = &data->snap;
+        u8  rx[2 * PSU_SNAP_REGS] = {0};
+        u32 valid = 0;
         int i, status;
 
-        struct reg_data_byte regs_byte[] = {
-                {PSU_REG_RW_VOUT_MODE,  &data->vout_mode},
-                {PSU_REG_RO_FAN_STATUS, &data->fan_fault}
-        };
-
-        struct reg_data_word regs_word[] = {
-                {PSU_REG_RO_VIN,       &data->v_in},
-                {PSU_REG_RO_VOUT,      &data->v_out},
-                {PSU_REG_RO_IIN,       &data->i_in},
-                {PSU_REG_RO_IOUT,      &data->i_out},
-                {PSU_REG_RO_POUT,      &data->p_out},
-                {PSU_REG_RO_PIN,       &data->p_in},
-                {PSU_REG_RO_TEMP1,     &(data->temp_input[0])},
-                {PSU_REG_RO_TEMP2,     &(data->temp_input[1])},
-                {PSU_REG_RO_TEMP3,     &(data->temp_input[2])},
-                {PSU_REG_RO_FAN_SPEED, &(data->fan_speed[0])},
-        };
-
-        //dev_info(&client->dev, "start data update\n");
-
-        /* one milliseconds from now */
-        data->last_updated = jiffies + HZ / 1000;
-
-        for (i = 0; i < ARRAY_SIZE(regs_byte); i++)
-        {
-            if (reg != regs_byte[i].reg)
-                continue;
+        if (data->valid && time_before(jiffies, data->quiet_until))
+            msleep(jiffies_to_msecs(data->quiet_until - jiffies));
 
-            status = psu_read_byte(client, regs_byte[i].reg);
-            if (status < 0)
-            {
-                dev_info(&client->dev, "reg %d, err %d\n", regs_byte[i].reg, status);
-                *(regs_byte[i].value) = 0;
-            }
-            else
+        if (data->combined && (psu_read_combined(client, rx) == 0))
+        {
+            valid = BIT(PSU_SNAP_REGS) - 1;
+        }
+        else
+        {
+            for (i = 0; i < PSU_SNAP_REGS; i++)
             {
-                *(regs_byte[i].value) = status;
+                if (psu_snapshot_regs[i].len == 1)
+                    status = psu_read_byte(client, psu_snapshot_regs[i].reg);
+                else
+                    status = psu_read_word(client, psu_snapshot_regs[i].reg);
+                if (status < 0)
+                {
+                    dev_info_ratelimited(&client->dev, "reg %d, err %d\n", psu_snapshot_regs[i].reg, status);
+                    continue;
+                }
+                rx[2 * i] = status & 0xff;
+                rx[2 * i + 1] = (status >> 8) & 0xff;
+                valid |= BIT(i);
             }
-            break;
         }
 
-        for (i = 0; i < ARRAY_SIZE(regs_word); i++)
+        for (i = 0; i < PSU_SNAP_REGS; i++)
         {
-            if (reg != regs_word[i].reg)
-                continue;
-
-            status = psu_read_word(client, regs_word[i].reg);
-            if (status < 0)
-            {
-                dev_info(&client->dev, "reg %d, err %d\n", regs_word[i].reg, status);
-                *(regs_word[i].value) = 0;
-            }
+            snap->reg[i] = psu_snapshot_regs[i].reg;
+            if (!(valid & BIT(i)))
+                snap->raw[i] = 0;
+            else if (psu_snapshot_regs[i].len == 1)
+                snap->raw[i] = rx[2 * i];
             else
-            {
-                *(regs_word[i].value) = status;
-            }
-            break;
+                snap->raw[i] = rx[2 * i] | (rx[2 * i + 1] << 8);
         }
+        psu_decode_snapshot(snap);
+        snap->version = PSU_SNAPSHOT_VERSION;
+        snap->valid = valid;
+        snap->timestamp_ns = ktime_get_ns();
 
+        data->last_updated = jiffies;
+        data->quiet_until = jiffies + msecs_to_jiffies(vout_settle_ms);
         data->valid = 1;
     }
 
@@ -377,6 +424,108 @@ static struct psu_data *psu_update_device(struct device *dev, u8 reg)
     return data;
 }
 
+/* One read at offset 0 returns every register of the same pass; later offsets return the rest of it */
+static ssize_t psu_snapshot_read(struct file *filp, struct kobject *kobj,
+    struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+    struct device *dev = kobj_to_dev(kobj);
+    struct psu_data *data = i2c_get_clientdata(to_i2c_client(dev));
+
+    if (off >= sizeof(data->snap))
+        return 0;
+    if (count > sizeof(data->snap) - off)
+        count = sizeof(data->snap) - off;
+
+    if (off == 0)
+        psu_update_device(dev);
+    mutex_lock(&data->update_lock);
+    memcpy(buf, (u8 *)&data->snap + off, count);
+    mutex_unlock(&data->update_lock);
+
+    return count;
+}
+
+/* hwmon channels, in hwmon units; the text attributes above keep their milli units */
+static const struct pmbus_sensor psu_sensors[] = {
+    {"vin",   hwmon_in,    0, PMBUS_LINEAR11, PSU_SNAP_VIN,       PMBUS_SCALE_MILLI},
+    {"vout",  hwmon_in,    1, PMBUS_LINEAR16, PSU_SNAP_VOUT,      PMBUS_SCALE_MILLI},
+    {"iin",   hwmon_curr,  0, PMBUS_LINEAR11, PSU_SNAP_IIN,       PMBUS_SCALE_MILLI},
+    {"iout",  hwmon_curr,  1, PMBUS_LINEAR11, PSU_SNAP_IOUT,      PMBUS_SCALE_MILLI},
+    {"pin",   hwmon_power, 0, PMBUS_LINEAR11, PSU_SNAP_PIN,       PMBUS_SCALE_MICRO},
+    {"pout",  hwmon_power, 1, PMBUS_LINEAR11, PSU_SNAP_POUT,      PMBUS_SCALE_MICRO},
+    {"temp1", hwmon_temp,  0, PMBUS_LINEAR11, PSU_SNAP_TEMP1,     PMBUS_SCALE_MILLI},
+    {"temp2", hwmon_temp,  1, PMBUS_LINEAR11, PSU_SNAP_TEMP2,     PMBUS_SCALE_MILLI},
+    {"temp3", hwmon_temp,  2, PMBUS_LINEAR11, PSU_SNAP_TEMP3,     PMBUS_SCALE_MILLI},
+    {"fan1",  hwmon_fan,   0, PMBUS_LINEAR11, PSU_SNAP_FAN_SPEED, PMBUS_SCALE_UNIT},
+};
+
+static umode_t psu_hwmon_is_visible(const void *drvdata, enum hwmon_sensor_types type, u32 attr, int channel)
+{
+    return S_IRUGO;
+}
+
+static int psu_hwmon_read(struct device *dev, enum hwmon_sensor_types type, u32 attr, int channel, long *val)
+{
+    struct psu_data *data = psu_update_device(dev->parent);
+    const struct pmbus_sensor *sensor = pmbus_sensor_find(psu_sensors, ARRAY_SIZE(psu_sensors), type, channel);
+    int status = 0;
+
+    if (!sensor)
+        return -EOPNOTSUPP;
+
+    mutex_lock(&data->update_lock);
+    if ((type == hwmon_fan) && (attr == hwmon_fan_fault))
+        *val = (data->snap.raw[PSU_SNAP_FAN_STATUS] >> PSU_FAN1_FAULT_BIT) & 0x1;
+    else if (!(data->snap.valid & BIT(sensor->index)))
+        status = -EIO;
+    else
+        *val = pmbus_sensor_value(sensor, data->snap.raw[sensor->index], data->snap.raw[PSU_SNAP_VOUT_MODE]);
+    mutex_unlock(&data->update_lock);
+
+    return status;
+}
+
+static int psu_hwmon_read_string(struct device *dev, enum hwmon_sensor_types type, u32 attr, int channel,
+                                 const char **str)
+{
+    const struct pmbus_sensor *sensor = pmbus_sensor_find(psu_sensors, ARRAY_SIZE(psu_sensors), type, channel);
+
+    if (!sensor)
+        return -EOPNOTSUPP;
+    *str = sensor->label;
+    return 0;
+}
+
+static const struct hwmon_channel_info *psu_hwmon_info[] = {
+    HWMON_CHANNEL_INFO(in,
+                       HWMON_I_INPUT | HWMON_I_LABEL,
+                       HWMON_I_INPUT | HWMON_I_LABEL),
+    HWMON_CHANNEL_INFO(curr,
+                       HWMON_C_INPUT | HWMON_C_LABEL,
+                       HWMON_C_INPUT | HWMON_C_LABEL),
+    HWMON_CHANNEL_INFO(power,
+                       HWMON_P_INPUT | HWMON_P_LABEL,
+                       HWMON_P_INPUT | HWMON_P_LABEL),
+    HWMON_CHANNEL_INFO(temp,
+                       HWMON_T_INPUT | HWMON_T_LABEL,
+                       HWMON_T_INPUT | HWMON_T_LABEL,
+                       HWMON_T_INPUT | HWMON_T_LABEL),
+    HWMON_CHANNEL_INFO(fan,
+                       HWMON_F_INPUT | HWMON_F_LABEL | HWMON_F_FAULT),
+    NULL
+};
+
+static const struct hwmon_ops psu_hwmon_ops = {
+    .is_visible = psu_hwmon_is_visible,
+    .read = psu_hwmon_read,
+    .read_string = psu_hwmon_read_string,
+};
+
+static const struct hwmon_chip_info psu_chip_info = {
+    .ops = &psu_hwmon_ops,
+    .info = psu_hwmon_info,
+};
+
 static ssize_t show_psu_rst(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
     struct i2c_client *client = to_i2c_client(dev);
@@ -477,13 +626,22 @@ static struct attribute *psu_attributes[] = {
     NULL
 };
 
+static BIN_ATTR(psu_snapshot, S_IRUGO, psu_snapshot_read, NULL, sizeof(struct psu_snapshot));
+
+static struct bin_attribute *psu_bin_attributes[] = {
+    &bin_attr_psu_snapshot,
+    NULL
+};
+
 static const struct attribute_group psu_group = {
     .attrs = psu_attributes,
+    .bin_attrs = psu_bin_attributes,
 };
 
 static int psu_probe(struct i2c_client *client)
 {
     struct psu_data *data;
+    struct device *hwmon_dev;
     int status;
 
     if (!i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_WORD_DATA | I2C_FUNC_SMBUS_BLOCK_DATA))
@@ -493,7 +651,7 @@ static int psu_probe(struct i2c_client *client)
         return status;
     }
 
-    data = kzalloc(sizeof(*data), GFP_KERNEL);
+    data = devm_kzalloc(&client->dev, sizeof(*data), GFP_KERNEL);
     if (!data) 
     {
         status = -ENOMEM;
@@ -502,6 +660,7 @@ static int psu_probe(struct i2c_client *client)
 
     i2c_set_clientdata(client, data);
     data->valid = 0;
+    data->combined = i2c_check_functionality(client->adapter, I2C_FUNC_I2C) && !client->adapter->quirks;
     mutex_init(&data->update_lock);
 
     dev_info(&client->dev, "%s found\n", PSU_DRIVER_NAME);
@@ -511,19 +670,24 @@ static int psu_probe(struct i2c_client *client)
     if (status)
     {
         dev_info(&client->dev, "sysfs_create_group failed!!!\n");
-        kfree(data);
         return status;
     }
 
+    hwmon_dev = devm_hwmon_device_register_with_info(&client->dev, PSU_DRIVER_NAME, data, &psu_chip_info, NULL);
+    if (IS_ERR(hwmon_dev))
+    {
+        dev_info(&client->dev, "hwmon_device_register failed!!!\n");
+        sysfs_remove_group(&client->dev.kobj, &psu_group);
+        return PTR_ERR(hwmon_dev);
+    }
+
     return 0;
 }
 
 static void psu_remove(struct i2c_client *client)
 {
-    struct psu_data *data = i2c_get_clientdata(client);
     sysfs_remove_group(&client->dev.kobj, &psu_group);
-    kfree(data);
-    
+
     return;
 }
 
@@ -557,7 +721,7 @@ static void __exit pmbus_psu_exit(void)
 MODULE_AUTHOR("DNI SW5");
 MODULE_DESCRIPTION("DNI PSU Driver");
 MODULE_LICENSE("GPL");
-MODULE_VERSION("0.0.3");
+MODULE_VERSION("0.0.4");
 
 module_init(pmbus_psu_init);
 module_exit(pmbus_psu_exit);
@@ -48,6 +48,7 @@ class Fan(FanBase):
             fan_index_dir = FAN_INDEX_IN_DRAWER[drawer_index][fan_index]
             self.set_fan_speed_reg = hwmon_path[0] + f"fan{fan_index_dir}_pwm"
             self.get_fan_speed_reg = hwmon_path[0] + f"fan{fan_index_dir}_input"
+            self.get_fan_fault_reg = hwmon_path[0] + f"fan{fan_index_dir}_fault"
             self.get_fan_presence_reg = hwmon_path[0] + f"fan{(drawer_index//2)+1}_present"
             self.fan_led_reg = hwmon_path[0] + f"fan{(drawer_index//2)+1}_led"
 
@@ -137,6 +138,10 @@ class Fan(FanBase):
         """
         status = False
 
+        # h6_fan raises fanN_fault as soon as a driven rotor stops turning
+        if read_sysfs_file(self.get_fan_fault_reg) == '1':
+            return status
+
         fan_speed = read_sysfs_file(self.get_fan_speed_reg)
         if (fan_speed != 'ERR'):
             if (int(fan_speed) > WORKING_FAN_SPEED):
@@ -10,6 +10,8 @@ try:
     from sonic_platform_base.psu_base import PsuBase
     from sonic_py_common import logger
     import os
+    import struct
+    import time
 except ImportError as e:
     raise ImportError(str(e) + ' - required module not found') from e
 
@@ -20,6 +22,13 @@ MIN_VOLTAGE = 180
 I2C_BUS = [136, 137, 138, 139]
 PSU_ADDR = ["58", "59", "5a", "5b"]
 EEPROM_ADDR = ['50', '51', '52', '53']
+# psu_snapshot is re-read at most this often, so one psud poll reads each PSU once
+SNAPSHOT_TTL = 1.0
+# struct psu_snapshot in pmbus_psu.c: version, valid, timestamp_ns, reg[12], raw[12], value[12]
+SNAPSHOT_FORMAT = '<IIQ12s12H12i'
+SNAPSHOT_VERSION = 1
+SNAPSHOT_LABELS = ['vout_mode', 'fan_status', 'vin', 'iin', 'iout', 'pin', 'pout',
+                   'temp1', 'temp2', 'temp3', 'fan_speed', 'vout']
 
 sonic_logger = logger.Logger('psu')
 sonic_logger.set_min_log_priority_info()
@@ -37,6 +46,35 @@ class Psu(PsuBase):
         self.new_psu_cmd = f"echo pmbus_psu 0x{PSU_ADDR[psu_index]} > /sys/bus/i2c/devices/i2c-{I2C_BUS[psu_index]}/new_device"
         self.new_eeprom_cmd = f"echo eeprom_fru 0x{EEPROM_ADDR[psu_index]} > /sys/bus/i2c/devices/i2c-{I2C_BUS[psu_index]}/new_device"
         self.del_eeprom_cmd = f"echo 0x{EEPROM_ADDR[psu_index]} > /sys/bus/i2c/devices/i2c-{I2C_BUS[psu_index]}/delete_device"
+        self._snapshot = {}
+        self._snapshot_time = 0.0
+
+    def _get_power_snapshot(self):
+        """
+        Reads every PMBus reading of the PSU in one go from the driver's
+        psu_snapshot attribute (mV, mA, mW, millidegree C, RPM)
+
+        Returns:
+            dict: reading label to integer value, only those that read back
+        """
+        now = time.monotonic()
+        if now - self._snapshot_time < SNAPSHOT_TTL:
+            return self._snapshot
+        snapshot = {}
+        try:
+            with open(self.psu_dir+"psu_snapshot", 'rb') as fd:
+                raw = fd.read(struct.calcsize(SNAPSHOT_FORMAT))
+            fields = struct.unpack(SNAPSHOT_FORMAT, raw)
+            version, valid, values = fields[0], fields[1], fields[-len(SNAPSHOT_LABELS):]
+            if version == SNAPSHOT_VERSION:
+                for i, label in enumerate(SNAPSHOT_LABELS):
+                    if (valid >> i) & 1:
+                        snapshot[label] = values[i]
+        except (IOError, struct.error):
+            pass
+        self._snapshot = snapshot
+        self._snapshot_time = now
+        return snapshot
 
     def _get_active_psus(self):
         """
@@ -147,8 +185,7 @@ class Psu(PsuBase):
             e.g. 12.1
         """
         if self.get_presence():
-            result = read_sysfs_file(self.psu_dir+"psu_v_in")
-            psu_voltage = (float(result))/1000
+            psu_voltage = self._get_power_snapshot().get("vin", 0)/1000
         else:
             psu_voltage = 0.0
 
@@ -162,8 +199,7 @@ class Psu(PsuBase):
             A float number, the electric current in amperes, e.g 15.4
         """
         if self.get_presence():
-            result = read_sysfs_file(self.psu_dir+"psu_i_in")
-            psu_current = (float(result))/1000
+            psu_current = self._get_power_snapshot().get("iin", 0)/1000
         else:
             psu_current = 0.0
 
@@ -177,8 +213,7 @@ class Psu(PsuBase):
             A float number, the power in watts, e.g. 302.6
         """
         if self.get_presence():
-            result = read_sysfs_file(self.psu_dir+"psu_p_in")
-            psu_power = (float(result))/1000
+            psu_power = self._get_power_snapshot().get("pin", 0)/1000
         else:
             psu_power = 0.0
 
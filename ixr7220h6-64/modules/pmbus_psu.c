@@ -13,6 +13,7 @@
 #include <linux/sysfs.h>
 #include <linux/hwmon.h>
 #include <linux/hwmon-sysfs.h>
+#include "nokia_pmbus.h"
 #include <linux/err.h>
 #include <linux/delay.h>
 
@@ -68,7 +69,6 @@ struct psu_data
     u16 fan_speed[PSU_FAN_NUMBER];
 };
 
-static int     two_complement_to_int(u16 data, u8 valid_bit, int mask);
 static int     calculate_return_value(int value);
 static ssize_t for_vin(struct device *dev, struct device_attribute *dev_attr, char *buf);
 static ssize_t for_iin(struct device *dev, struct device_attribute *dev_attr, char *buf);
@@ -106,24 +106,9 @@ enum psu_sysfs_attributes
     PSU_MFR_SERIAL,
 };
 
-static int two_complement_to_int(u16 data, u8 valid_bit, int mask)
-{
-    u16  valid_data  = data & mask;
-    bool is_negative = valid_data >> (valid_bit - 1);
-
-    return is_negative ? (-(((~valid_data) & mask) + 1)) : valid_data;
-}
-
 static int calculate_return_value(int value)
 {
-    int multiplier = 1000;
-    int exponent = 0, mantissa = 0;
-
-    exponent = two_complement_to_int(value >> 11, 5, 0x1f);
-    mantissa = two_complement_to_int(value & 0x7ff, 11, 0x7ff);
-
-    return (exponent >= 0) ? (mantissa << exponent) * multiplier : (mantissa * multiplier) / (1 << -exponent);
-
+    return pmbus_linear11(value, PMBUS_SCALE_MILLI);
 }
 
 static ssize_t for_vin(struct device *dev, struct device_attribute *dev_attr, char *buf)
@@ -193,17 +178,10 @@ static ssize_t for_fan_speed(struct device *dev, struct device_attribute *dev_at
 static ssize_t for_vout_data(struct device *dev, struct device_attribute *dev_attr, char *buf)
 {
     struct psu_data *data = psu_update_device(dev, PSU_REG_RW_VOUT_MODE);
-    int exponent = 0, mantissa = 0;
-    int multiplier = 1000;
 
     data = psu_update_device(dev, PSU_REG_RO_VOUT);
     mdelay(30);
-    exponent = two_complement_to_int(data->vout_mode, 5, 0x1f);
-    mantissa = data->v_out;
-
-    return (exponent > 0) ? sprintf(buf, "%d\n", \
-        mantissa * (1 << exponent)) : \
-        sprintf(buf, "%d\n", (mantissa * multiplier) / (1 << -exponent));
+    return sprintf(buf, "%ld\n", pmbus_linear16(data->v_out, data->vout_mode, PMBUS_SCALE_MILLI));
 }
 
 static ssize_t for_fan_fault(struct device *dev, struct device_attribute *dev_attr, char *buf)
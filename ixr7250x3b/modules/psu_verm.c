@@ -15,6 +15,7 @@
 #include <linux/sysfs.h>
 #include <linux/hwmon.h>
 #include <linux/hwmon-sysfs.h>
+#include "nokia_pmbus.h"
 #include <linux/err.h>
 #include <linux/of.h>
 #include <linux/delay.h>
@@ -45,7 +46,6 @@ struct psu_verm_data {
 	u16	fan_speed_input[2];
 };
 
-static int two_complement_to_int(u16 data, u8 valid_bit, int mask);
 static ssize_t set_fan_duty_cycle_input(struct device *dev, struct device_attribute \
 										*dev_attr, const char *buf, size_t count);
 static ssize_t for_linear_data(struct device *dev, struct device_attribute \
@@ -73,14 +73,6 @@ enum psu_verm_sysfs_attributes {
 	PSU_FAN1_SPEED,
 };
 
-static int two_complement_to_int(u16 data, u8 valid_bit, int mask)
-{
-	u16  valid_data  = data & mask;
-	bool is_negative = valid_data >> (valid_bit - 1);
-
-	return is_negative ? (-(((~valid_data) & mask) + 1)) : valid_data;
-}
-
 static ssize_t set_fan_duty_cycle_input(struct device *dev, struct device_attribute \
 				*dev_attr, const char *buf, size_t count)
 {
@@ -113,7 +105,6 @@ static ssize_t for_linear_data(struct device *dev, struct device_attribute \
 	struct psu_verm_data *data = psu_verm_update_device(dev);
 
 	u16 value = 0;
-	int exponent, mantissa;
 	int multiplier = 1000;
 	
 	switch (attr->index) {
@@ -152,12 +143,7 @@ static ssize_t for_linear_data(struct device *dev, struct device_attribute \
 		break;
 	}
 
-	exponent = two_complement_to_int(value >> 11, 5, 0x1f);
-	mantissa = two_complement_to_int(value & 0x7ff, 11, 0x7ff);
-
-	return (exponent >= 0) ? sprintf(buf, "%d\n",	\
-		(mantissa << exponent) * multiplier) :	\
-		sprintf(buf, "%d\n", (mantissa * multiplier) / (1 << -exponent));
+	return sprintf(buf, "%ld\n", pmbus_linear11(value, multiplier));
 }
 
 static ssize_t for_fan_target(struct device *dev, struct device_attribute \
@@ -175,16 +161,8 @@ static ssize_t for_vout_data(struct device *dev, struct device_attribute \
 		 					*dev_attr, char *buf)
 {
 	struct psu_verm_data *data = psu_verm_update_device(dev);
-	int exponent = 0;
-	int mantissa = 0;
-	int multiplier = 1000;
 
-	exponent = two_complement_to_int(data->vout_mode, 5, 0x1f);
-	mantissa = data->in2_input;
- 
-	return (exponent > 0) ? sprintf(buf, "%d\n", \
-		mantissa * (1 << exponent)) : \
-		sprintf(buf, "%d\n", (mantissa * multiplier) / (1 << -exponent));
+	return sprintf(buf, "%ld\n", pmbus_linear16(data->in2_input, data->vout_mode, PMBUS_SCALE_MILLI));
 }
 
 static int psu_verm_read_byte(struct i2c_client *client, u8 reg)
@@ -41,7 +41,8 @@ public:
         return myCardType;
     }
     std::string getPconDeviceBase(int index) {
-        return pcon_map[index];
+        auto it = pcon_map.find(index);
+        return (it != pcon_map.end()) ? it->second : "";
     }
     std::string getCPCtlDeviceBase(void) {
         return cpuctl_dev_path;
@@ -49,6 +50,12 @@ public:
     std::string getIOCtlDeviceBase(void) {
         return ioctl_dev_path;
     }
+    std::string getCtlFpgaRegsDevice(CtlFpgaId fpga_id) {
+        auto it = config_map.find((fpga_id == CTL_FPGA_IOCTL) ? "ioctl_regs" : "cpctl_regs");
+        if (it != config_map.end())
+            return it->second;
+        return (fpga_id == CTL_FPGA_IOCTL) ? "/dev/ctl_io_vermilion_regs" : "/dev/ctl_cp_vermilion_regs";
+    }
     std::string getSpiDevice(CtlFpgaId fpga_id, uint16_t channel) {
         return fmt::format("/dev/spidev{}.{}", (int)fpga_id, channel);
     }
@@ -139,6 +146,10 @@ std::string GetIOCtlDeviceBase(void)
 {
     return configuration_file::Configuration::Get().getIOCtlDeviceBase();
 }
+std::string GetCtlFpgaRegsDevice(CtlFpgaId fpga_id)
+{
+    return configuration_file::Configuration::Get().getCtlFpgaRegsDevice(fpga_id);
+}
 std::string GetSpiDevice(const tSpiParameters *spi_paramters)
 {
     CtlFpgaId fpga_id = (spi_paramters->fpga_id == CTL_FPGA_DEFAULT) ? ctl_fpga_id_default() : spi_paramters->fpga_id;
@@ -0,0 +1,183 @@
+/*
+ * Sweep time of concurrent transceiver EEPROM readers on the cpuctl mux channels, with and
+ * without the modsel scheduler.
+ *
+ *   cpuctl_i2c_sweep -b <first bus> -n <ports> [-t <threads>] [-r <reads per port>] [-s <chan_sched path>]
+ *
+ * Each thread reads the lower page of every port (-r 128-byte reads at 0x50) starting at its own
+ * offset, so the threads keep hitting different modules like xcvrd's DOM, CMIS and SFP state
+ * threads do. The sweep runs once with /sys/module/cpuctl/parameters/i2c_sched=0 and once with 1;
+ * for each it prints the wall time, and with -s the modsel switches and mean queue wait summed
+ * from the cpuctl chan_sched attribute (which is cleared before each run). cpuctl only installs
+ * the scheduler when it is loaded with i2c_sched=1; the sweep flips the parameter after that and
+ * puts it back when done.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#define SCHED_PARAM "/sys/module/cpuctl/parameters/i2c_sched"
+
+static unsigned first_bus, num_ports, num_threads = 4, reads = 2;
+static unsigned long errors;
+static pthread_mutex_t err_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int read_chunk(int fd, uint8_t offset, uint8_t *buf)
+{
+    struct i2c_msg msgs[2] = {
+        { .addr = 0x50, .flags = 0,        .len = 1,   .buf = &offset },
+        { .addr = 0x50, .flags = I2C_M_RD, .len = 128, .buf = buf },
+    };
+    struct i2c_rdwr_ioctl_data xfer = { .msgs = msgs, .nmsgs = 2 };
+    return ioctl(fd, I2C_RDWR, &xfer) < 0 ? -1 : 0;
+}
+
+static void *sweeper(void *arg)
+{
+    unsigned t = (unsigned)(uintptr_t)arg;
+    uint8_t buf[128];
+    char path[32];
+
+    for (unsigned i = 0; i < num_ports; i++) {
+        unsigned port = (i + t * num_ports / num_threads) % num_ports;
+        snprintf(path, sizeof(path), "/dev/i2c-%u", first_bus + port);
+        int fd = open(path, O_RDWR);
+        if (fd < 0)
+            goto fail;
+        for (unsigned r = 0; r < reads; r++) {
+            if (read_chunk(fd, (r & 1) * 128, buf) < 0) {
+                close(fd);
+                goto fail;
+            }
+        }
+        close(fd);
+        continue;
+fail:
+        pthread_mutex_lock(&err_lock);
+        errors++;
+        pthread_mutex_unlock(&err_lock);
+    }
+    return NULL;
+}
+
+static int write_str(const char *path, const char *val)
+{
+    int fd = open(path, O_WRONLY);
+    if (fd < 0)
+        return -1;
+    int rc = write(fd, val, strlen(val)) < 0 ? -1 : 0;
+    close(fd);
+    return rc;
+}
+
+static int read_str(const char *path, char *buf, size_t len)
+{
+    int fd = open(path, O_RDONLY);
+    ssize_t n;
+
+    if (fd < 0)
+        return -1;
+    n = read(fd, buf, len - 1);
+    close(fd);
+    if (n < 0)
+        return -1;
+    buf[n] = '\0';
+    return 0;
+}
+
+/* sum the switch, grant and mean wait columns over all channels */
+static void sched_totals(const char *path, unsigned long *switches, double *wait_us)
+{
+    unsigned long sw, grants, avg, max, total_grants = 0;
+    double wait = 0;
+    char line[128];
+    FILE *f = fopen(path, "r");
+
+    *switches = 0;
+    *wait_us = 0;
+    if (f == NULL)
+        return;
+    while (fgets(line, sizeof(line), f)) {
+        if (strcmp(line, "scheduler not installed\n") == 0)
+            fprintf(stderr, "%s: load cpuctl with i2c_sched=1, the i2c_sched=1 row is fifo too\n", path);
+        if (sscanf(line, "chan%*d %lu %lu %lu %lu", &sw, &grants, &avg, &max) == 4) {
+            *switches += sw;
+            total_grants += grants;
+            wait += (double)avg * grants;
+        }
+    }
+    fclose(f);
+    *wait_us = total_grants ? wait / total_grants : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *sched_path = NULL;
+    char saved[16];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n:t:r:s:")) != -1) {
+        switch (opt) {
+            case 'b': first_bus = strtoul(optarg, NULL, 0); break;
+            case 'n': num_ports = strtoul(optarg, NULL, 0); break;
+            case 't': num_threads = strtoul(optarg, NULL, 0); break;
+            case 'r': reads = strtoul(optarg, NULL, 0); break;
+            case 's': sched_path = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s -b <first bus> -n <ports> [-t <threads>] [-r <reads per port>] [-s <chan_sched path>]\n", argv[0]);
+                return 1;
+        }
+    }
+    if ((num_ports == 0) || (num_threads == 0)) {
+        fprintf(stderr, "ports and threads must be non-zero\n");
+        return 1;
+    }
+
+    if (read_str(SCHED_PARAM, saved, sizeof(saved)) < 0) {
+        perror(SCHED_PARAM);
+        return 1;
+    }
+
+    printf("%u ports from i2c-%u, %u threads, %u reads per port\n", num_ports, first_bus, num_threads, reads);
+    printf("%-8s %10s %10s %12s %8s\n", "i2c_sched", "sweep ms", "switches", "avg wait us", "errors");
+    for (int sched = 0; sched <= 1; sched++) {
+        pthread_t threads[num_threads];
+        unsigned long switches;
+        double wait_us;
+
+        if (write_str(SCHED_PARAM, sched ? "1" : "0") < 0) {
+            perror(SCHED_PARAM);
+            return 1;
+        }
+        if (sched_path)
+            write_str(sched_path, "0");
+        errors = 0;
+
+        uint64_t t0 = now_ns();
+        for (unsigned t = 0; t < num_threads; t++)
+            pthread_create(&threads[t], NULL, sweeper, (void *)(uintptr_t)t);
+        for (unsigned t = 0; t < num_threads; t++)
+            pthread_join(threads[t], NULL);
+        double ms = (now_ns() - t0) / 1e6;
+
+        sched_totals(sched_path ? sched_path : "", &switches, &wait_us);
+        printf("%-8d %10.1f %10lu %12.1f %8lu\n", sched, ms, switches, wait_us, errors);
+    }
+    write_str(SCHED_PARAM, saved);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#include "ctlFpgaMap.h"
+#include "replacements.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <iterator>
+CtlFpgaMap::CtlFpgaMap(CtlFpgaId fpga_id)
+{
+    if ((fpga_id != CTL_FPGA_CPUCTL) && (fpga_id != CTL_FPGA_IOCTL))
+        return;
+    if (sysconf(_SC_PAGESIZE) != kWindowSize)
+        return;
+    int fd = open(GetCtlFpgaRegsDevice(fpga_id).c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    void *map = mmap(nullptr, std::size(kWindows) * kWindowSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map != MAP_FAILED)
+        base = (const volatile uint8_t *)map;
+}
+CtlFpgaMap::~CtlFpgaMap()
+{
+    if (base != nullptr)
+        munmap((void *)base, std::size(kWindows) * kWindowSize);
+}
+CtlFpgaMap& CtlFpgaMap::Get(CtlFpgaId fpga_id)
+{
+    static CtlFpgaMap cpuctl(CTL_FPGA_CPUCTL);
+    static CtlFpgaMap ioctl(CTL_FPGA_IOCTL);
+    static CtlFpgaMap none(CTL_FPGA_NONE);
+    if (fpga_id == CTL_FPGA_DEFAULT)
+        fpga_id = ctl_fpga_id_default();
+    switch (fpga_id)
+    {
+        case CTL_FPGA_CPUCTL:
+            return cpuctl;
+        case CTL_FPGA_IOCTL:
+            return ioctl;
+        default:
+            return none;
+    }
+}
+bool CtlFpgaMap::read(uint32_t offset, uint32_t *value) const
+{
+    if ((base == nullptr) || (offset & 3))
+        return 0;
+    for (size_t w = 0; w < std::size(kWindows); w++)
+    {
+        if ((offset - kWindows[w]) < kWindowSize)
+        {
+            /* same byteswap as ctl_reg_read() in the module */
+            *value = __builtin_bswap32(*(const volatile uint32_t *)(base + w * kWindowSize + (offset - kWindows[w])));
+            return 1;
+        }
+    }
+    return 0;
+}
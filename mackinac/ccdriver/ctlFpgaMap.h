@@ -0,0 +1,30 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fpga_if.h"
+/*
+ * Read-only view of the cpuctl/ioctl FPGA status pages mmapped from /dev/<ctl name>_regs. The window order
+ * must match CTL_MMAP_WIN_* in the cpuctl module. read() fails when the device is missing or the register
+ * is outside the windows, so callers keep their sysfs path as a fallback.
+ */
+class CtlFpgaMap
+{
+public:
+    static constexpr uint32_t kWindows[] = { 0x00800000, 0x00807000, 0x02700000 };
+    static constexpr uint32_t kWindowSize = 0x1000;
+    static CtlFpgaMap& Get(CtlFpgaId fpga_id);
+    ~CtlFpgaMap();
+    bool isMapped() const {
+        return base != nullptr;
+    }
+    bool read(uint32_t offset, uint32_t *value) const;
+private:
+    explicit CtlFpgaMap(CtlFpgaId fpga_id);
+    CtlFpgaMap(const CtlFpgaMap &) = delete;
+    CtlFpgaMap& operator=(const CtlFpgaMap &) = delete;
+    const volatile uint8_t *base = nullptr;
+};
@@ -11,12 +11,103 @@
 #include "hw_instance.h"
 #include "fpga_if.h"
 #include <cstring>
+#include <algorithm>
 #include "platform_hw_info.h"
 #include "platform_types.h"
 #include "hwPcon.h"
+#include "pconEventLog.h"
 #include "tmSPI.h"
 #include "tmSpiDefs.h"
-static const tPconChanConfig caribouPcon0Channels[] =
+#include <atomic>
+#include <thread>
+#include <fstream>
+/*
+ * The board tables below are checked and indexed at compile time: every rail gets the list of
+ * channels (master plus slaves) it sums over, and every board gets index and i2c channel maps.
+ */
+template <size_t C, size_t R>
+consteval bool pconConfigIsValid(const tPconChanConfig (&channels)[C], const tPconRailConfig (&rails)[R])
+{
+    if (C > PCON_MAX_CHANNELS)
+        return false;
+    for (size_t chan = 0; chan < C; chan++)
+    {
+        if (channels[chan].name == nullptr)
+            continue;
+        if (channels[chan].master)
+        {
+            if (channels[chan].masterChan != (tPconChan)-1)
+                return false;
+        }
+        else if ((channels[chan].masterChan >= C) || !channels[channels[chan].masterChan].master)
+        {
+            return false;
+        }
+    }
+    for (size_t rail = 0; rail < R; rail++)
+    {
+        if ((rails[rail].masterChan >= C) || !channels[rails[rail].masterChan].master)
+            return false;
+        for (size_t other = 0; other < rail; other++)
+            if (rails[other].masterChan == rails[rail].masterChan)
+                return false;
+    }
+    return true;
+}
+template <size_t C, size_t R>
+consteval std::array<tPconRailChannels, R> makePconRailChannels(const tPconChanConfig (&channels)[C], const tPconRailConfig (&rails)[R])
+{
+    std::array<tPconRailChannels, R> railChannels{};
+    for (size_t rail = 0; rail < R; rail++)
+    {
+        for (size_t chan = 0; chan < C; chan++)
+        {
+            if (channels[chan].name &&
+                ((chan == rails[rail].masterChan) || (channels[chan].masterChan == rails[rail].masterChan)))
+                railChannels[rail].chans[railChannels[rail].count++] = chan;
+        }
+    }
+    return railChannels;
+}
+template <size_t N>
+consteval bool pconBoardIsValid(const tPconBoardSlot (&slots)[N])
+{
+    if (N > PCON_MAX_DEVICES_PER_IOCTRL)
+        return false;
+    for (size_t i = 0; i < N; i++)
+    {
+        if ((slots[i].index >= PCON_MAX_DEVICES_PER_IOCTRL) || (slots[i].i2cChannel >= PCON_MAX_I2C_CHANNELS))
+            return false;
+        for (size_t j = 0; j < i; j++)
+            if ((slots[j].index == slots[i].index) || (slots[j].i2cChannel == slots[i].i2cChannel))
+                return false;
+    }
+    return true;
+}
+template <size_t N>
+consteval tPconBoardMap makePconBoardMap(const tPconBoardSlot (&slots)[N])
+{
+    tPconBoardMap map{};
+    for (auto & device : map.deviceForIndex)
+        device = -1;
+    for (auto & index : map.indexForI2cChannel)
+        index = -1;
+    for (size_t i = 0; i < N; i++)
+    {
+        map.deviceForIndex[slots[i].index] = i;
+        map.indexForI2cChannel[slots[i].i2cChannel] = slots[i].index;
+    }
+    return map;
+}
+static constexpr tPconBoardSlot caribouPconSlots[] =
+{
+    { .index = 0, .i2cChannel = 0x5 },
+    { .index = 1, .i2cChannel = 0x6 },
+    { .index = 2, .i2cChannel = 0x13 },
+};
+static_assert(pconBoardIsValid(caribouPconSlots));
+static constexpr tPconBoardMap caribouPconMap = makePconBoardMap(caribouPconSlots);
+static constexpr tPconChanConfig caribouPcon0Channels[] =
 {
 [0]= {"D0_VDDC_P1", 750, 1, ((tPconChan)-1) },
 [1]= {"D0_VDDC_P2", 0xffff, 0, 0 },
@@ -54,7 +145,7 @@ static const tPconChanConfig caribouPcon0Channels[] =
 [33]= {"OPT_G4_VDD_3V3_P2", 0xffff, 0, 32 },
 [34]= {"OPT_G4_VDD_3V3_P3", 0xffff, 0, 32 },
 };
-static tPconRailConfig caribouPcon0Rails[] =
+static constexpr tPconRailConfig caribouPcon0Rails[] =
 {
 [0]= {"D0_VDDC", 0, 0},
 [1]= {"D0_NIF_TRVDD0P75", 18, 0},
@@ -66,12 +157,15 @@ static tPconRailConfig caribouPcon0Rails[] =
 [7]= {"OPT_G3_VDD_3V3", 29, 0},
 [8]= {"OPT_G4_VDD_3V3", 32, 0},
 };
+static_assert(pconConfigIsValid(caribouPcon0Channels, caribouPcon0Rails));
+static constexpr auto caribouPcon0RailChannels = makePconRailChannels(caribouPcon0Channels, caribouPcon0Rails);
 tPconConfig caribouPcon0 =
 {
       .channels = caribouPcon0Channels,
       .rails = caribouPcon0Rails,
       .channelCount = (unsigned int)(sizeof (caribouPcon0Channels) / sizeof ((caribouPcon0Channels) [0])),
       .railCount = (unsigned int)(sizeof (caribouPcon0Rails) / sizeof ((caribouPcon0Rails) [0])),
+      .railChannels = caribouPcon0RailChannels.data(),
 };
 static tPconDeviceProfile caribouPcon0Profile =
 {
@@ -86,10 +180,10 @@ static tPconDeviceProfile caribouPcon0Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 0,
-      .dev_params = {.channel = 0x5, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = caribouPconSlots[0].index,
+      .dev_params = {.channel = caribouPconSlots[0].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
-static const tPconChanConfig caribouPcon1Channels[] =
+static constexpr tPconChanConfig caribouPcon1Channels[] =
 {
 [0]= {"D1_VDDC_P1", 750, 1, ((tPconChan)-1) },
 [1]= {"D1_VDDC_P2", 0xffff, 0, 0 },
@@ -123,7 +217,7 @@ static const tPconChanConfig caribouPcon1Channels[] =
 [29]= {"OPT_G2_VDD_3V3_P3", 0xffff, 0, 27 },
 [30]= {"D1_VDDO_1P8_P1", 1800, 1, ((tPconChan)-1) },
 };
-static tPconRailConfig caribouPcon1Rails[] =
+static constexpr tPconRailConfig caribouPcon1Rails[] =
 {
 [0]= {"D1_VDDC", 0, 0},
 [1]= {"D1_NIF_TRVDD0P75", 18, 0},
@@ -133,12 +227,15 @@ static tPconRailConfig caribouPcon1Rails[] =
 [5]= {"OPT_G2_VDD_3V3", 27, 0},
 [6]= {"D1_VDDO_1P8", 30, 0},
 };
+static_assert(pconConfigIsValid(caribouPcon1Channels, caribouPcon1Rails));
+static constexpr auto caribouPcon1RailChannels = makePconRailChannels(caribouPcon1Channels, caribouPcon1Rails);
 tPconConfig caribouPcon1 =
 {
       .channels = caribouPcon1Channels,
       .rails = caribouPcon1Rails,
       .channelCount = (unsigned int)(sizeof (caribouPcon1Channels) / sizeof ((caribouPcon1Channels) [0])),
       .railCount = (unsigned int)(sizeof (caribouPcon1Rails) / sizeof ((caribouPcon1Rails) [0])),
+      .railChannels = caribouPcon1RailChannels.data(),
 };
 static tPconDeviceProfile caribouPcon1Profile =
 {
@@ -153,10 +250,10 @@ static tPconDeviceProfile caribouPcon1Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 1,
-      .dev_params = {.channel = 0x6, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = caribouPconSlots[1].index,
+      .dev_params = {.channel = caribouPconSlots[1].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
-static const tPconChanConfig caribouPcon4Channels[] =
+static constexpr tPconChanConfig caribouPcon4Channels[] =
 {
 [0]= {"CPU_VDD_DDR_P1", 1200, 1, ((tPconChan)-1) },
 [1]= {"VDD1_0_P1", 1000, 1, ((tPconChan)-1) },
@@ -166,7 +263,7 @@ static const tPconChanConfig caribouPcon4Channels[] =
 [5]= {"VDD3_3_S5_P1", 3300, 1, ((tPconChan)-1) },
 [6]= {"VDD5_0_P1", 5000, 1, ((tPconChan)-1) },
 };
-static tPconRailConfig caribouPcon4Rails[] =
+static constexpr tPconRailConfig caribouPcon4Rails[] =
 {
 [0]= {"CPU_VDD_DDR", 0, 0},
 [1]= {"VDD1_0", 1, 0},
@@ -176,12 +273,15 @@ static tPconRailConfig caribouPcon4Rails[] =
 [5]= {"VDD3_3_S5", 5, 0},
 [6]= {"VDD5_0", 6, 0},
 };
+static_assert(pconConfigIsValid(caribouPcon4Channels, caribouPcon4Rails));
+static constexpr auto caribouPcon4RailChannels = makePconRailChannels(caribouPcon4Channels, caribouPcon4Rails);
 tPconConfig caribouPcon4 =
 {
       .channels = caribouPcon4Channels,
       .rails = caribouPcon4Rails,
       .channelCount = (unsigned int)(sizeof (caribouPcon4Channels) / sizeof ((caribouPcon4Channels) [0])),
       .railCount = (unsigned int)(sizeof (caribouPcon4Rails) / sizeof ((caribouPcon4Rails) [0])),
+      .railChannels = caribouPcon4RailChannels.data(),
 };
 static tPconDeviceProfile caribouPcon4Profile =
 {
@@ -196,8 +296,8 @@ static tPconDeviceProfile caribouPcon4Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 2,
-      .dev_params = {.channel = 0x13, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = caribouPconSlots[2].index,
+      .dev_params = {.channel = caribouPconSlots[2].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
 static std::array<tPconDevice, 3> caribouPconDevices
 {
@@ -205,7 +305,16 @@ static std::array<tPconDevice, 3> caribouPconDevices
       caribouPcon1Profile, caribouPcon1,
       caribouPcon4Profile, caribouPcon4,
 };
-static const tPconChanConfig fireflyPcon0Channels[] =
+static_assert(std::size(caribouPconSlots) == caribouPconDevices.size());
+static constexpr tPconBoardSlot fireflyPconSlots[] =
+{
+    { .index = 0, .i2cChannel = 0x5 },
+    { .index = 1, .i2cChannel = 0x13 },
+    { .index = 2, .i2cChannel = 0x8 },
+};
+static_assert(pconBoardIsValid(fireflyPconSlots));
+static constexpr tPconBoardMap fireflyPconMap = makePconBoardMap(fireflyPconSlots);
+static constexpr tPconChanConfig fireflyPcon0Channels[] =
 {
 [0]= {"J2CP1_VDDC_P1", 800, 1, ((tPconChan)-1) },
 [1]= {"J2CP1_VDDC_P2", 0xffff, 0, 0 },
@@ -224,16 +333,19 @@ static const tPconChanConfig fireflyPcon0Channels[] =
 [14]= {"J2CP1_VDDC_P15", 0xffff, 0, 0 },
 [15]= {"J2CP1_VDDC_P16", 0xffff, 0, 0 },
 };
-static tPconRailConfig fireflyPcon0Rails[] =
+static constexpr tPconRailConfig fireflyPcon0Rails[] =
 {
 [0]= {"J2CP1_VDDC", 0, 0},
 };
+static_assert(pconConfigIsValid(fireflyPcon0Channels, fireflyPcon0Rails));
+static constexpr auto fireflyPcon0RailChannels = makePconRailChannels(fireflyPcon0Channels, fireflyPcon0Rails);
 tPconConfig fireflyPcon0 =
 {
       .channels = fireflyPcon0Channels,
       .rails = fireflyPcon0Rails,
       .channelCount = (unsigned int)(sizeof (fireflyPcon0Channels) / sizeof ((fireflyPcon0Channels) [0])),
       .railCount = (unsigned int)(sizeof (fireflyPcon0Rails) / sizeof ((fireflyPcon0Rails) [0])),
+      .railChannels = fireflyPcon0RailChannels.data(),
 };
 static tPconDeviceProfile fireflyPcon0Profile =
 {
@@ -248,10 +360,10 @@ static tPconDeviceProfile fireflyPcon0Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 0,
-      .dev_params = {.channel = 0x5, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = fireflyPconSlots[0].index,
+      .dev_params = {.channel = fireflyPconSlots[0].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
-static const tPconChanConfig fireflyPcon1Channels[] =
+static constexpr tPconChanConfig fireflyPcon1Channels[] =
 {
 [0]= {"J2CP1_SRD_0V75_P1", 770, 1, ((tPconChan)-1) },
 [1]= {"J2CP1_SRD_0V75_P2", 0xffff, 0, 0 },
@@ -270,7 +382,7 @@ static const tPconChanConfig fireflyPcon1Channels[] =
 [14]= {"VDD1_8_S5_P1", 1800, 1, ((tPconChan)-1) },
 [15]= {"CPU_VDD_DDR_P1", 1210, 1, ((tPconChan)-1) },
 };
-static tPconRailConfig fireflyPcon1Rails[] =
+static constexpr tPconRailConfig fireflyPcon1Rails[] =
 {
 [0]= {"J2CP1_SRD_0V75", 0, 0},
 [1]= {"J2CP1_SRD_PLL0V75", 3, 0},
@@ -286,12 +398,15 @@ static tPconRailConfig fireflyPcon1Rails[] =
 [11]= {"VDD1_8_S5", 14, 0},
 [12]= {"CPU_VDD_DDR", 15, 0},
 };
+static_assert(pconConfigIsValid(fireflyPcon1Channels, fireflyPcon1Rails));
+static constexpr auto fireflyPcon1RailChannels = makePconRailChannels(fireflyPcon1Channels, fireflyPcon1Rails);
 tPconConfig fireflyPcon1 =
 {
       .channels = fireflyPcon1Channels,
       .rails = fireflyPcon1Rails,
       .channelCount = (unsigned int)(sizeof (fireflyPcon1Channels) / sizeof ((fireflyPcon1Channels) [0])),
       .railCount = (unsigned int)(sizeof (fireflyPcon1Rails) / sizeof ((fireflyPcon1Rails) [0])),
+      .railChannels = fireflyPcon1RailChannels.data(),
 };
 static tPconDeviceProfile fireflyPcon1Profile =
 {
@@ -306,10 +421,10 @@ static tPconDeviceProfile fireflyPcon1Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 1,
-      .dev_params = {.channel = 0x13, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = fireflyPconSlots[1].index,
+      .dev_params = {.channel = fireflyPconSlots[1].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
-static const tPconChanConfig fireflyPcon3Channels[] =
+static constexpr tPconChanConfig fireflyPcon3Channels[] =
 {
 [0]= {"OPT_QSFP28_VDD_P1", 3325, 1, ((tPconChan)-1) },
 [1]= {"OPT_QSFP28_VDD_P2", 0xffff, 0, 0 },
@@ -328,7 +443,7 @@ static const tPconChanConfig fireflyPcon3Channels[] =
 [14]= {"PHY_G2_DVDD0P8_P2", 0xffff, 0, 13 },
 [15]= {"PHY_AVDD1P0_P1", 1000, 1, ((tPconChan)-1) },
 };
-static tPconRailConfig fireflyPcon3Rails[] =
+static constexpr tPconRailConfig fireflyPcon3Rails[] =
 {
 [0]= {"OPT_QSFP28_VDD", 0, 0},
 [1]= {"OPT_QSFPDD_VDD", 3, 0},
@@ -338,12 +453,15 @@ static tPconRailConfig fireflyPcon3Rails[] =
 [5]= {"PHY_G2_DVDD0P8", 13, 0},
 [6]= {"PHY_AVDD1P0", 15, 0},
 };
+static_assert(pconConfigIsValid(fireflyPcon3Channels, fireflyPcon3Rails));
+static constexpr auto fireflyPcon3RailChannels = makePconRailChannels(fireflyPcon3Channels, fireflyPcon3Rails);
 tPconConfig fireflyPcon3 =
 {
       .channels = fireflyPcon3Channels,
       .rails = fireflyPcon3Rails,
       .channelCount = (unsigned int)(sizeof (fireflyPcon3Channels) / sizeof ((fireflyPcon3Channels) [0])),
       .railCount = (unsigned int)(sizeof (fireflyPcon3Rails) / sizeof ((fireflyPcon3Rails) [0])),
+      .railChannels = fireflyPcon3RailChannels.data(),
 };
 static tPconDeviceProfile fireflyPcon3Profile =
 {
@@ -358,8 +476,8 @@ static tPconDeviceProfile fireflyPcon3Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 2,
-      .dev_params = {.channel = 0x8, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = fireflyPconSlots[2].index,
+      .dev_params = {.channel = fireflyPconSlots[2].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
 static std::array<tPconDevice, 3> fireflyPconDevices
 {
@@ -367,7 +485,17 @@ static std::array<tPconDevice, 3> fireflyPconDevices
       fireflyPcon1Profile, fireflyPcon1,
       fireflyPcon3Profile, fireflyPcon3,
 };
-static const tPconChanConfig saltydogPcon0Channels[] =
+static_assert(std::size(fireflyPconSlots) == fireflyPconDevices.size());
+static constexpr tPconBoardSlot saltydogPconSlots[] =
+{
+    { .index = 0, .i2cChannel = 0x5 },
+    { .index = 1, .i2cChannel = 0x6 },
+    { .index = 2, .i2cChannel = 0x7 },
+    { .index = 3, .i2cChannel = 0x13 },
+};
+static_assert(pconBoardIsValid(saltydogPconSlots));
+static constexpr tPconBoardMap saltydogPconMap = makePconBoardMap(saltydogPconSlots);
+static constexpr tPconChanConfig saltydogPcon0Channels[] =
 {
 [0]= {"J2CP1_VDDC_P1", 800, 1, ((tPconChan)-1) },
 [1]= {"J2CP1_VDDC_P2", 0xffff, 0, 0 },
@@ -386,16 +514,19 @@ static const tPconChanConfig saltydogPcon0Channels[] =
 [14]= {"J2CP1_VDDC_P15", 0xffff, 0, 0 },
 [15]= {"J2CP1_VDDC_P16", 0xffff, 0, 0 },
 };
-static tPconRailConfig saltydogPcon0Rails[] =
+static constexpr tPconRailConfig saltydogPcon0Rails[] =
 {
 [0]= {"J2CP1_VDDC", 0, 0},
 };
+static_assert(pconConfigIsValid(saltydogPcon0Channels, saltydogPcon0Rails));
+static constexpr auto saltydogPcon0RailChannels = makePconRailChannels(saltydogPcon0Channels, saltydogPcon0Rails);
 tPconConfig saltydogPcon0 =
 {
       .channels = saltydogPcon0Channels,
       .rails = saltydogPcon0Rails,
       .channelCount = (unsigned int)(sizeof (saltydogPcon0Channels) / sizeof ((saltydogPcon0Channels) [0])),
       .railCount = (unsigned int)(sizeof (saltydogPcon0Rails) / sizeof ((saltydogPcon0Rails) [0])),
+      .railChannels = saltydogPcon0RailChannels.data(),
 };
 static tPconDeviceProfile saltydogPcon0Profile =
 {
@@ -410,10 +541,10 @@ static tPconDeviceProfile saltydogPcon0Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 0,
-      .dev_params = {.channel = 0x5, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = saltydogPconSlots[0].index,
+      .dev_params = {.channel = saltydogPconSlots[0].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
-static const tPconChanConfig saltydogPcon1Channels[] =
+static constexpr tPconChanConfig saltydogPcon1Channels[] =
 {
 [0]= {"J2CP1_SRD_0V75_P1", 769, 1, ((tPconChan)-1) },
 [1]= {"J2CP1_SRD_0V75_P2", 0xffff, 0, 0 },
@@ -432,7 +563,7 @@ static const tPconChanConfig saltydogPcon1Channels[] =
 [14]= {"J2CP2_HBM1_VDD1V2_P1", 1200, 1, ((tPconChan)-1) },
 [15]= {"J2CP2_VDD3V3_P1", 3300, 1, ((tPconChan)-1) },
 };
-static tPconRailConfig saltydogPcon1Rails[] =
+static constexpr tPconRailConfig saltydogPcon1Rails[] =
 {
 [0]= {"J2CP1_SRD_0V75", 0, 0},
 [1]= {"J2CP1_SRD_PLL0V75", 3, 0},
@@ -447,12 +578,15 @@ static tPconRailConfig saltydogPcon1Rails[] =
 [10]= {"J2CP2_HBM1_VDD1V2", 14, 0},
 [11]= {"J2CP2_VDD3V3", 15, 0},
 };
+static_assert(pconConfigIsValid(saltydogPcon1Channels, saltydogPcon1Rails));
+static constexpr auto saltydogPcon1RailChannels = makePconRailChannels(saltydogPcon1Channels, saltydogPcon1Rails);
 tPconConfig saltydogPcon1 =
 {
       .channels = saltydogPcon1Channels,
       .rails = saltydogPcon1Rails,
       .channelCount = (unsigned int)(sizeof (saltydogPcon1Channels) / sizeof ((saltydogPcon1Channels) [0])),
       .railCount = (unsigned int)(sizeof (saltydogPcon1Rails) / sizeof ((saltydogPcon1Rails) [0])),
+      .railChannels = saltydogPcon1RailChannels.data(),
 };
 static tPconDeviceProfile saltydogPcon1Profile =
 {
@@ -467,10 +601,10 @@ static tPconDeviceProfile saltydogPcon1Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 1,
-      .dev_params = {.channel = 0x6, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = saltydogPconSlots[1].index,
+      .dev_params = {.channel = saltydogPconSlots[1].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
-static const tPconChanConfig saltydogPcon2Channels[] =
+static constexpr tPconChanConfig saltydogPcon2Channels[] =
 {
 [0]= {"J2CP2_VDDC_P1", 800, 1, ((tPconChan)-1) },
 [1]= {"J2CP2_VDDC_P2", 0xffff, 0, 0 },
@@ -489,16 +623,19 @@ static const tPconChanConfig saltydogPcon2Channels[] =
 [14]= {"J2CP2_VDDC_P15", 0xffff, 0, 0 },
 [15]= {"J2CP2_VDDC_P16", 0xffff, 0, 0 },
 };
-static tPconRailConfig saltydogPcon2Rails[] =
+static constexpr tPconRailConfig saltydogPcon2Rails[] =
 {
 [0]= {"J2CP2_VDDC", 0, 0},
 };
+static_assert(pconConfigIsValid(saltydogPcon2Channels, saltydogPcon2Rails));
+static constexpr auto saltydogPcon2RailChannels = makePconRailChannels(saltydogPcon2Channels, saltydogPcon2Rails);
 tPconConfig saltydogPcon2 =
 {
       .channels = saltydogPcon2Channels,
       .rails = saltydogPcon2Rails,
       .channelCount = (unsigned int)(sizeof (saltydogPcon2Channels) / sizeof ((saltydogPcon2Channels) [0])),
       .railCount = (unsigned int)(sizeof (saltydogPcon2Rails) / sizeof ((saltydogPcon2Rails) [0])),
+      .railChannels = saltydogPcon2RailChannels.data(),
 };
 static tPconDeviceProfile saltydogPcon2Profile =
 {
@@ -513,10 +650,10 @@ static tPconDeviceProfile saltydogPcon2Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 2,
-      .dev_params = {.channel = 0x7, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = saltydogPconSlots[2].index,
+      .dev_params = {.channel = saltydogPconSlots[2].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
-static const tPconChanConfig saltydogPcon4Channels[] =
+static constexpr tPconChanConfig saltydogPcon4Channels[] =
 {
 [0]= {"OPT_G1_VDD_P1", 3330, 1, ((tPconChan)-1) },
 [1]= {"OPT_G1_VDD_P2", 0xffff, 0, 0 },
@@ -535,7 +672,7 @@ static const tPconChanConfig saltydogPcon4Channels[] =
 [14]= {"VDD1_8_S5_P1", 1800, 1, ((tPconChan)-1) },
 [15]= {"CPU_VDD_DDR_P1", 1210, 1, ((tPconChan)-1) },
 };
-static tPconRailConfig saltydogPcon4Rails[] =
+static constexpr tPconRailConfig saltydogPcon4Rails[] =
 {
 [0]= {"OPT_G1_VDD", 0, 0},
 [1]= {"OPT_G2_VDD", 3, 0},
@@ -548,12 +685,15 @@ static tPconRailConfig saltydogPcon4Rails[] =
 [8]= {"VDD1_8_S5", 14, 0},
 [9]= {"CPU_VDD_DDR", 15, 0},
 };
+static_assert(pconConfigIsValid(saltydogPcon4Channels, saltydogPcon4Rails));
+static constexpr auto saltydogPcon4RailChannels = makePconRailChannels(saltydogPcon4Channels, saltydogPcon4Rails);
 tPconConfig saltydogPcon4 =
 {
       .channels = saltydogPcon4Channels,
       .rails = saltydogPcon4Rails,
       .channelCount = (unsigned int)(sizeof (saltydogPcon4Channels) / sizeof ((saltydogPcon4Channels) [0])),
       .railCount = (unsigned int)(sizeof (saltydogPcon4Rails) / sizeof ((saltydogPcon4Rails) [0])),
+      .railChannels = saltydogPcon4RailChannels.data(),
 };
 static tPconDeviceProfile saltydogPcon4Profile =
 {
@@ -568,8 +708,8 @@ static tPconDeviceProfile saltydogPcon4Profile =
       .resetBit = 10,
       .resetReg = (0x02700000+0x08),
       .spiTimer = (6),
-      .index = 3,
-      .dev_params = {.channel = 0x13, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
+      .index = saltydogPconSlots[3].index,
+      .dev_params = {.channel = saltydogPconSlots[3].i2cChannel, .device = 0xe8, .blksz = 0, .maxsz = 2, .speed = 1, .devclass = I2C_CLASS_UNKNOWN}
 };
 static std::array<tPconDevice, 4> saltydogPconDevices
 {
@@ -578,6 +718,7 @@ static std::array<tPconDevice, 4> saltydogPconDevices
       saltydogPcon2Profile, saltydogPcon2,
       saltydogPcon4Profile, saltydogPcon4,
 };
+static_assert(std::size(saltydogPconSlots) == saltydogPconDevices.size());
 using namespace std;
 using namespace srlinux::platform;
 using namespace srlinux::platform::spi;
@@ -606,7 +747,7 @@ const tPconAccessApi* hwPconGetAccessApis(HwInstance instance)
     const tPconAccessApi* access_api = &default_access_api;
     return access_api;
 }
-int hwPconGetCardPconInfo(HwInstance instance, tPconDevice ** card_info)
+static int hwPconGetCardPconBoard(HwInstance instance, tPconDevice ** card_info, const tPconBoardMap ** board_map)
 {
     int size = 0;
     switch (instance.id)
@@ -617,14 +758,17 @@ int hwPconGetCardPconInfo(HwInstance instance, tPconDevice ** card_info)
             {
                 case 0x1b:
                     *card_info = saltydogPconDevices.data();
+                    *board_map = &saltydogPconMap;
                     size = saltydogPconDevices.size();
                     break;
                 case 0x20:
                     *card_info = fireflyPconDevices.data();
+                    *board_map = &fireflyPconMap;
                     size = fireflyPconDevices.size();
                     break;
                 case 0x3c:
                     *card_info = caribouPconDevices.data();
+                    *board_map = &caribouPconMap;
                     size = caribouPconDevices.size();
                     break;
                 default:
@@ -639,6 +783,19 @@ int hwPconGetCardPconInfo(HwInstance instance, tPconDevice ** card_info)
     }
     return size;
 }
+int hwPconGetCardPconInfo(HwInstance instance, tPconDevice ** card_info)
+{
+    const tPconBoardMap *board_map;
+    return hwPconGetCardPconBoard(instance, card_info, &board_map);
+}
+int32_t hwPconFindIndexByI2cChannel(HwInstance instance, uint8_t channel)
+{
+    tPconDevice *pcon_info;
+    const tPconBoardMap *board_map;
+    if (hwPconGetCardPconBoard(instance, &pcon_info, &board_map) && (channel < PCON_MAX_I2C_CHANNELS))
+        return board_map->indexForI2cChannel[channel];
+    return -1;
+}
 I2CCtrlr hwPconGetI2CCtrlr(HwInstance instance, const tPconDevice& card_info)
 {
     I2CCtrlr ctrlr;
@@ -658,15 +815,11 @@ I2CCtrlr hwPconGetI2CCtrlr(HwInstance instance, const tPconDevice& card_info)
 tPconDevice * hwPconGetPconInfo(HwInstance instance, uint32_t index, bool log_on_failure)
 {
     tPconDevice *pcon_info;
-    if (int size = hwPconGetCardPconInfo(instance, &pcon_info))
+    const tPconBoardMap *board_map;
+    if (hwPconGetCardPconBoard(instance, &pcon_info, &board_map))
     {
-        for (int i = 0; i < size; i++)
-        {
-            if (pcon_info[i].dev.index == index)
-            {
-                return &pcon_info[i];
-            }
-        }
+        if ((index < PCON_MAX_DEVICES_PER_IOCTRL) && (board_map->deviceForIndex[index] >= 0))
+            return &pcon_info[board_map->deviceForIndex[index]];
         if (log_on_failure)
         {
             switch (instance.id)
@@ -690,40 +843,63 @@ bool hwPconIsMini(HwInstance instance, uint32_t index)
     const tPconDeviceProfile *pcon_profile = hwPconGetProfile(hwPconGetPconInfo(instance, index));
     return (pcon_profile ? pcon_profile->mini : 1);
 }
-void hwPconShowDevices(HwInstance instance, bool verbose)
+/*
+ * Each channel current is the average of hwPconCurrentSamples reads of the measured current register; rails
+ * sum the channel averages. Devices are reported concurrently by up to hwPconWorkers threads.
+ */
+static uint32_t hwPconCurrentSamples = 16;
+static uint32_t hwPconWorkers = PCON_MAX_DEVICES_PER_IOCTRL;
+void hwPconConfigureSampling(uint32_t current_samples, uint32_t workers)
+{
+    hwPconCurrentSamples = std::clamp<uint32_t>(current_samples, 1, 256);
+    hwPconWorkers = std::clamp<uint32_t>(workers, 1, PCON_MAX_DEVICES_PER_IOCTRL);
+}
+void hwPconForEachDevice(HwInstance instance, const std::function<void(tPconDevice &)> &fn)
 {
     tPconDevice *pcon_info;
-    if (int size = hwPconGetCardPconInfo(instance, &pcon_info))
-    {
-        for (int i = 0; i < size; i++)
+    int size = hwPconGetCardPconInfo(instance, &pcon_info);
+    std::atomic<int> next { 0 };
+    auto worker = [&]()
+    {
+        for (int i; (i = next++) < size; )
+            fn(pcon_info[i]);
+    };
+    std::vector<std::thread> threads;
+    for (int w = 1; w < std::min<int>(size, hwPconWorkers); w++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto & thread : threads)
+        thread.join();
+}
+static std::vector<std::string> hwPconCollectPerDevice(HwInstance instance, const std::function<std::string(tPconDevice &)> &report)
+{
+    tPconDevice *pcon_info;
+    std::vector<std::string> output(hwPconGetCardPconInfo(instance, &pcon_info));
+    hwPconForEachDevice(instance, [&](tPconDevice & device)
         {
-            printf("\nDevice Index %u => Name: %s  IsMini: %s   Description: %s\n", i, pcon_info[i].dev.name, pcon_info[i].dev.mini ? "yes" : "no",
-                   pcon_info[i].dev.desc);
-            uint32_t imbv_milli_volt = 0;
-            hwPconGetInputVoltage(instance, pcon_info[i].dev.index, &imbv_milli_volt);
-            printf("IMBV bus voltage = %u millivolt\n", imbv_milli_volt);
-            if (verbose)
-                hwPconShowRailVoltages(instance, i, 0);
-        }
-    }
+            output[&device - pcon_info] = report(device);
+        });
+    return output;
+}
+void hwPconShowDevices(HwInstance instance, bool verbose)
+{
+    printf("%s", hwPconGetDevices(instance, verbose).c_str());
 }
 std::string hwPconGetDevices(HwInstance instance, bool verbose)
 {
-    tPconDevice *pcon_info;
     std::string output;
-    if (int size = hwPconGetCardPconInfo(instance, &pcon_info))
-    {
-        for (int i = 0; i < size; i++)
+    for (const auto & device : hwPconCollectPerDevice(instance, [&](tPconDevice & pcon_info)
         {
-            output.append(fmt::format("\nDevice Index {} => Name: {}  IsMini: {}   Description: {}\n", i, pcon_info[i].dev.name, pcon_info[i].dev.mini ? "yes" : "no",
-                   pcon_info[i].dev.desc));
+            std::string report = fmt::format("\nDevice Index {} => Name: {}  IsMini: {}   Description: {}\n", pcon_info.dev.index, pcon_info.dev.name,
+                                             pcon_info.dev.mini ? "yes" : "no", pcon_info.dev.desc);
             uint32_t imbv_milli_volt = 0;
-            hwPconGetInputVoltage(instance, pcon_info[i].dev.index, &imbv_milli_volt);
-            output.append(fmt::format("IMBV bus voltage = {} millivolt\n", imbv_milli_volt));
+            hwPconGetInputVoltage(instance, pcon_info.dev.index, &imbv_milli_volt);
+            report.append(fmt::format("IMBV bus voltage = {} millivolt\n", imbv_milli_volt));
             if (verbose)
-                output.append(hwPconGetRailVoltages(instance, i, 0));
-        }
-    }
+                report.append(hwPconGetRailVoltages(instance, pcon_info.dev.index, 0));
+            return report;
+        }))
+        output.append(device);
     return output;
 }
 uint32_t hwPconRailApplyScaleFactor(bool scale_up, uint32_t conf_mvolt, uint32_t meas_mvolt)
@@ -806,14 +982,15 @@ SrlStatus hwPconReadChannelCurrent(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pD
     uint8_t numerator = 0;
     uint8_t denominator=1;
     uint64_t current64 = 0;
-    uint32_t samples[16];
+    uint64_t sum = 0;
+    uint32_t samples = hwPconCurrentSamples;
     uint32_t sample;
     *current = 0;
     if (pconReadChanReg(ctrlr, pDev, chan, 0x20, &multipliers) != 0)
         return (-1);
     numerator = (multipliers & 0xff00) >> 8;
     denominator = (multipliers & 0x00ff) >> 0;
-    for (sample = 0; sample < (unsigned int)(sizeof (samples) / sizeof ((samples) [0])); sample++)
+    for (sample = 0; sample < samples; sample++)
     {
         if (pconReadChanReg(ctrlr, pDev, chan, 0x1E, &hwCurrent) != 0)
             return (-1);
@@ -827,12 +1004,10 @@ SrlStatus hwPconReadChannelCurrent(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pD
         current64 /= 1024;
         if (verbose) printf ("div 0x%lx ", current64);
         if (verbose) printf ("answer %lumA\n", current64);
-        samples[sample] = (uint32_t)current64;
+        sum += (uint32_t)current64;
     }
-    for (sample = 0; sample < (unsigned int)(sizeof (samples) / sizeof ((samples) [0])); sample++)
-        *current += samples[sample];
-    if (verbose) printf ("Current SUM %umA\n", *current);
-    *current /= (unsigned int)(sizeof (samples) / sizeof ((samples) [0]));
+    if (verbose) printf ("Current SUM %lumA\n", sum);
+    *current = (uint32_t)(sum / samples);
     if (verbose) printf ("answer %umA\n", *current);
     return 0;
 }
@@ -845,30 +1020,37 @@ SrlStatus hwPconGetMeasuredCurrent(I2CCtrlr & ctrlr, const tPconDevice & pconDev
         return (-1);
     }
     current = 0;
-    for (uint32_t chan = 0; chan < pconDevConfig.config.channelCount; chan++)
+    const tPconRailChannels & railChannels = pconDevConfig.config.railChannels[rail_num];
+    for (uint32_t i = 0; i < railChannels.count; i++)
     {
-        if (pconDevConfig.config.channels[chan].name)
-        {
-            if ((chan == pconDevConfig.config.rails[rail_num].masterChan) ||
-                (pconDevConfig.config.channels[chan].masterChan == pconDevConfig.config.rails[rail_num].masterChan))
-            {
-                uint32_t channelCurrent = 0;
-                if ((status |= hwPconReadChannelCurrent(&ctrlr, &pconDevConfig.dev.dev_params, chan, &channelCurrent)) == 0)
-                    current += channelCurrent;
-            }
-        }
+        uint32_t channelCurrent = 0;
+        if ((status |= hwPconReadChannelCurrent(&ctrlr, &pconDevConfig.dev.dev_params, railChannels.chans[i], &channelCurrent)) == 0)
+            current += channelCurrent;
     }
     return status;
 }
-void hwPconShowChannels(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint16_t idx, tPconConfig pconConfig)
+static uint32_t hwPconConvertChannelVoltage(uint16_t hwVoltage, uint32_t conf_mvolt)
 {
+    uint32_t voltage32 = ((uint32_t)hwVoltage * 3000) / 1024;
+    if (conf_mvolt > (3000))
+        voltage32 = hwPconRailApplyScaleFactor(1, conf_mvolt, voltage32);
+    return voltage32;
+}
+static std::string hwPconGetChannels(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint16_t idx, tPconConfig pconConfig)
+{
+    std::string output;
     uint8_t spiChannel = pDev->channel;
     uint16_t version;
-    pconReadGlobalReg(ctrlr, pDev, 0x00, &version);
-    printf("Versions %x\r\n", version);
-    printf("PCON Device %02d  SPI Channel %02d\n", idx, spiChannel);
-    printf ("%-4s %-8s %-36s %-8s %-8s %-12s %-12s %-12s\n", "SPI", "CHANNEL", "NAME", "ENABLE", "MASTER", "SLAVE TO", "VOLTAGE", "CURRENT");
-    printf ("%-4s %-8s %-36s %-8s %-8s %-12s %-12s %-12s\n", "====", "=======", "====", "======", "======", "========", "=======", "=======");
+    tPconSnapshot snapshot;
+    bool have_snapshot = (hwPconSnapshot(GetMyHwInstance(), idx, &snapshot) == 0);
+    if (have_snapshot)
+        version = snapshot.versionId;
+    else
+        pconReadGlobalReg(ctrlr, pDev, 0x00, &version);
+    output += Format("Versions %x\r\n", version);
+    output += Format("PCON Device %02d  SPI Channel %02d\n", idx, spiChannel);
+    output += Format("%-4s %-8s %-36s %-8s %-8s %-12s %-12s %-12s\n", "SPI", "CHANNEL", "NAME", "ENABLE", "MASTER", "SLAVE TO", "VOLTAGE", "CURRENT");
+    output += Format("%-4s %-8s %-36s %-8s %-8s %-12s %-12s %-12s\n", "====", "=======", "====", "======", "======", "========", "=======", "=======");
     int i;
     bool enable;
     bool master;
@@ -879,14 +1061,25 @@ void hwPconShowChannels(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint16_
         {
             uint32_t current = 0;
             uint32_t voltage = 0;
-            if (pconGetMiscInfo(ctrlr, pDev, i, &enable, &master, &slaveTo) != 0)
+            if (have_snapshot && (i < snapshot.numChannels))
             {
-                break;
+                uint16_t miscReg = snapshot.channels[i].misc;
+                master = (bool)((miscReg & 0x01) >> 0);
+                enable = (bool)((miscReg & 0x02) >> 1);
+                slaveTo = (tPconChan)((miscReg & 0xff00) >> 8);
+                if (pconConfig.channels[i].master == 1)
+                    voltage = hwPconConvertChannelVoltage(snapshot.channels[i].measuredVolt, pconConfig.channels[i].voltage);
             }
-            if (pconConfig.channels[i].name == NULL) continue;
-            if (pconConfig.channels[i].master == 1)
+            else
             {
-                hwPconReadChannelVoltage(ctrlr, pDev, i, &voltage, pconConfig.channels[i], 0);
+                if (pconGetMiscInfo(ctrlr, pDev, i, &enable, &master, &slaveTo) != 0)
+                {
+                    break;
+                }
+                if (pconConfig.channels[i].master == 1)
+                {
+                    hwPconReadChannelVoltage(ctrlr, pDev, i, &voltage, pconConfig.channels[i], 0);
+                }
             }
             hwPconReadChannelCurrent(ctrlr, pDev, i, &current);
             char voltage_str[20] = { '\0' };
@@ -896,11 +1089,91 @@ void hwPconShowChannels(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint16_
             else
                 snprintf(voltage_str, sizeof(voltage_str), "%5umV", voltage);
             snprintf(current_str, sizeof(current_str), "%5umA", current);
-            printf ("%02u%2s %02u%6s %-36s %u%7s %u%7s %2u%10s %-12s %-12s\n",
-                    spiChannel, " ", i, " ", pconConfig.channels[i].name, enable, " ", master, " ", slaveTo, " ",
-                    voltage_str, current_str);
+            output += Format("%02u%2s %02u%6s %-36s %u%7s %u%7s %2u%10s %-12s %-12s\n",
+                             spiChannel, " ", i, " ", pconConfig.channels[i].name, enable, " ", master, " ", slaveTo, " ",
+                             voltage_str, current_str);
         }
     }
+    return output;
+}
+SrlStatus hwPconSampleRail(const tHwPconRailSamplingParams &params, tHwPconRailSamplingResults &results)
+{
+    uint32_t chan_num, conf_mvolt;
+    tPconDevice *pcon_info = hwPconGetPconInfo(params.instance, params.device_index);
+    if (pcon_info == nullptr)
+        return (-1);
+    if (getChannelInfo(&pcon_info->config, params.device_index, params.rail_num, &chan_num, &conf_mvolt) != 0)
+        return (-1);
+    std::vector<tPconSample> samples;
+    if (hwPconCaptureSamples(params.device_index, chan_num, params.sampling_rate, params.sampling_time, samples) != 0)
+        return (-1);
+    results.rail_num = params.rail_num;
+    results.rail_name = pcon_info->config.rails[params.rail_num].name;
+    results.sample_values.clear();
+    results.sample_values.reserve(samples.size());
+    double sum = 0;
+    for (const auto &sample : samples)
+    {
+        tRailsampleValue mvolt = hwPconConvertChannelVoltage(sample.measuredVolt, conf_mvolt);
+        results.sample_values.push_back(mvolt);
+        sum += mvolt;
+    }
+    auto [min_it, max_it] = std::minmax_element(results.sample_values.begin(), results.sample_values.end());
+    results.sample_min_value = *min_it;
+    results.sample_max_value = *max_it;
+    results.mean_mv = sum / results.sample_values.size();
+    results.ripple_ptop_mv = results.sample_max_value - results.sample_min_value;
+    double sum_sq = 0;
+    for (auto mvolt : results.sample_values)
+        sum_sq += (mvolt - results.mean_mv) * (mvolt - results.mean_mv);
+    results.ripple_rms_mv = sqrt(sum_sq / results.sample_values.size());
+    return 0;
+}
+/*
+ * One device sweep for pcon_cmds --daemon. Rail voltages come from the master channels of a single snapshot read
+ * when the driver has one, currents from the averaged channel reads, like hwPconGetChannels.
+ */
+static_assert(PCON_TELEMETRY_DEVICES == PCON_MAX_DEVICES_PER_IOCTRL);
+static_assert(PCON_TELEMETRY_RAILS == PCON_MAX_CHANNELS);
+SrlStatus hwPconSampleTelemetry(HwInstance instance, tPconDevice &pcon_info, tPconTelemetryDevice &telemetry)
+{
+    SrlStatus status = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    memset(&telemetry, 0, sizeof(telemetry));
+    snprintf(telemetry.name, sizeof(telemetry.name), "%s", pcon_info.dev.name);
+    telemetry.present = 1;
+    telemetry.rail_count = std::min<uint32_t>(pcon_info.config.railCount, PCON_TELEMETRY_RAILS);
+    if (hwPconGetInputVoltage(instance, pcon_info.dev.index, &telemetry.imbv_milli_volt) != 0)
+        status = (-1);
+    I2CCtrlr ctrlr = hwPconGetI2CCtrlr(instance, pcon_info);
+    tPconSnapshot snapshot;
+    bool have_snapshot = (hwPconSnapshot(instance, pcon_info.dev.index, &snapshot) == 0);
+    for (uint32_t i = 0; i < telemetry.rail_count; i++)
+    {
+        const tPconRailConfig & rail_config = pcon_info.config.rails[i];
+        tPconTelemetryRail & rail = telemetry.rails[i];
+        if (rail_config.name == NULL)
+            continue;
+        snprintf(rail.name, sizeof(rail.name), "%s", rail_config.name);
+        uint8_t master = rail_config.masterChan;
+        if (have_snapshot && (master < snapshot.numChannels))
+        {
+            rail.milli_volt = hwPconConvertChannelVoltage(snapshot.channels[master].measuredVolt, pcon_info.config.channels[master].voltage);
+            rail.flags |= PCON_TELEMETRY_VOLT_VALID;
+        }
+        else if (hwPconReadRailVoltage(&ctrlr, &pcon_info, i, &rail.milli_volt, 0) == 0)
+            rail.flags |= PCON_TELEMETRY_VOLT_VALID;
+        else
+            status = (-1);
+        if (hwPconReadRailCurrent(&ctrlr, &pcon_info, i, &rail.milli_amp, 0) == 0)
+            rail.flags |= PCON_TELEMETRY_CURR_VALID;
+        else
+            status = (-1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    telemetry.sweep_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_nsec - start.tv_nsec) / 1000;
+    return status;
 }
 SrlStatus hwPconSetTargetVoltageInt(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint32_t idx, tPconConfig *pconConfig, uint32_t rail_num, uint32_t milli_volt)
 {
@@ -911,7 +1184,7 @@ SrlStatus hwPconSetTargetVoltageInt(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *p
     uint32_t chan_num, conf_mvolt;
     if ((status = getChannelInfo(pconConfig, idx, rail_num, &chan_num, &conf_mvolt)) == 0)
     {
-        tPconRailConfig * rail_config = pconConfig->rails;
+        const tPconRailConfig * rail_config = pconConfig->rails;
         if ((status = pconReadChanReg(ctrlr, pDev, chan_num, 0x2C, &trim_allow)) == 0)
         {
             mvolt_trim_allow = ((3000) * (trim_allow & 0xff)) / (1 << 10);
@@ -965,7 +1238,7 @@ SrlStatus hwPconSetUnderVoltageInt(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pD
     uint32_t chan_num, conf_mvolt, cur_mvolt;
     if ((status = getChannelInfo(pconConfig, idx, rail_num, &chan_num, &conf_mvolt)) == 0)
     {
-        tPconRailConfig * rail_config = pconConfig->rails;
+        const tPconRailConfig * rail_config = pconConfig->rails;
         if ((status = hwPconGetMeasuredVoltage(ctrlr, pDev, idx, pconConfig, rail_num, &cur_mvolt)) == 0)
         {
             do { uint32_t set_mvolt = 0; hwPconGetConfiguredVoltage(ctrlr, pDev, idx, pconConfig, rail_num, &set_mvolt); if ((set_mvolt > 0) && (set_mvolt <= (750))) { milli_volt = set_mvolt; (1) ? (milli_volt -= (60)) : (milli_volt += (60)); } } while(0);
@@ -991,7 +1264,7 @@ SrlStatus hwPconSetOverVoltageInt(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDe
     uint32_t chan_num, conf_mvolt, cur_mvolt;
     if ((status = getChannelInfo(pconConfig, idx, rail_num, &chan_num, &conf_mvolt)) == 0)
     {
-        tPconRailConfig * rail_config = pconConfig->rails;
+        const tPconRailConfig * rail_config = pconConfig->rails;
         if ((status = hwPconGetMeasuredVoltage(ctrlr, pDev, idx, pconConfig, rail_num, &cur_mvolt)) == 0)
         {
             do { uint32_t set_mvolt = 0; hwPconGetConfiguredVoltage(ctrlr, pDev, idx, pconConfig, rail_num, &set_mvolt); if ((set_mvolt > 0) && (set_mvolt <= (750))) { milli_volt = set_mvolt; (0) ? (milli_volt -= (60)) : (milli_volt += (60)); } } while(0);
@@ -1044,7 +1317,7 @@ SrlStatus hwPconGetConfiguredVoltage(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *
     {
         if ((status = pconReadChanReg(ctrlr, pDev, chan_num, 0x12, &volt_reg)) == 0)
         {
-            tPconRailConfig * rail_config = pconConfig->rails;
+            const tPconRailConfig * rail_config = pconConfig->rails;
             *milli_volt = ((((volt_reg & ((1 << 10) - 1)) * (3000)) / (1 << 10)) + (((((volt_reg & ((1 << 10) - 1)) * (3000)) % (1 << 10)) + ((1 << 10) >> 1)) / (1 << 10))) - rail_config[rail_num].voltOffset;
             if (conf_mvolt > (3000))
                 *milli_volt = hwPconRailApplyScaleFactor(1, conf_mvolt, *milli_volt);
@@ -1134,28 +1407,16 @@ void hwPconShowRailsConfigInt(HwInstance instance, I2CFpgaCtrlrDeviceParams *pDe
 }
 void hwPconShowRailConfigAll(HwInstance instance)
 {
-    tPconDevice *pcon_info;
-    if (int size = hwPconGetCardPconInfo(instance, &pcon_info))
-    {
-        for (int device_idx = 0; device_idx < size; device_idx++)
-        {
-            {
-                hwPconShowRailsConfigInt(instance, &pcon_info[device_idx].dev.dev_params, device_idx, &pcon_info[device_idx].config);
-            }
-        }
-    }
+    printf("%s", hwPconGetRailConfigAll(instance).c_str());
 }
 std::string hwPconGetRailConfigAll(HwInstance instance)
 {
     std::string output;
-    tPconDevice *pcon_info;
-    if (int size = hwPconGetCardPconInfo(instance, &pcon_info))
-    {
-        for (int i = 0; i < size; i++)
+    for (const auto & device : hwPconCollectPerDevice(instance, [&](tPconDevice & pcon_info)
         {
-            output.append(hwPconGetRailsConfigInt(instance, &pcon_info[i].dev.dev_params, pcon_info[i].dev.index, &pcon_info[i].config));
-        }
-    }
+            return hwPconGetRailsConfigInt(instance, &pcon_info.dev.dev_params, pcon_info.dev.index, &pcon_info.config);
+        }))
+        output.append(device);
     return output;
 }
 SrlStatus hwPconReadRailVoltage(I2CCtrlr *ctrlr, tPconDevice *pcon_info, uint32_t rail, uint32_t *voltage, bool verbose)
@@ -1166,29 +1427,14 @@ SrlStatus hwPconReadRailVoltage(I2CCtrlr *ctrlr, tPconDevice *pcon_info, uint32_
 SrlStatus hwPconReadRailCurrent(I2CCtrlr *ctrlr, tPconDevice *pcon_info, uint32_t rail, uint32_t *current, bool verbose)
 {
     uint32_t current32 = 0;
-    uint32_t samples[16] = { 0 };
-    for (uint32_t chan = 0; chan < pcon_info->config.channelCount; chan++)
+    const tPconRailChannels & railChannels = pcon_info->config.railChannels[rail];
+    for (uint32_t i = 0; i < railChannels.count; i++)
     {
-        if (pcon_info->config.channels[chan].name)
-        {
-            for (uint32_t sample = 0; sample < (unsigned int)(sizeof (samples) / sizeof ((samples) [0])); sample++)
-            {
-                if ((chan == pcon_info->config.rails[rail].masterChan) ||
-                    (pcon_info->config.channels[chan].masterChan == pcon_info->config.rails[rail].masterChan))
-                {
-                    uint32_t channelCurrent;
-                    if (hwPconReadChannelCurrent(ctrlr, &pcon_info->dev.dev_params, chan, &channelCurrent,
-                                                 (verbose && (sample == 0))) != 0)
-                        return (-1);
-                    else
-                        samples[sample] += channelCurrent;
-                }
-            }
-        }
+        uint32_t channelCurrent;
+        if (hwPconReadChannelCurrent(ctrlr, &pcon_info->dev.dev_params, railChannels.chans[i], &channelCurrent, verbose) != 0)
+            return (-1);
+        current32 += channelCurrent;
     }
-    for (uint32_t sample = 0; sample < (unsigned int)(sizeof (samples) / sizeof ((samples) [0])); sample++)
-        current32 += samples[sample];
-    current32 /= (unsigned int)(sizeof (samples) / sizeof ((samples) [0]));
     if (current)
         *current = current32;
     return 0;
@@ -1238,6 +1484,8 @@ std::string hwPconGetRailVoltages(HwInstance instance, uint8_t idx, bool verbose
         return "";
     }
     index += ret;
+    tPconSnapshot snapshot;
+    bool have_snapshot = (hwPconSnapshot(instance, idx, &snapshot) == 0);
     for (uint32_t i = 0; i < pcon_info->config.railCount; i++)
     {
         std::string voltage;
@@ -1245,7 +1493,15 @@ std::string hwPconGetRailVoltages(HwInstance instance, uint8_t idx, bool verbose
         uint32_t value;
         if (pcon_info->config.rails[i].name == NULL)
             continue;
-        if (hwPconReadRailVoltage(&ctrlr, pcon_info, i, &value, verbose) == 0)
+        uint8_t master = pcon_info->config.rails[i].masterChan;
+        if (have_snapshot && (master < snapshot.numChannels))
+        {
+            value = hwPconConvertChannelVoltage(snapshot.channels[master].measuredVolt, pcon_info->config.channels[master].voltage);
+            if (verbose)
+                printf("channel %u:  hwVoltage 0x%04x (snapshot) answer %umV\n", master, snapshot.channels[master].measuredVolt, value);
+            voltage += Format("%5umV", value);
+        }
+        else if (hwPconReadRailVoltage(&ctrlr, pcon_info, i, &value, verbose) == 0)
             voltage += Format("%5umV", value);
         else
             voltage += "*ERR*";
@@ -1265,21 +1521,14 @@ std::string hwPconGetRailVoltages(HwInstance instance, uint8_t idx, bool verbose
 }
 SrlStatus hwPconShowChannelsAll(HwInstance instance)
 {
-    SrlStatus rc = 0;
-    tPconDevice *pcon_info;
-    if (int size = hwPconGetCardPconInfo(instance, &pcon_info))
-    {
-        for (int i = 0; i < size; i++)
+    std::vector<std::string> output = hwPconCollectPerDevice(instance, [&](tPconDevice & pcon_info)
         {
-            I2CCtrlr ctrlr = hwPconGetI2CCtrlr(instance, pcon_info[i]);
-            {
-                hwPconShowChannels(&ctrlr, &pcon_info[i].dev.dev_params, pcon_info[i].dev.index, pcon_info[i].config);
-            }
-        }
-    }
-    else
-        rc = (-1);
-    return rc;
+            I2CCtrlr ctrlr = hwPconGetI2CCtrlr(instance, pcon_info);
+            return hwPconGetChannels(&ctrlr, &pcon_info.dev.dev_params, pcon_info.dev.index, pcon_info.config);
+        });
+    for (const auto & device : output)
+        printf("%s", device.c_str());
+    return (output.empty() ? (-1) : 0);
 }
 SrlStatus hwPconGetInputVoltage(HwInstance instance, uint32_t index, uint32_t *milli_volt)
 {
@@ -1313,7 +1562,7 @@ SrlStatus getChannelInfo(tPconConfig *pconConfig, uint32_t idx, uint32_t rail_nu
         printf("PCON %d voltage rail number %u invalid" "\n", idx, rail_num);
         return (-1);
     }
-    tPconRailConfig * rail_config = config->rails;
+    const tPconRailConfig * rail_config = config->rails;
     uint8_t chan_num = rail_config[rail_num].masterChan;
     if (((chan_num) >= (config)->channelCount) || ((config)->channels[(chan_num)].name == NULL))
     {
@@ -1521,6 +1770,32 @@ SrlStatus hwPconReadEventLogMemory(HwInstance instance, uint8_t idx, uint32_t of
     hwPconCntrlExtSpiMasterToLogNvr(&ctrlr, &dev_params, 0);
     return status;
 }
+/*
+ * The whole event log region for PconEventLog. spidev caps a message at its bufsiz, so the region is read in
+ * chunks of that size, but with the SPI master switched to the log NVR once for all of them.
+ */
+static uint32_t hwPconSpiMaxRead()
+{
+    uint32_t bufsiz = 0;
+    std::ifstream("/sys/module/spidev/parameters/bufsiz") >> bufsiz;
+    return bufsiz ? bufsiz : 4096;
+}
+SrlStatus hwPconReadEventLogRegion(HwInstance instance, uint8_t idx, uint8_t *buf, size_t length)
+{
+    SrlStatus status = 0;
+    I2CCtrlr ctrlr;
+    static const uint32_t chunk = hwPconSpiMaxRead();
+    const tPconAccessApi* pcon_access = hwPconGetAccessApis(instance);
+    tSpiParameters parms = getPconSPIParams(instance, idx);
+    I2CFpgaCtrlrDeviceParams dev_params = getPconI2CParams(instance, idx, &ctrlr);
+    if ((length == 0) || (length > 0x1000000) || (buf == NULL))
+        return (-1);
+    hwPconCntrlExtSpiMasterToLogNvr(&ctrlr, &dev_params, 1);
+    for (size_t offset = 0; (offset < length) && (status == 0); offset += chunk)
+        status = pcon_access->hwSpiReadBlock(&parms, (0x03 << 24) | offset, buf + offset, std::min<size_t>(chunk, length - offset));
+    hwPconCntrlExtSpiMasterToLogNvr(&ctrlr, &dev_params, 0);
+    return status;
+}
 SrlStatus hwPconWriteEventLogMemory(HwInstance instance, uint32_t idx, uint32_t offset, uint8_t *buf, int length)
 {
     SrlStatus status = 0;
@@ -1671,73 +1946,61 @@ SrlStatus hwPconGetEventLogNumPowerCycle(HwInstance instance, uint8_t idx, uint3
 }
 SrlStatus hwPconDumpEventLogMemory(HwInstance instance, uint8_t idx, int event_num, bool display_header, bool verbose)
 {
-    tPconEventLogMemory event_log __attribute__ ((aligned (8)));
-    tPconEventLogSoftware* softwareInfo;
-    SrlStatus status;
-    uint32_t up_time;
     tPoweredOnTime power_up_time;
-    const char *ev_name[] = {"uv", "ov", "oc", "v_a2d", "c_a2d", "ev0_to", "ev1_to", "prm_file"};
-    tPconConfig pconConfig = getPconData(instance, idx);
-    const tPconConfig * config = &pconConfig;
-    const tPconChanConfig * chan_config = config->channels;
     const tPconDevice * pcon_info = hwPconGetPconInfo(instance, idx);
-    status = hwPconGetEventLogMemory(instance, idx, event_num, &event_log);
-    if (status == 0)
-    {
-        softwareInfo = &(hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->softwareReserved : ((tPconEventLogMemory * )&event_log)->softwareReserved);
-        int i;
-        printf("\n");
-        if (display_header)
-            printf("Pcon Device Index %u (name %s, des %s)\n", idx, pcon_info->dev.name, pcon_info->dev.desc);
-        up_time = ( (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->upTimeInSeconds : ((tPconEventLogMemory * )&event_log)->upTimeInSeconds) ==
-                   ~(hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->invUpTimeInSeconds : ((tPconEventLogMemory * )&event_log)->invUpTimeInSeconds)) ?
-                    (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->upTimeInSeconds : ((tPconEventLogMemory * )&event_log)->upTimeInSeconds) : 0;
-        up_time = be32toh(up_time);
-        fromSecondsCalulateOnTime(up_time, &power_up_time);
-        printf("Pcon Event number %d: Powered on: %u days %02u:%02u:%02u, IMBV voltage was %u millivolt when card powered down.\n",
-                event_num, power_up_time.days, power_up_time.hours, power_up_time.minutes, power_up_time.seconds,
-                (uint32_t) ((12.49 / 2.49) * ((((be16toh((hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->rawImbvVoltValue : ((tPconEventLogMemory * )&event_log)->rawImbvVoltValue)) & ((1 << 10) - 1)) * (3000)) / (1 << 10)) + (((((be16toh((hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->rawImbvVoltValue : ((tPconEventLogMemory * )&event_log)->rawImbvVoltValue)) & ((1 << 10) - 1)) * (3000)) % (1 << 10)) + ((1 << 10) >> 1)) / (1 << 10)))));
-        printf("Power Cycle Num: %d, Reset Cycle Num: %d, Reset Reason: %x, epoch time: %lu, crc: %x\n",
-                softwareInfo->powerCycleNum, softwareInfo->resetCycleNum, softwareInfo->resetReason,
-                softwareInfo->epochTime, softwareInfo->crc8);
-        for (i = 0; i < config->channelCount; i++)
+    const PconEventLog * log = hwPconGetEventLog(instance, idx);
+    const PconEventRecord * record = log ? log->event(event_num) : nullptr;
+    if ((pcon_info == nullptr) || (record == nullptr))
+        return (-1);
+    const tPconConfig * config = &pcon_info->config;
+    const tPconEventLogSoftware * softwareInfo = &record->software;
+    int i;
+    printf("\n");
+    if (display_header)
+        printf("Pcon Device Index %u (name %s, des %s)\n", idx, pcon_info->dev.name, pcon_info->dev.desc);
+    fromSecondsCalulateOnTime(record->up_time, &power_up_time);
+    printf("Pcon Event number %d: Powered on: %u days %02u:%02u:%02u, IMBV voltage was %u millivolt when card powered down.\n",
+            event_num, power_up_time.days, power_up_time.hours, power_up_time.minutes, power_up_time.seconds, record->imbv_milli_volt);
+    printf("Power Cycle Num: %d, Reset Cycle Num: %d, Reset Reason: %x, epoch time: %lu, crc: %x\n",
+            softwareInfo->powerCycleNum, softwareInfo->resetCycleNum, softwareInfo->resetReason,
+            softwareInfo->epochTime, softwareInfo->crc8);
+    for (i = 0; i < config->channelCount; i++)
+    {
+        if (config->channels[i].name)
         {
-            if (config->channels[i].name)
+            uint16_t chan_status = record->channel_status[i];
+            if (!(chan_status >> 8))
             {
-                uint16_t chan_status = analyzeChannelStatus((hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->channelStatus[i] : ((tPconEventLogMemory * )&event_log)->channelStatus[i]));
-                if (!(chan_status >> 8))
-                {
-                    int j;
-                    for (j = 0; j < 8; j ++)
-                        if (chan_status & (1 << j))
-                            printf("channel %d: event %s occurred\n", i, ev_name[j]);
-                }
-                else
-                {
-                    printf("channel %d: bad CRC-8 value 0x%02X \n", i, (chan_status >> 8));
-                }
+                int j;
+                for (j = 0; j < PCON_EVENT_TYPES; j ++)
+                    if (chan_status & (1 << j))
+                        printf("channel %d: event %s occurred\n", i, PconEventLog::eventName(j));
+            }
+            else
+            {
+                printf("channel %d: bad CRC-8 value 0x%02X \n", i, (chan_status >> 8));
             }
         }
-        printf("\n");
-        printf("Channel  Name                          prm_file    ev1_to   ev0_to   c_a2d    v_a2d    oc       ov       uv    \n");
-        printf("================================================================================================================\n");
-        for (i = 0; i < config->channelCount; i++)
+    }
+    printf("\n");
+    printf("Channel  Name                          prm_file    ev1_to   ev0_to   c_a2d    v_a2d    oc       ov       uv    \n");
+    printf("================================================================================================================\n");
+    for (i = 0; i < config->channelCount; i++)
+    {
+        if (config->channels[i].name)
         {
-            if (config->channels[i].name)
+            /* a bad crc shows the raw bits, as before */
+            uint8_t bits = record->channel_status[i] & 0xff;
+            if (verbose || record->channel_status[i])
             {
-                const char *chan_name = chan_config[i].name;
-                tChannelStatus chan_status = (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->channelStatus[i] : ((tPconEventLogMemory * )&event_log)->channelStatus[i]);
-                if (verbose || analyzeChannelStatus(chan_status))
-                {
-                    printf("%02u%6s %-30s   %-9u%-9u%-9u%-9u%-9u%-9u%-9u%-9u \n",
-                            i, "", chan_name, chan_status.prm_file, chan_status.ev1_to, chan_status.ev0_to, chan_status.c_a2d,
-                            chan_status.v_a2d, chan_status.oc, chan_status.ov, chan_status.uv);
-                }
+                printf("%02u%6s %-30s   %-9u%-9u%-9u%-9u%-9u%-9u%-9u%-9u \n",
+                        i, "", config->channels[i].name, (bits >> 7) & 1, (bits >> 6) & 1, (bits >> 5) & 1, (bits >> 4) & 1,
+                        (bits >> 3) & 1, (bits >> 2) & 1, (bits >> 1) & 1, bits & 1);
             }
         }
-        printf("\n");
     }
-    return status;
+    printf("\n");
+    return 0;
 }
 bool hwPconIdxIsValid(HwInstance instance, uint8_t idx)
 {
@@ -1795,54 +2058,17 @@ SrlStatus hwPconGetEventLogCurrentOffset(HwInstance instance, uint8_t idx, uint3
 }
 tPconBoardResetType hwPconDeterminePowerCycleType(HwInstance instance, uint8_t idx, uint8_t res_event)
 {
-    tPconBoardResetType reset_type = res_event;
-    tPconEventLogMemory event_log __attribute__ ((aligned (8)));
-    SrlStatus status;
-    uint32_t input_voltage = 0;
-    tPconDevice *pcon_info = hwPconGetPconInfo(instance, idx);
-    if (pcon_info == nullptr)
-    {
-        printf("Could not find pcon %d info for %s\n" "\n", idx, HwInstanceToString(instance).c_str());
-        return 0;
-    }
-    tPconConfig *config = &pcon_info->config;
     tPconEvent *event = hwPconGetPconEventInfo(instance, idx);
-    status = hwPconGetEventLogMemory(instance, idx, -1, &event_log);
-    input_voltage = (uint32_t) ((12.49 / 2.49) * ((((be16toh((hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->rawImbvVoltValue : ((tPconEventLogMemory * )&event_log)->rawImbvVoltValue)) & ((1 << 10) - 1)) * (3000)) / (1 << 10)) + (((((be16toh((hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->rawImbvVoltValue : ((tPconEventLogMemory * )&event_log)->rawImbvVoltValue)) & ((1 << 10) - 1)) * (3000)) % (1 << 10)) + ((1 << 10) >> 1)) / (1 << 10))));
-    if (status == 0)
+    PconEventRecord record;
+    if ((event == nullptr) || (hwPconGetEventRecord(instance, idx, -1, &record) != 0))
     {
-        int i;
-        if ((input_voltage < (7000)) || (input_voltage > (14500)))
-            reset_type = (0x8000);
-        else
-            for (i = 0; i < config->channelCount; i++)
-                if (config->channels[i].name)
-                {
-                    uint16_t chan_status = analyzeChannelStatus((hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->channelStatus[i] : ((tPconEventLogMemory * )&event_log)->channelStatus[i]));
-                    uint8_t event_type = chan_status & 0xff;
-                    if (chan_status >> 8)
-                    {
-                        reset_type = (0x8000) | 0x00ff;
-                        reset_type |= (i << 8);
-                        ;
-                        break;
-                    }
-                    if (event_type > 0)
-                    {
-                        reset_type = (0x8000) | event_type;
-                        reset_type |= (i << 8);
-                        ;
-                        break;
-                    }
-                }
-        event->lastPowerOnDuration = be32toh(( (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->upTimeInSeconds : ((tPconEventLogMemory * )&event_log)->upTimeInSeconds) ==
-                                              ~(hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->invUpTimeInSeconds : ((tPconEventLogMemory * )&event_log)->invUpTimeInSeconds)) ?
-                                               (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->upTimeInSeconds : ((tPconEventLogMemory * )&event_log)->upTimeInSeconds) : 0);
-        uint8_t calculated_crc = crc8CalulateGp07((uint8_t *) &(hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->softwareReserved : ((tPconEventLogMemory * )&event_log)->softwareReserved), (sizeof(tPconEventLogSoftware) - 1));
-        if (calculated_crc == (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->softwareReserved : ((tPconEventLogMemory * )&event_log)->softwareReserved).crc8)
-            event->lastPowerDownTime = (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->softwareReserved : ((tPconEventLogMemory * )&event_log)->softwareReserved).epochTime + event->lastPowerOnDuration;
+        printf("Could not find pcon %d event log for %s\n" "\n", idx, HwInstanceToString(instance).c_str());
+        return res_event;
     }
-    return reset_type;
+    event->lastPowerOnDuration = record.up_time;
+    if (record.software_valid)
+        event->lastPowerDownTime = record.power_down_time;
+    return record.power_cycle_type ? record.power_cycle_type : res_event;
 }
 uint32_t hwPconElapsedSecsSincePowerOn(HwInstance instance, uint8_t idx)
 {
@@ -1996,7 +2222,6 @@ SrlStatus hwPconGetClearEventLogResetReason(HwInstance instance, uint8_t idx)
     uint32_t offset;
     uint8_t res_event;
     uint32_t pow_cyc_num;
-    tPconEventLogMemory event_log __attribute__ ((aligned (8))) = {};
     tPconEventLogSoftware softwareInfo = {};
     if (!hwPconIdxIsValid(instance, idx))
     {
@@ -2006,6 +2231,7 @@ SrlStatus hwPconGetClearEventLogResetReason(HwInstance instance, uint8_t idx)
     time_t epoch_time_now = (GetUnixTime());
     tPconEvent * pcon = hwPconGetPconEventInfo(instance, idx);
     memset(pcon, '\0', sizeof(tPconEvent));
+    PconEventRecord record = {};
     status = hwPconGetEventLogCurrentOffset(instance, idx, &offset);
     status |= hwPconGetEventLogNumPowerCycle(instance, idx, &pow_cyc_num);
     if (status == 0)
@@ -2013,13 +2239,10 @@ SrlStatus hwPconGetClearEventLogResetReason(HwInstance instance, uint8_t idx)
         pcon->numPowerCycles = pow_cyc_num;
         offset = offset + (hwPconIsMini(instance, idx) ? offsetof(tPconMiniEventLogMemory, softwareReserved) : offsetof(tPconEventLogMemory, softwareReserved));
         status = hwPconReadEventLogMemory(instance, idx, offset, (uint8_t *) &softwareInfo, sizeof(softwareInfo));
-        status |= hwPconGetEventLogMemory(instance, idx, -1, &event_log);
-        pcon->lastPowerOnDuration = be32toh(( (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->upTimeInSeconds : ((tPconEventLogMemory * )&event_log)->upTimeInSeconds) ==
-                                             ~(hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->invUpTimeInSeconds : ((tPconEventLogMemory * )&event_log)->invUpTimeInSeconds)) ?
-                                              (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->upTimeInSeconds : ((tPconEventLogMemory * )&event_log)->upTimeInSeconds) : 0);
-        uint8_t calculated_crc = crc8CalulateGp07((uint8_t *) &((hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->softwareReserved : ((tPconEventLogMemory * )&event_log)->softwareReserved)), (sizeof(tPconEventLogSoftware) - 1));
-        if (calculated_crc == (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->softwareReserved : ((tPconEventLogMemory * )&event_log)->softwareReserved).crc8)
-            pcon->lastPowerDownTime = (hwPconIsMini(instance, idx) ? ((tPconMiniEventLogMemory * )&event_log)->softwareReserved : ((tPconEventLogMemory * )&event_log)->softwareReserved).epochTime + pcon->lastPowerOnDuration;
+        status |= hwPconGetEventRecord(instance, idx, -1, &record);
+        pcon->lastPowerOnDuration = record.up_time;
+        if (record.software_valid)
+            pcon->lastPowerDownTime = record.power_down_time;
     }
     if (status == 0)
     {
@@ -2061,6 +2284,7 @@ SrlStatus hwPconGetClearEventLogResetReason(HwInstance instance, uint8_t idx)
         }
         ;
         status = hwPconWriteEventLogMemory(instance, idx, offset, (uint8_t *) &softwareInfo, sizeof(softwareInfo));
+        hwPconDropEventLog(instance, idx);
         hwPconDumpResetReason(instance, idx);
     }
     else
@@ -12,6 +12,7 @@
 #include <vector>
 #include <functional>
 #include "platform_types.h"
+#include "pconTelemetry.h"
 using StringPairMap = std::map<std::string, std::pair<std::string, std::string>>;
 extern "C" {
 typedef uint8_t tPconChan;
@@ -41,13 +42,31 @@ typedef struct
     uint8_t masterChan;
     int8_t voltOffset;
 } tPconRailConfig;
+#define PCON_MAX_CHANNELS 42
+#define PCON_MAX_I2C_CHANNELS 64
+typedef struct
+{
+    uint8_t count;
+    tPconChan chans[PCON_MAX_CHANNELS];
+} tPconRailChannels;
 typedef struct
 {
     const tPconChanConfig * channels;
-    tPconRailConfig * rails;
+    const tPconRailConfig * rails;
     uint8_t channelCount;
     uint8_t railCount;
+    const tPconRailChannels * railChannels;
 } tPconConfig;
+typedef struct
+{
+    uint8_t index;
+    uint8_t i2cChannel;
+} tPconBoardSlot;
+typedef struct
+{
+    int8_t deviceForIndex[PCON_MAX_DEVICES_PER_IOCTRL];
+    int8_t indexForI2cChannel[PCON_MAX_I2C_CHANNELS];
+} tPconBoardMap;
 typedef struct tPconDeviceProfile
 {
     const char * name;
@@ -120,6 +139,28 @@ typedef struct __attribute__ ((__packed__)) {
     tPconEventLogSoftware softwareReserved;
     char reserved1[(42-16)<<1];
 } tPconMiniEventLogMemory;
+typedef struct __attribute__ ((__packed__)) {
+    uint16_t voltSet;
+    uint16_t underVoltSet;
+    uint16_t overVoltSet;
+    uint16_t measuredVolt;
+    uint16_t measuredCurrent;
+    uint16_t currentMultiplier;
+    uint16_t maxCurrent;
+    uint16_t misc;
+} tPconChannelSnapshot;
+typedef struct __attribute__ ((__packed__)) {
+    uint16_t versionId;
+    uint16_t imbvVoltValue;
+    uint16_t imbvError;
+    uint16_t numChannels;
+    tPconChannelSnapshot channels[42];
+} tPconSnapshot;
+typedef struct __attribute__ ((__packed__)) {
+    uint32_t timestampUs;
+    uint16_t measuredVolt;
+    uint16_t measuredCurrent;
+} tPconSample;
 typedef struct {
     uint32_t days : 15;
     uint32_t hours : 5;
@@ -190,6 +231,7 @@ extern SrlStatus hwPconSetUnderVoltageSel(HwInstance instance, uint8_t index, ui
 extern SrlStatus hwPconSetOverVoltageSel(HwInstance instance, uint8_t index, uint32_t rail_num, uint32_t milli_volt);
 extern bool hwPconIdxIsValid(HwInstance instance, uint8_t idx);
 extern SrlStatus hwPconReadEventLogMemory(HwInstance instance, uint8_t idx, uint32_t offset, uint8_t *buf, int length);
+extern SrlStatus hwPconReadEventLogRegion(HwInstance instance, uint8_t idx, uint8_t *buf, size_t length);
 extern SrlStatus hwPconGetEventLogMemory(HwInstance instance, uint8_t idx, int event_num, tPconEventLogMemory * pEventRam);
 extern SrlStatus hwPconGetEventLogMemory(HwInstance instance, uint8_t idx, int event_num, tPconEventLogMemory * pEventRam);
 extern void hwPconDumpEvents(HwInstance instance, uint8_t idx, int num_past_events, bool verbose);
@@ -197,6 +239,8 @@ extern uint32_t hwPconMaxCurDif(HwInstance instance, uint8_t idx);
 extern tSpiParameters getPconSPIParams(HwInstance instance, uint32_t index);
 extern I2CFpgaCtrlrDeviceParams getPconI2CParams(HwInstance instance, uint32_t index, I2CCtrlr *ctrlr);
 void fromSecondsCalulateOnTime(uint32_t seconds, tPoweredOnTime *pOntimeData);
+uint8_t crc8CalulateGp07(uint8_t *message, int nBytes);
+uint16_t analyzeChannelStatus(tChannelStatus chanStatus);
 tPconDevice * hwPconGetPconInfo(HwInstance instance, uint32_t index, bool log_on_failure=1);
 I2CCtrlr hwPconGetI2CCtrlr(HwInstance instance, const tPconDevice& card_info);
 const tPconDeviceProfile * hwPconGetProfile(const tPconDevice * dev);
@@ -206,10 +250,17 @@ extern uint16_t hwPconReadGlobalReg(HwInstance instance, uint32_t index, uint8_t
 extern void hwPconWriteGlobalReg(HwInstance instance, uint32_t index, uint8_t reg, uint16_t value);
 extern uint16_t hwPconReadChannelReg(HwInstance instance, uint32_t index, uint8_t channel, uint8_t reg);
 extern void hwPconWriteChannelReg(HwInstance instance, uint32_t index, uint8_t channel, uint8_t reg, uint16_t value);
+extern SrlStatus hwPconSnapshot(HwInstance instance, uint32_t index, tPconSnapshot *snapshot);
+extern SrlStatus hwPconCaptureSamples(uint32_t index, uint8_t channel, uint32_t rate, uint32_t seconds, std::vector<tPconSample> &samples);
+extern SrlStatus hwPconSampleRail(const tHwPconRailSamplingParams &params, tHwPconRailSamplingResults &results);
+extern void hwPconBenchRegisterAccess(HwInstance instance, uint32_t index, uint32_t iterations);
 extern SrlStatus hwPconGetInputVoltage(HwInstance instance, uint32_t index, uint32_t *milli_volt);
 extern void hwPconShowDevices(HwInstance instance, bool verbose = 0);
 extern std::string hwPconGetDevices(HwInstance instance, bool verbose = 0);
 extern SrlStatus hwPconShowChannelsAll(HwInstance instance);
+extern void hwPconConfigureSampling(uint32_t current_samples, uint32_t workers);
+extern void hwPconForEachDevice(HwInstance instance, const std::function<void(tPconDevice &)> &fn);
+extern SrlStatus hwPconSampleTelemetry(HwInstance instance, tPconDevice &pcon_info, tPconTelemetryDevice &telemetry);
 void hwPconShowRailConfigAll(HwInstance instance);
 extern std::string hwPconGetRailConfigAll(HwInstance instance);
 extern void hwPconShowChannelVoltage(HwInstance instance, uint32_t idx, uint32_t chan, bool verbose = 0);
@@ -223,3 +274,4 @@ std::string hwPconGetResetReasonAll(HwInstance instance);
 SrlStatus hwPconGetOverVoltage(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint32_t idx, tPconConfig *pconConfig, int32_t rail_num, uint32_t *milli_volt);
 SrlStatus hwPconGetUnderVoltage(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint32_t idx, tPconConfig *pconConfig, uint32_t rail_num, uint32_t *milli_volt);
 int hwPconGetCardPconInfo(HwInstance instance, tPconDevice ** card_info);
+int32_t hwPconFindIndexByI2cChannel(HwInstance instance, uint8_t channel);
@@ -2,8 +2,11 @@
  * Copyright (c) 2025 Nokia
  ***********************************************************************************************************************/
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <deque>
+#include <vector>
 #include "replacements.h"
 #include "fpgaImageUtils.h"
 #include "platform_hw_info.h"
@@ -39,6 +42,7 @@ typedef tInt64 tFcwValue;
  tBoolean idt8a3xxxx_debug[10] = { 0};
  tUint32 idt8a3xxxxCurrentEepromBlock[10] = { 0};
  tUint8 idt8a3xxxxEepromLoadStatus[10] = { 0};
+ tUint32 idt8a3xxxxEepromLastBusyUs[10] = { 0};
  tUint16 idt8a3xxxxExpectedProductId[10] = { 0};
  tIdt8a3xxxxDpllInfo idt8a3xxxxDpllInfo[10][idt8a3xxxxNumDpll]
                              = {
@@ -109,6 +113,12 @@ const tFcwValue FCW_42_SIGN_EXTENSION = 0xFFFFFC0000000000;
 const tFcwValue FCW_48_SIGN_BIT = 0x0000800000000000;
 const tFcwValue FCW_48_SIGN_EXTENSION = 0xFFFF000000000000;
 const double TWO_EE_53 = (double)0x0020000000000000;
+const tUint32 IDT8A3XXXX_SPI_MAX_MESSAGE = 4096; /* spidev bufsiz, same chunk spiWriteBlock uses */
+const tUint32 IDT8A3XXXX_SPI_MAX_BURST = IDT8A3XXXX_SPI_MAX_MESSAGE - sizeof(tUint16); /* less the 2-byte address */
+const tUint32 IDT8A3XXXX_DOWNLOAD_MAX_MESSAGE = IDT8A3XXXX_SPI_MAX_MESSAGE;
+const tUint32 IDT8A3XXXX_DOWNLOAD_MAX_SEGMENTS = 64;
+const tUint32 IDT8A3XXXX_SETTLE_MS = 2000; /* the fixed delay the loader always gave each phase */
+const tUint32 IDT8A3XXXX_READY_TIMEOUT_MS = 2000;
  tBoolean idt8a3xxxxEepromIsEmpty(tIdt8a3xxxxDevIndex devIdx);
  void idt8a3xxxxSetRegIsTrigger(tUint16 regOffset)
 {
@@ -178,36 +188,38 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         spiCtrl |= 0x80;
     return spiCtrl;
 }
- tUint8 idt8a3xxxxSpiRead8(tIdt8a3xxxxDevIndex devIdx, tUint16 regOffset)
+ void idt8a3xxxxSpiBurstRead(tIdt8a3xxxxDevIndex devIdx, tUint16 regOffset, tUint8 *data, tUint32 numRegs)
 {
-    tUint8 data = 0;
-    tUint16 spiCtrl = idt8a3xxxxOffsetToSpiCtrl(regOffset, 1);
-    if (spiWriteNRead8(&(idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->addrInfo.spiParms), spiCtrl, sizeof(spiCtrl), &data) != 0)
-        printf("devIdx %u Error reading idt8a3xxxx register 0x%x" "\n", devIdx, regOffset);
-    if (idt8a3xxxx_debug[devIdx])
-        printf("devIdx %u idt8a3xxxx Read 0x%04x:0x%02x" "\n", devIdx, regOffset, data);
-    return data;
+    tUint8 *start = data;
+    tUint32 total = numRegs;
+    while (numRegs > 0)
+    {
+        tUint32 count = (numRegs > IDT8A3XXXX_SPI_MAX_BURST) ? IDT8A3XXXX_SPI_MAX_BURST : numRegs;
+        tUint16 spiCtrl = idt8a3xxxxOffsetToSpiCtrl(regOffset, 1);
+        if (spiWriteNReadBlock(&(idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->addrInfo.spiParms), spiCtrl, sizeof(spiCtrl), data, count) != 0)
+        {
+            printf("devIdx %u Error reading idt8a3xxxx register 0x%x" "\n", devIdx, regOffset);
+            memset(start, 0, total);
+            return;
+        }
+        if (idt8a3xxxx_debug[devIdx])
+        {
+            for (tUint32 i = 0; i < count; i++)
+                printf("devIdx %u idt8a3xxxx Read 0x%04x:0x%02x" "\n", devIdx, regOffset + i, data[i]);
+        }
+        regOffset += count;
+        data += count;
+        numRegs -= count;
+    }
 }
  void idt8a3xxxxGetReg(tIdt8a3xxxxDevIndex devIdx, tUint16 regOffset, tUint32 numRegs, tUint8 *data)
 {
-    int i;
     idt8a3xxxxRegLock(devIdx);
     eIdt8a3xxxxAddressType addrType = idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->addrInfo.addrType;
-    if ((numRegs > 1) && (addrType == idt8a3xxxxHostSpiAddressType) && (numRegs <= 32))
-    {
-    }
-    else
+    switch (addrType)
     {
-        for (i=0; i<numRegs; i++)
-        {
-            tUint8 b = 0;
-            switch (addrType)
-            {
-                case idt8a3xxxxSpiAddressType: b = idt8a3xxxxSpiRead8(devIdx, regOffset+i); break;
-                default: b = 0; break;
-            }
-            data[i] = b;
-        }
+        case idt8a3xxxxSpiAddressType: idt8a3xxxxSpiBurstRead(devIdx, regOffset, data, numRegs); break;
+        default: memset(data, 0, numRegs); break;
     }
     idt8a3xxxxRegUnlock(devIdx);
 }
@@ -889,11 +901,216 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
     idt8a3xxxx1bSetReg8(devIdx, (0xCAE0 + 0x08), 0xA0);
     idt8a3xxxxUsDelay(600);
     idt8a3xxxxRegUnlock(devIdx);
+}
+ typedef struct tIdt8a3xxxxDownloadSegment
+{
+    tUint32 start;
+    tUint32 count;
+    tUint16 lastReg;
+} tIdt8a3xxxxDownloadSegment;
+typedef struct tIdt8a3xxxxDownloadMessage
+{
+    tUint32 firstSegment;
+    tUint32 numSegments;
+    tUint32 numBytes;
+    tUint32 delayUs;
+} tIdt8a3xxxxDownloadMessage;
+typedef struct tIdt8a3xxxxDownloadPlan
+{
+    const void * source;
+    std::vector<tUint8> bytes;
+    std::vector<tIdt8a3xxxxDownloadSegment> segments;
+    std::vector<tIdt8a3xxxxDownloadMessage> messages;
+    tUint32 numRecords;
+} tIdt8a3xxxxDownloadPlan;
+/* a deque so the plans handed out stay where they are when another device adds one */
+static std::deque<tIdt8a3xxxxDownloadPlan> idt8a3xxxxDownloadPlans;
+ inline tBoolean idt8a3xxxxIsPageReg(tUint16 regOffset)
+{
+    return ((regOffset & 0x7FFF) >= 0x7FFC);
+}
+ void idt8a3xxxxPlanAddSegment(tIdt8a3xxxxDownloadPlan * plan, tUint16 regOffset, const tUint8 * data, tUint32 count)
+{
+    tUint16 spiCtrl = idt8a3xxxxOffsetToSpiCtrl(regOffset, 0);
+    tIdt8a3xxxxDownloadSegment segment;
+    segment.start = plan->bytes.size();
+    segment.count = count + sizeof(spiCtrl);
+    segment.lastReg = regOffset + count - 1;
+    plan->bytes.push_back((spiCtrl >> 8) & 0xFF);
+    plan->bytes.push_back((spiCtrl >> 0) & 0xFF);
+    plan->bytes.insert(plan->bytes.end(), data, data + count);
+    plan->segments.push_back(segment);
+}
+ void idt8a3xxxxPlanAppendData(tIdt8a3xxxxDownloadPlan * plan, const tUint8 * data, tUint32 count)
+{
+    plan->bytes.insert(plan->bytes.end(), data, data + count);
+    plan->segments.back().count += count;
+    plan->segments.back().lastReg += count;
+}
+/*
+ * Pack segments into spi messages in order. A message ends after a trigger register so the
+ * device gets its settle time before anything else is written, and is otherwise limited by
+ * the spidev buffer and maxSegments. Segments too large for one message are sent on their own.
+ */
+ void idt8a3xxxxPlanMessages(tIdt8a3xxxxDownloadPlan * plan, tUint32 maxSegments, tUint32 delayUs)
+{
+    tIdt8a3xxxxDownloadMessage message = { 0 };
+    for (tUint32 i = 0; i < plan->segments.size(); i++)
+    {
+        const tIdt8a3xxxxDownloadSegment & segment = plan->segments[i];
+        if ((message.numSegments > 0) &&
+            (((message.numBytes + segment.count) > IDT8A3XXXX_DOWNLOAD_MAX_MESSAGE) ||
+             (message.numSegments >= maxSegments)))
+        {
+            plan->messages.push_back(message);
+            message = { 0 };
+        }
+        if (message.numSegments == 0)
+            message.firstSegment = i;
+        message.numSegments++;
+        message.numBytes += segment.count;
+        message.delayUs = delayUs;
+        if (idt8a3xxxxGetRegIsTrigger(segment.lastReg))
+        {
+            message.delayUs = 200;
+            if ((segment.lastReg | 0x8000) == (0xCAE0 + 0x08))
+                message.delayUs += 300;
+            plan->messages.push_back(message);
+            message = { 0 };
+        }
+    }
+    if (message.numSegments > 0)
+        plan->messages.push_back(message);
+}
+/*
+ * Adjacent firmware records merge into one burst unless they touch the page register. Each
+ * burst still goes out on its own with the 200us gap the loader expects between records.
+ */
+ void idt8a3xxxxPlanFirmware(tIdt8a3xxxxDownloadPlan * plan, const tIdt8aFirmware * firmware)
+{
+    tUint32 nextReg = 0;
+    for (; !idt8aFirmwareEot(firmware); firmware++)
+    {
+        if (!plan->segments.empty() && (firmware->offset == nextReg) &&
+            !idt8a3xxxxIsPageReg(firmware->offset) && !idt8a3xxxxIsPageReg(firmware->offset + firmware->count - 1))
+            idt8a3xxxxPlanAppendData(plan, firmware->data, firmware->count);
+        else
+            idt8a3xxxxPlanAddSegment(plan, firmware->offset, firmware->data, firmware->count);
+        nextReg = firmware->offset + firmware->count;
+        plan->numRecords++;
+    }
+    idt8a3xxxxPlanMessages(plan, 1, 200);
+}
+ void idt8a3xxxxPlanConfig(tIdt8a3xxxxDownloadPlan * plan, const tAdPllConfig * configFile)
+{
+    std::vector<tUint8> data;
+    while (!PLL_EOT(configFile))
+    {
+        tUint16 baseAddr = configFile->offset;
+        data.clear();
+        do
+        {
+            data.push_back((configFile++)->value);
+            plan->numRecords++;
+        } while ((configFile->offset == (baseAddr + data.size())) && !idt8a3xxxxGetRegIsTrigger(baseAddr + data.size() - 1));
+        idt8a3xxxxPlanAddSegment(plan, baseAddr, data.data(), data.size());
+    }
+    idt8a3xxxxPlanMessages(plan, IDT8A3XXXX_DOWNLOAD_MAX_SEGMENTS, 0);
+}
+ const tIdt8a3xxxxDownloadPlan * idt8a3xxxxGetDownloadPlan(const tIdt8aFirmware * firmware, const tAdPllConfig * configFile)
+{
+    const void * source = firmware ? (const void *)firmware : (const void *)configFile;
+    for (const tIdt8a3xxxxDownloadPlan & plan : idt8a3xxxxDownloadPlans)
+    {
+        if (plan.source == source)
+            return &plan;
+    }
+    idt8a3xxxxInitRegIsTriggerBitmap();
+    idt8a3xxxxDownloadPlans.emplace_back();
+    tIdt8a3xxxxDownloadPlan * plan = &idt8a3xxxxDownloadPlans.back();
+    plan->source = source;
+    plan->numRecords = 0;
+    if (firmware)
+        idt8a3xxxxPlanFirmware(plan, firmware);
+    else
+        idt8a3xxxxPlanConfig(plan, configFile);
+    return plan;
+}
+ tStatus idt8a3xxxxRunDownloadPlan(tIdt8a3xxxxDevIndex devIdx, const tIdt8a3xxxxDownloadPlan * plan)
+{
+    const tSpiParameters * spiParms = &(idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->addrInfo.spiParms);
+    tSpiWriteSegment segments[IDT8A3XXXX_DOWNLOAD_MAX_SEGMENTS];
+    tStatus status = 0;
+    idt8a3xxxxRegLock(devIdx);
+    for (const tIdt8a3xxxxDownloadMessage & message : plan->messages)
+    {
+        if (idt8a3xxxxRemoveCheck(devIdx))
+        {
+            status = (-1);
+            break;
+        }
+        for (tUint32 i = 0; i < message.numSegments; i++)
+        {
+            const tIdt8a3xxxxDownloadSegment & segment = plan->segments[message.firstSegment + i];
+            segments[i].data = &plan->bytes[segment.start];
+            segments[i].count = segment.count;
+        }
+        if (message.numSegments == 1)
+            status = spiWriteBlock(spiParms, segments[0].data, segments[0].count);
+        else
+            status = spiWriteSegments(spiParms, segments, message.numSegments);
+        if (status != 0)
+        {
+            printf("devIdx %u Error downloading to idt8a3xxxx register 0x%x" "\n", devIdx,
+                   plan->segments[message.firstSegment].lastReg);
+            break;
+        }
+        if (message.delayUs)
+            idt8a3xxxxUsDelay(message.delayUs);
+    }
+    idt8a3xxxxRegUnlock(devIdx);
+    return status;
+}
+ tBoolean idt8a3xxxxReleaseIs(tIdt8a3xxxxDevIndex devIdx, const tIdt8aFirmwareDesc * firmware)
+{
+    tUint8 release[3];
+    idt8a3xxxxGetReg(devIdx, (0xC014 + 0x10), sizeof(release), release);
+    /* bit 0 of the major release register is the product/development flag, as idt8a3xxxxVersionToString decodes it */
+    return (((release[0] & 0xFE) >> 1) == firmware->major) && (release[1] == firmware->minor) && (release[2] == firmware->hotfix);
+}
+/*
+ * The device is ready once it answers with its product id and, with checkRelease, reports the
+ * downloaded firmware release. The release only shows a finished download when it differed
+ * before, and nothing signals that a config download has settled, so those cases first sit out
+ * settleMs. Fails if the device is not ready IDT8A3XXXX_READY_TIMEOUT_MS after that.
+ */
+ tStatus idt8a3xxxxWaitReady(tIdt8a3xxxxDevIndex devIdx, tBoolean checkRelease, tUint32 settleMs, tUint32 * waitedMs)
+{
+    const tIdt8aFirmwareDesc * firmware = idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->firmware;
+    tUint16 expectedProductId = idt8a3xxxxExpectedProductId[devIdx];
+    *waitedMs = 0;
+    while (*waitedMs < (settleMs + IDT8A3XXXX_READY_TIMEOUT_MS))
+    {
+        if (idt8a3xxxxRemoveCheck(devIdx))
+            return (-1);
+        if (*waitedMs >= settleMs)
+        {
+            tUint16 productId = idt8a3xxxxGeneralGetProductId(devIdx);
+            tBoolean ready = expectedProductId ? (productId == expectedProductId) : ((productId != 0x0000) && (productId != 0xFFFF));
+            if (ready && checkRelease && firmware)
+                ready = idt8a3xxxxReleaseIs(devIdx, firmware);
+            if (ready)
+                return 0;
+        }
+        usleep(10 * 1000);
+        *waitedMs += 10;
+    }
+    printf("devIdx %u not ready after %u ms" "\n", devIdx, *waitedMs);
+    return (-1);
 }
  void idt8a3xxxxBringupByDownload(tIdt8a3xxxxDevIndex devIdx)
 {
-    tUint32 registers = 0;
-    tUint32 bursts = 0;
+    tUint32 waitedMs = 0;
     idt8a3xxxxSwitchTo2bMode(devIdx);
     if (idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->emptyPromOnly)
     {
@@ -913,45 +1130,26 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
                   idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->firmware->hotfix,
                   idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->firmware->name,
                   idt8a3xxxxGeneralGetProductId(devIdx), devIdx);
-        const tIdt8aFirmware * firmware = idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->firmware->firmware;
-        while (!idt8aFirmwareEot(firmware) && !idt8a3xxxxRemoveCheck(devIdx))
-        {
-            idt8a3xxxxSetFirmwareBuffer(devIdx, firmware++);
-            idt8a3xxxxUsDelay(200);
-            bursts++;
-        };
-        if (idt8a3xxxxRemoveCheck(devIdx))
+        const tIdt8a3xxxxDownloadPlan * plan = idt8a3xxxxGetDownloadPlan(idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->firmware->firmware, NULL);
+        tBoolean sameRelease = idt8a3xxxxReleaseIs(devIdx, idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->firmware);
+        if (idt8a3xxxxRunDownloadPlan(devIdx, plan) != 0)
             return;
-        printf("Did %u bursts - now delay %d seconds" "\n", bursts, 2);
-        if (idt8a3xxxxWaitNumSecAndCheckRemoved(devIdx, 2) != 0)
+        if (idt8a3xxxxWaitReady(devIdx, 1, sameRelease ? IDT8A3XXXX_SETTLE_MS : 0, &waitedMs) != 0)
             return;
+        printf("Did %u records in %zu bursts, %zu messages - ready after %u ms" "\n",
+               plan->numRecords, plan->segments.size(), plan->messages.size(), waitedMs);
     }
     idt8a3xxxxEepromLoadStatus[devIdx] = idt8a3xxxxGetReg8(devIdx, (0xC014 + 0x26));
     if (idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->configFile)
     {
         printf("Set registers: productId %04x" "\n", idt8a3xxxxGeneralGetProductId(devIdx));
-        const tAdPllConfig * configFile = idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->configFile;
-        bursts = 0;
-        while (!PLL_EOT(configFile))
-        {
-            tUint16 baseAddr = configFile->offset;
-            tUint8 data[256] = { 0 };
-            tUint32 dataLength = 0;
-            do
-            {
-                data[dataLength++] = (configFile++)->value;
-                registers++;
-            } while(((configFile->offset == (baseAddr + dataLength)) && !idt8a3xxxxGetRegIsTrigger(baseAddr + dataLength - 1) && (dataLength < (unsigned int)(sizeof (data) / sizeof ((data) [0])))));
-            if (idt8a3xxxxRemoveCheck(devIdx))
-                break;
-            idt8a3xxxxSetReg(devIdx, baseAddr, dataLength, data);
-            bursts++;
-        }
-        if (idt8a3xxxxRemoveCheck(devIdx))
+        const tIdt8a3xxxxDownloadPlan * plan = idt8a3xxxxGetDownloadPlan(NULL, idt8a3xxxxCurrentDeviceConfigInfo[devIdx]->configFile);
+        if (idt8a3xxxxRunDownloadPlan(devIdx, plan) != 0)
             return;
-        printf("%u registers in %u bursts - now delay %d seconds on DevIdx %u" "\n", registers, bursts, 2, devIdx);
-        if (idt8a3xxxxWaitNumSecAndCheckRemoved(devIdx, 2) != 0)
+        if (idt8a3xxxxWaitReady(devIdx, 0, IDT8A3XXXX_SETTLE_MS, &waitedMs) != 0)
             return;
+        printf("%u registers in %zu bursts, %zu messages - ready after %u ms on DevIdx %u" "\n",
+               plan->numRecords, plan->segments.size(), plan->messages.size(), waitedMs, devIdx);
     }
     printf("productId %04x" "\n", idt8a3xxxxGeneralGetProductId(devIdx));
     printf("%s" "\n", idt8a3xxxxImageVersionToString(devIdx).c_str());
@@ -1018,6 +1216,29 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         default:
             return "Unknown";
     }
+}
+ tUint16 idt8a3xxxxEepromWaitStatus(tIdt8a3xxxxDevIndex devIdx)
+{
+    tUint16 eepromStatus = 0x0000;
+    tUint32 waitUs = (idt8a3xxxxEepromLastBusyUs[devIdx] * 3) / 4;
+    tUint32 totalUs = 0;
+    if (waitUs < 100)
+        waitUs = 100;
+    while (totalUs < (1000 * 1000))
+    {
+        if (idt8a3xxxxRemoveCheck(devIdx))
+            break;
+        usleep(waitUs);
+        totalUs += waitUs;
+        eepromStatus = idt8a3xxxxGetReg16(devIdx, (0xC014 + 0x08));
+        if (eepromStatus != 0x0000)
+        {
+            idt8a3xxxxEepromLastBusyUs[devIdx] = totalUs;
+            break;
+        }
+        waitUs = (totalUs < (10 * 1000)) ? 100 : (10 * 1000);
+    }
+    return eepromStatus;
 }
  tStatus idt8a3xxxxEepromGetBytes(tIdt8a3xxxxDevIndex devIdx, tUint32 offsetInEeprom, tUint8 numBytes)
 {
@@ -1031,16 +1252,7 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         idt8a3xxxxSetReg16(devIdx, (0xCF68 + 0x02), offsetInBlock);
         tUint16 eepromCmd = 0xEE01;
         idt8a3xxxxSetReg16(devIdx, (0xCF68 + 0x04), eepromCmd);
-        tUint32 numGets = 0;
-        tUint16 eepromStatus = 0x0000;
-        while ((eepromStatus == 0x0000) && (numGets < 100))
-        {
-            if (idt8a3xxxxRemoveCheck(devIdx))
-                break;
-            usleep(10 * 1000);
-            eepromStatus = idt8a3xxxxGetReg16(devIdx, (0xC014 + 0x08));
-            numGets++;
-        }
+        tUint16 eepromStatus = idt8a3xxxxEepromWaitStatus(devIdx);
         if (idt8a3xxxxRemoveCheck(devIdx))
             status = (-1);
         if ((eepromStatus != 0x8000) && !idt8a3xxxxRemoveCheck(devIdx))
@@ -1074,16 +1286,14 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         while (1)
         {
             idt8a3xxxxSetReg16(devIdx, (0xCF68 + 0x04), eepromCmd);
-            tUint32 numGets = 0;
-            tUint16 eepromStatus = 0x0000;
-            while ((eepromStatus == 0x0000) && (numGets < 100))
-            {
-                usleep(10 * 1000);
-                eepromStatus = idt8a3xxxxGetReg16(devIdx, (0xC014 + 0x08));
-                numGets++;
-            }
+            tUint16 eepromStatus = idt8a3xxxxEepromWaitStatus(devIdx);
             if (eepromStatus == 0x8000)
                 break;
+            if (idt8a3xxxxRemoveCheck(devIdx))
+            {
+                status = (-1);
+                break;
+            }
             if (numRetries < 10)
             {
                 numRetries++;
@@ -1130,11 +1340,8 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
             status = idt8a3xxxxEepromGetBytes(devIdx, currentOffsetInEeprom, currentBytes);
             if (status != 0)
                 break;
-            for (int i = 0; i < currentBytes; i++)
-            {
-                *currentDataPtr = idt8a3xxxxGetReg8(devIdx, (0xCF80 + i ));
-                currentDataPtr++;
-            }
+            idt8a3xxxxGetReg(devIdx, 0xCF80, currentBytes, currentDataPtr);
+            currentDataPtr += currentBytes;
             currentOffsetInEeprom += currentBytes;
             bytesLeft -= currentBytes;
         }
@@ -1161,7 +1368,8 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
     }
     return 1;
 }
- tStatus idt8a3xxxxEepromSetRange(tIdt8a3xxxxDevIndex devIdx, tUint32 offsetInEeprom, tUint32 numBytes, const tUint8 * dataPtr)
+ tStatus idt8a3xxxxEepromProgramRange(tIdt8a3xxxxDevIndex devIdx, tUint32 offsetInEeprom, tUint32 numBytes, const tUint8 * dataPtr,
+                                      tBoolean skipUnchanged, tIdt8a3xxxxEepromProgramStats * stats)
 {
     if (((devIdx < idt8a3xxxxNumUsedDevices)) && ((offsetInEeprom + numBytes) <= 0x20000) && (dataPtr != NULL))
     {
@@ -1169,17 +1377,27 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         tUint32 currentOffsetInEeprom = offsetInEeprom;
         tUint32 bytesLeft = numBytes;
         const tUint8 * currentDataPtr = dataPtr;
+        tUint8 currentContents[128];
         while (bytesLeft > 0)
         {
             tUint32 currentBytes = idt8a3xxxCalculateCurrentBytes(currentOffsetInEeprom, bytesLeft);
-            for (int i = 0; i < currentBytes; i++)
+            if (stats != NULL)
+                stats->numChunks++;
+            if (skipUnchanged &&
+                (idt8a3xxxxEepromGetRange(devIdx, currentOffsetInEeprom, currentBytes, currentContents) == 0) &&
+                (memcmp(currentContents, currentDataPtr, currentBytes) == 0))
             {
-                idt8a3xxxxSetReg8(devIdx, (0xCF80 + i ), *currentDataPtr);
-                currentDataPtr++;
+                if (stats != NULL)
+                    stats->numSkipped++;
             }
-            status = idt8a3xxxxEepromSetBytes(devIdx, currentOffsetInEeprom, currentBytes);
-            if (status != 0)
-                break;
+            else
+            {
+                idt8a3xxxxSetReg(devIdx, 0xCF80, currentBytes, const_cast<tUint8 *>(currentDataPtr));
+                status = idt8a3xxxxEepromSetBytes(devIdx, currentOffsetInEeprom, currentBytes);
+                if (status != 0)
+                    break;
+            }
+            currentDataPtr += currentBytes;
             currentOffsetInEeprom += currentBytes;
             bytesLeft -= currentBytes;
         }
@@ -1190,6 +1408,44 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         printf("Bad parm: devIdx %u, offset 0x%04x numBytes 0x%02x dataPtr %p" "\n", devIdx, offsetInEeprom, numBytes, dataPtr);
     }
     return (-1);
+}
+ tStatus idt8a3xxxxEepromSetRange(tIdt8a3xxxxDevIndex devIdx, tUint32 offsetInEeprom, tUint32 numBytes, const tUint8 * dataPtr)
+{
+    return idt8a3xxxxEepromProgramRange(devIdx, offsetInEeprom, numBytes, dataPtr, 0, NULL);
+}
+ tUint32 idt8a3xxxxCrc32(const tUint8 * dataPtr, tUint32 numBytes)
+{
+    tUint32 crc = 0xFFFFFFFF;
+    for (tUint32 i = 0; i < numBytes; i++)
+    {
+        crc ^= dataPtr[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+ tStatus idt8a3xxxxEepromVerifyCrc(tIdt8a3xxxxDevIndex devIdx, tUint32 offsetInEeprom, tUint32 numBytes, const tUint8 * dataPtr)
+{
+    tUint8 * readBack = (tUint8 *) malloc(numBytes);
+    if (readBack == NULL)
+        return (-1);
+    tStatus status = idt8a3xxxxEepromGetRange(devIdx, offsetInEeprom, numBytes, readBack);
+    if (status == 0)
+    {
+        tUint32 expectedCrc = idt8a3xxxxCrc32(dataPtr, numBytes);
+        tUint32 actualCrc = idt8a3xxxxCrc32(readBack, numBytes);
+        if (actualCrc != expectedCrc)
+        {
+            printf("Verify failed: crc32 0x%08x expected 0x%08x\n", actualCrc, expectedCrc);
+            status = (-1);
+        }
+        else
+        {
+            printf("Verify passed: crc32 0x%08x\n", actualCrc);
+        }
+    }
+    free(readBack);
+    return status;
 }
  tStatus idt8a3xxxxEepromSetAll(tIdt8a3xxxxDevIndex devIdx, const tUint8 * dataPtr)
 {
@@ -1259,12 +1515,21 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         dataPtr++;
     }
     printf("\nProgramming the EEPROM...\n");
-    tStatus status = idt8a3xxxxEepromSetAll(devIdx, eeprombits);
+    struct timespec startTime, endTime;
+    tIdt8a3xxxxEepromProgramStats stats = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    tStatus status = idt8a3xxxxEepromProgramRange(devIdx, 0, 0x20000, eeprombits, 1, &stats);
+    if (status == 0)
+        status = idt8a3xxxxEepromVerifyCrc(devIdx, 0, 0x20000, eeprombits);
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
     free(eeprombits);
     if (status == 0)
         printf("Programming passed\n");
     else
         printf("Programming failed\n");
+    printf("%u of %u chunks unchanged and skipped, %.1f seconds\n",
+           stats.numSkipped, stats.numChunks,
+           (endTime.tv_sec - startTime.tv_sec) + ((endTime.tv_nsec - startTime.tv_nsec) / 1e9));
     return status;
 }
  const char *fmtIdt8a3xxxxInput(tUint8 idtInput)
@@ -1502,12 +1767,14 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
         eIdt8a3xxxxInputs idtInput;
         auto inc = [](eIdt8a3xxxxInputs& i) { return (i = static_cast<eIdt8a3xxxxInputs>(static_cast<int>(i) + 1)); };
         tUint8 priority;
+        tUint8 prioRegs[19];
+        idt8a3xxxxGetReg(devIdx, (idt8a3xxxx_module_dpll_offsets[dpll] + 0x0F), sizeof(prioRegs), prioRegs);
         str += Format("  Dpll%u input priorities:\n", dpll);
         for (priority = 0; priority < 19; priority++)
         {
             tUint8 prioVal;
             tBoolean enabled;
-            prioVal = idt8a3xxxxGetReg8(devIdx, (idt8a3xxxx_module_dpll_offsets[dpll] + 0x0F + priority));
+            prioVal = prioRegs[priority];
             enabled = (prioVal & 0x01) != 0;
             idtInput = static_cast<eIdt8a3xxxxInputs>((prioVal & 0x3E) >> 1);
             str += Format("  priority %2u: %sabled, input %u\n",
@@ -1599,7 +1866,9 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
                         dpllIsHitless ? "En":"Dis");
         tUint16 lockedBw = idt8a3xxxxDpllGetLockedBw(devIdx, dpll);
         tUint16 acqBw = idt8a3xxxxDpllGetFastlockBw(devIdx, dpll);
-        tUint16 psl = idt8a3xxxxGetReg16(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x06));
+        tUint8 predRegs[0x14 - 0x06];
+        idt8a3xxxxGetReg(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x06), sizeof(predRegs), predRegs);
+        tUint16 psl = predRegs[0x06 - 0x06] | (predRegs[0x07 - 0x06] << 8);
         tUint8 predCfg = idt8a3xxxxGetReg8(devIdx, (idt8a3xxxx_module_dpll_offsets[dpll] + 0x30));
         tUint8 wpPred = (predCfg & 0x02) >> 1;
         tBoolean predEn = ((predCfg & 0x01) >> 0) == 1;
@@ -1612,20 +1881,20 @@ static inline void idt8a3xxxxRegUnlock(tIdt8a3xxxxDevIndex devIdx)
                         psl,
                         wpPred,
                         predEn ? "en" : "dis");
-        tUint8 predDamp = idt8a3xxxxGetReg8(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x08));
-        tUint8 predMult = idt8a3xxxxGetReg8(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x09));
-        tUint16 predBw = idt8a3xxxxGetReg16(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x0A));
-        tUint16 predPsl = idt8a3xxxxGetReg16(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x0C));
+        tUint8 predDamp = predRegs[0x08 - 0x06];
+        tUint8 predMult = predRegs[0x09 - 0x06];
+        tUint16 predBw = predRegs[0x0A - 0x06] | (predRegs[0x0B - 0x06] << 8);
+        tUint16 predPsl = predRegs[0x0C - 0x06] | (predRegs[0x0D - 0x06] << 8);
         str += Format("  pred0 damping %u bwMult %u bw %u%s psl %uns/s\n",
                         predDamp & 0x0F,
                         predMult & 0xFF,
                         predBw & 0x3FFF,
                         fmtIdt8a3xxxxDpllBwUnit((predBw & 0xC000) >> 14),
                         predPsl);
-        predDamp = idt8a3xxxxGetReg8(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x0E));
-        predMult = idt8a3xxxxGetReg8(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x0F));
-        predBw = idt8a3xxxxGetReg16(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x10));
-        predPsl = idt8a3xxxxGetReg16(devIdx, (idt8a3xxxx_module_dpll_ctrl_offsets[dpll] + 0x12));
+        predDamp = predRegs[0x0E - 0x06];
+        predMult = predRegs[0x0F - 0x06];
+        predBw = predRegs[0x10 - 0x06] | (predRegs[0x11 - 0x06] << 8);
+        predPsl = predRegs[0x12 - 0x06] | (predRegs[0x13 - 0x06] << 8);
         str += Format("  pred1 damping %u bwMult %u bw %u%s psl %uns/s\n",
                         predDamp & 0x0F,
                         predMult & 0xFF,
@@ -153,6 +153,11 @@ typedef struct tIdt8a3xxxxDeviceConfigInfo
     tIdt8a3xxxxOutputConfigInfo outputConfig;
 } tIdt8a3xxxxDeviceConfigInfo;
 typedef tUint8 tIdt8a3xxxxInputPriorityTable[idt8a3xxxxNumInput];
+typedef struct tIdt8a3xxxxEepromProgramStats
+{
+    tUint32 numChunks;
+    tUint32 numSkipped;
+} tIdt8a3xxxxEepromProgramStats;
 extern const tIdt8a3xxxxDeviceConfigInfo *idt8a3xxxxCurrentDeviceConfigInfo[10];
 extern tUint8 idt8a3xxxxDpllGetState(tIdt8a3xxxxDevIndex devIdx, eIdt8a3xxxxDplls dpll);
 extern std::string idt8a3xxxxDpllToString(tIdt8a3xxxxDevIndex devIdx, eIdt8a3xxxxDplls dpll, tBoolean detail);
@@ -174,6 +179,9 @@ extern void idt8a3xxxxSetReg40(tIdt8a3xxxxDevIndex devIdx, tUint16 regOffset, tU
 extern void idt8a3xxxxSetReg48(tIdt8a3xxxxDevIndex devIdx, tUint16 regOffset, tUint64 regVal);
 extern void idt8a3xxxxEepromSetCurrentBlock(tIdt8a3xxxxDevIndex devIdx, tUint32 block);
 extern tStatus idt8a3xxxxProgramEepromFromFile(tIdt8a3xxxxDevIndex devIdx, char *filename, tBoolean verbose);
+extern tStatus idt8a3xxxxEepromProgramRange(tIdt8a3xxxxDevIndex devIdx, tUint32 offsetInEeprom, tUint32 numBytes, const tUint8 * dataPtr,
+                                            tBoolean skipUnchanged, tIdt8a3xxxxEepromProgramStats * stats);
+extern tStatus idt8a3xxxxEepromVerifyCrc(tIdt8a3xxxxDevIndex devIdx, tUint32 offsetInEeprom, tUint32 numBytes, const tUint8 * dataPtr);
 extern tBoolean idt8a3xxxxGetRegIsTrigger(tUint16 regOffset);
 extern void idt8a3xxxxInitRegIsTriggerBitmap(void);
 extern std::string idt8a3xxxxInputsToString(tIdt8a3xxxxDevIndex devIdx, tBoolean detail);
@@ -3,19 +3,36 @@
  ***********************************************************************************************************************/
 #include "replacements.h"
 #include "hwPcon.h"
+#include "pconTelemetry.h"
+#include "pconEventLog.h"
 #include <stdint.h>
+#include <signal.h>
 #include <cstdlib>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <sys/stat.h>
+#include <chrono>
+#include <thread>
 namespace pcon_options {
 bool is_get_all_cmd;
 bool is_dump_events_cmd;
 bool is_reboot_analysis;
 bool is_verbose;
+bool is_bench_cmd;
+bool is_sample_cmd;
+bool is_daemon_cmd;
+bool is_telemetry_cmd;
+bool is_json;
 int dump_pcon_index;
 int dump_event_count;
+int bench_pcon_index;
+int bench_iterations;
+int current_samples = 16;
+int workers = PCON_MAX_DEVICES_PER_IOCTRL;
+int daemon_interval_ms = 1000;
+std::string telemetry_file = PCON_TELEMETRY_NAME;
+tHwPconRailSamplingParams sample_params;
 std::string reboot_output_file;
 std::string_view get_option_value(
     const std::vector<std::string_view>& args,
@@ -46,7 +63,13 @@ void parse(int argc, char* argv[]) {
     is_get_all_cmd = has_switch(args, "-g");
     is_reboot_analysis = has_switch(args, "-r") || has_switch(args, "--reboot-analysis");
     is_verbose = has_switch(args, "-v");
-    if (!is_dump_events_cmd && !is_get_all_cmd && !is_reboot_analysis) {
+    is_bench_cmd = has_switch(args, "-b");
+    is_sample_cmd = has_switch(args, "-s");
+    is_daemon_cmd = has_switch(args, "--daemon");
+    is_telemetry_cmd = has_switch(args, "-t");
+    is_json = has_switch(args, "--json");
+    if (!is_dump_events_cmd && !is_get_all_cmd && !is_reboot_analysis && !is_bench_cmd && !is_sample_cmd &&
+        !is_daemon_cmd && !is_telemetry_cmd) {
         throw std::runtime_error("not doing anything;");
     }
     if (has_switch(args, "-r") && has_switch(args, "--reboot-analysis")) {
@@ -66,6 +89,72 @@ void parse(int argc, char* argv[]) {
             throw std::runtime_error("could not parse event count number; exiting...");
         }
     }
+    if (is_bench_cmd) {
+        std::string str;
+        char *parsed_token;
+        str = get_option_value(args, "-b", 1);
+        bench_pcon_index = strtol(str.c_str(), &parsed_token, 10);
+        if (parsed_token == str.c_str() || *parsed_token != '\0' || errno == ERANGE) {
+            throw std::runtime_error("could not parse pcon index number; exiting...");
+        }
+        str = get_option_value(args, "-b", 2);
+        bench_iterations = strtol(str.c_str(), &parsed_token, 10);
+        if (parsed_token == str.c_str() || *parsed_token != '\0' || errno == ERANGE || bench_iterations <= 0) {
+            throw std::runtime_error("could not parse iteration count; exiting...");
+        }
+    }
+    if (is_sample_cmd) {
+        const char *what[] = {"pcon index", "rail number", "sampling rate", "sampling time"};
+        long parsed[4];
+        for (int i = 0; i < 4; i++) {
+            std::string str;
+            char *parsed_token;
+            str = get_option_value(args, "-s", i + 1);
+            parsed[i] = strtol(str.c_str(), &parsed_token, 10);
+            if (parsed_token == str.c_str() || *parsed_token != '\0' || errno == ERANGE || parsed[i] < 0) {
+                throw std::runtime_error(std::string("could not parse ") + what[i] + "; exiting...");
+            }
+        }
+        sample_params.device_index = parsed[0];
+        sample_params.rail_num = parsed[1];
+        sample_params.sampling_rate = parsed[2];
+        sample_params.sampling_time = parsed[3];
+        if (sample_params.sampling_rate == 0 || sample_params.sampling_time == 0) {
+            throw std::runtime_error("sampling rate and time must be non-zero; exiting...");
+        }
+    }
+    if (has_switch(args, "-n") || has_switch(args, "-j")) {
+        const char *what[] = {"-n", "-j"};
+        int *value[] = {&current_samples, &workers};
+        for (int i = 0; i < 2; i++) {
+            if (!has_switch(args, what[i]))
+                continue;
+            std::string str;
+            char *parsed_token;
+            str = get_option_value(args, what[i], 1);
+            *value[i] = strtol(str.c_str(), &parsed_token, 10);
+            if (parsed_token == str.c_str() || *parsed_token != '\0' || errno == ERANGE || *value[i] <= 0) {
+                throw std::runtime_error(std::string("could not parse ") + what[i] + " count; exiting...");
+            }
+        }
+    }
+    if (is_daemon_cmd) {
+        std::string str;
+        char *parsed_token;
+        str = get_option_value(args, "--daemon", 1);
+        if (!str.empty() && !str.starts_with("-")) {
+            daemon_interval_ms = strtol(str.c_str(), &parsed_token, 10);
+            if (*parsed_token != '\0' || errno == ERANGE || daemon_interval_ms <= 0) {
+                throw std::runtime_error("could not parse daemon interval; exiting...");
+            }
+        }
+    }
+    if (has_switch(args, "--shm")) {
+        telemetry_file = get_option_value(args, "--shm", 1);
+        if (telemetry_file.empty() || telemetry_file.starts_with("-")) {
+            throw std::runtime_error("missing or invalid telemetry file; exiting...");
+        }
+    }
     if (is_reboot_analysis) {
         if (has_switch(args, "-r")) {
             reboot_output_file = get_option_value(args, "-r", 1);
@@ -80,8 +169,81 @@ void parse(int argc, char* argv[]) {
     return;
 }
 void usage(char *command) {
-    printf("%s: ([ -d <pcon index> <event count> ] | [ -g ] [ (-r | --reboot-analysis) <output file>] )\n", command);
+    printf("%s: ([ -d <pcon index> <event count> [ --json ] ] | [ -g ] [ (-r | --reboot-analysis) <output file>] | [ -b <pcon index> <iterations> ] | [ -s <pcon index> <rail> <rate Hz> <seconds> ] | [ --daemon [<interval ms>] ] | [ -t ] ) [ -n <current samples> ] [ -j <workers> ] [ --shm <telemetry file> ]\n", command);
+}
+}
+/*
+ * --daemon: resolve the devices once, then sweep every rail each interval and publish the results for
+ * PconTelemetryReader. Runs until SIGTERM/SIGINT; a sweep that overruns the interval starts the next one late
+ * rather than queueing up.
+ */
+static volatile sig_atomic_t pcon_daemon_stop;
+static void pcon_daemon_signal(int)
+{
+    pcon_daemon_stop = 1;
+}
+static int pcon_daemon(HwInstance instance)
+{
+    PconTelemetryWriter writer(pcon_options::telemetry_file, pcon_options::daemon_interval_ms);
+    if (!writer.isOpen()) {
+        printf("Could not open %s; is another daemon running?\n", pcon_options::telemetry_file.c_str());
+        return EXIT_FAILURE;
+    }
+    tPconDevice *pcon_info;
+    if (hwPconGetCardPconInfo(instance, &pcon_info) <= 0) {
+        printf("No PCON devices on this card\n");
+        return EXIT_FAILURE;
+    }
+    signal(SIGTERM, pcon_daemon_signal);
+    signal(SIGINT, pcon_daemon_signal);
+    static tPconTelemetryDevice devices[PCON_TELEMETRY_DEVICES];
+    auto interval = std::chrono::milliseconds(pcon_options::daemon_interval_ms);
+    auto next = std::chrono::steady_clock::now();
+    while (!pcon_daemon_stop) {
+        hwPconForEachDevice(instance, [&](tPconDevice & device)
+            {
+                if (device.dev.index < PCON_TELEMETRY_DEVICES)
+                    hwPconSampleTelemetry(instance, device, devices[device.dev.index]);
+            });
+        writer.publish(devices);
+        next = std::max(next + interval, std::chrono::steady_clock::now());
+        while (!pcon_daemon_stop && (std::chrono::steady_clock::now() < next))
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(next - std::chrono::steady_clock::now(),
+                                                                                      std::chrono::milliseconds(100)));
+    }
+    return EXIT_SUCCESS;
 }
+static int pcon_show_telemetry()
+{
+    PconTelemetryReader reader(pcon_options::telemetry_file);
+    static tPconTelemetry telemetry;
+    if (!reader.read(&telemetry)) {
+        printf("No telemetry in %s\n", pcon_options::telemetry_file.c_str());
+        return EXIT_FAILURE;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t age_ms = ((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec - telemetry.update_ns) / 1000000;
+    printf("Daemon pid %u  interval %ums  updates %lu  age %lums\n", telemetry.pid, telemetry.interval_ms, telemetry.updates, age_ms);
+    for (uint32_t d = 0; d < PCON_TELEMETRY_DEVICES; d++) {
+        const tPconTelemetryDevice & device = telemetry.devices[d];
+        if (!device.present)
+            continue;
+        printf("\nPCON Device %02u %s  IMBV %umV  sweep %uus\n", d, device.name, device.imbv_milli_volt, device.sweep_us);
+        printf("%-8s %-36s %-12s %-12s\n", "RAIL", "NAME", "VOLTAGE", "CURRENT");
+        for (uint32_t r = 0; r < device.rail_count; r++) {
+            const tPconTelemetryRail & rail = device.rails[r];
+            if (rail.name[0] == '\0')
+                continue;
+            char voltage[16] = "*ERR*", current[16] = "*ERR*";
+            if (rail.flags & PCON_TELEMETRY_VOLT_VALID)
+                snprintf(voltage, sizeof(voltage), "%5umV", rail.milli_volt);
+            if (rail.flags & PCON_TELEMETRY_CURR_VALID)
+                snprintf(current, sizeof(current), "%5umA", rail.milli_amp);
+            printf("%02u%6s %-36s %-12s %-12s\n", r, " ", rail.name, voltage, current);
+        }
+    }
+    return EXIT_SUCCESS;
 }
 int main(int argc, char *argv[])
 {
@@ -98,19 +260,59 @@ int main(int argc, char *argv[])
         pcon_options::usage(argv[0]);
         return EXIT_FAILURE;
     }
+    hwPconConfigureSampling(pcon_options::current_samples, pcon_options::workers);
+    if (pcon_options::is_telemetry_cmd) {
+        return pcon_show_telemetry();
+    }
+    if (pcon_options::is_daemon_cmd) {
+        return pcon_daemon(GetMyHwInstance());
+    }
     if (argc > 0) {
         if (pcon_options::is_dump_events_cmd) {
             HwInstance hw_instance_ = GetMyHwInstance();
-            hwPconDumpEvents(hw_instance_,
-                pcon_options::dump_pcon_index,
-                pcon_options::dump_event_count,
-                pcon_options::is_verbose);
+            if (pcon_options::is_json) {
+                PconEventLog *log = hwPconGetEventLog(hw_instance_, pcon_options::dump_pcon_index);
+                if (log == nullptr) {
+                    printf("Could not read event log of PCON %d\n", pcon_options::dump_pcon_index);
+                    return EXIT_FAILURE;
+                }
+                printf("%s", log->toJson(pcon_options::dump_event_count).c_str());
+            } else {
+                hwPconDumpEvents(hw_instance_,
+                    pcon_options::dump_pcon_index,
+                    pcon_options::dump_event_count,
+                    pcon_options::is_verbose);
+            }
         }
         if (pcon_options::is_get_all_cmd) {
             HwInstance hw_instance_ = GetMyHwInstance();
+            auto start = std::chrono::steady_clock::now();
             hwPconShowDevices(hw_instance_);
             hwPconShowChannelsAll(hw_instance_);
             hwPconShowRailConfigAll(hw_instance_);
+            if (pcon_options::is_verbose) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                printf("Report took %.3f seconds\n", elapsed.count());
+            }
+        }
+        if (pcon_options::is_bench_cmd) {
+            HwInstance hw_instance_ = GetMyHwInstance();
+            hwPconBenchRegisterAccess(hw_instance_,
+                pcon_options::bench_pcon_index,
+                pcon_options::bench_iterations);
+        }
+        if (pcon_options::is_sample_cmd) {
+            tHwPconRailSamplingResults results;
+            if (hwPconSampleRail(pcon_options::sample_params, results) == 0) {
+                printf("Rail %u (%s): %zu samples\n", results.rail_num, results.rail_name, results.sample_values.size());
+                printf("Mean %.1fmV  Ripple p-p %.1fmV  Ripple RMS %.2fmV  Min %umV  Max %umV\n",
+                    results.mean_mv, results.ripple_ptop_mv, results.ripple_rms_mv,
+                    results.sample_min_value, results.sample_max_value);
+            }
+            else {
+                printf("Sampling PCON %u rail %u failed\n",
+                    pcon_options::sample_params.device_index, pcon_options::sample_params.rail_num);
+            }
         }
         if (pcon_options::is_reboot_analysis) {
             HwInstance hw_instance_ = GetMyHwInstance();
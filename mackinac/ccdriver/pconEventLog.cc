@@ -0,0 +1,222 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#include <endian.h>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include "replacements.h"
+#include <fmt/format.h>
+#include "hw_instance.h"
+#include "fpga_if.h"
+#include "platform_hw_info.h"
+#include "platform_types.h"
+#include "pconEventLog.h"
+static const char * const pconEventNames[PCON_EVENT_TYPES] = {"uv", "ov", "oc", "v_a2d", "c_a2d", "ev0_to", "ev1_to", "prm_file"};
+const char * PconEventLog::eventName(int type)
+{
+    return ((type >= 0) && (type < PCON_EVENT_TYPES)) ? pconEventNames[type] : "";
+}
+/* same conversion the event dump has always used for rawImbvVoltValue */
+static uint32_t pconEventImbvMilliVolt(uint16_t raw)
+{
+    uint32_t value = be16toh(raw) & ((1 << 10) - 1);
+    return (uint32_t) ((12.49 / 2.49) * (((value * (3000)) / (1 << 10)) + ((((value * (3000)) % (1 << 10)) + ((1 << 10) >> 1)) / (1 << 10))));
+}
+/* the fields both layouts share, found once per record instead of per access */
+struct PconEventFields
+{
+    const tChannelStatus *channel_status;
+    uint32_t num_channels;
+    uint32_t up_time;
+    uint32_t inv_up_time;
+    uint16_t raw_imbv;
+    const tPconEventLogSoftware *software;
+};
+template <typename Layout> static PconEventFields pconEventFields(const uint8_t *raw)
+{
+    const Layout *log = (const Layout *)raw;
+    return { log->channelStatus, (uint32_t)std::size(log->channelStatus), log->upTimeInSeconds, log->invUpTimeInSeconds,
+             log->rawImbvVoltValue, &log->softwareReserved };
+}
+static void pconEventDecode(bool mini, const tPconConfig *config, const uint8_t *raw, PconEventRecord &record)
+{
+    PconEventFields fields = mini ? pconEventFields<tPconMiniEventLogMemory>(raw) : pconEventFields<tPconEventLogMemory>(raw);
+    memset(&record, 0, sizeof(record));
+    record.up_time = be32toh((fields.up_time == ~fields.inv_up_time) ? fields.up_time : 0);
+    record.imbv_milli_volt = pconEventImbvMilliVolt(fields.raw_imbv);
+    memcpy(&record.software, fields.software, sizeof(record.software));
+    record.software_valid = (crc8CalulateGp07((uint8_t *)&record.software, sizeof(record.software) - 1) == record.software.crc8);
+    if (record.software_valid)
+        record.power_down_time = record.software.epochTime + record.up_time;
+    bool imbv_ok = (record.imbv_milli_volt >= (7000)) && (record.imbv_milli_volt <= (14500));
+    if (!imbv_ok)
+        record.power_cycle_type = (0x8000);
+    for (uint32_t i = 0; (i < config->channelCount) && (i < fields.num_channels); i++)
+    {
+        if (!config->channels[i].name)
+            continue;
+        uint16_t status = analyzeChannelStatus(fields.channel_status[i]);
+        record.channel_status[i] = status;
+        if (status >> 8)
+            record.crc_errors++;
+        else
+            record.event_mask |= status;
+        /* first named channel with a bad crc or an event, as hwPconDeterminePowerCycleType always did */
+        if (imbv_ok && (record.power_cycle_type == 0) && status)
+            record.power_cycle_type = (0x8000) | ((status >> 8) ? 0x00ff : (status & 0xff)) | (i << 8);
+    }
+}
+SrlStatus PconEventLog::load(HwInstance instance, uint8_t pcon_idx)
+{
+    tPconDevice *pcon_info = hwPconGetPconInfo(instance, pcon_idx);
+    if (pcon_info == nullptr)
+        return (-1);
+    loaded = 0;
+    idx = pcon_idx;
+    mini = pcon_info->dev.mini;
+    config = &pcon_info->config;
+    raw.resize(PCON_EVENT_LOG_SIZE);
+    if (hwPconReadEventLogRegion(instance, idx, raw.data(), raw.size()) != 0)
+    {
+        printf("PCON %u: could not read event log memory\n", idx);
+        return (-1);
+    }
+    /* the header keeps the byte order it always had: crc over the three raw pointer bytes, pointer big endian */
+    tPconEventHeader header;
+    memcpy(&header, raw.data(), sizeof(header));
+    uint32_t offset = header.eventPtr;
+    if (crc8CalulateGp07((uint8_t *) &offset, 3) != header.hdrCrc)
+    {
+        printf("PCON %u: bad header(0x%08X) CRC-8 value in event log header\n", idx, (header.hdrCrc << 24 | be32toh(offset << 8)));
+        return (-1);
+    }
+    event_ptr = be32toh(offset << 8);
+    slots.resize(PCON_EVENT_LOG_SLOTS);
+    for (uint32_t slot = 0; slot < PCON_EVENT_LOG_SLOTS; slot++)
+    {
+        pconEventDecode(mini, config, raw.data() + slot * PCON_EVENT_LOG_RECORD, slots[slot]);
+        slots[slot].slot = slot;
+    }
+    loaded = 1;
+    return 0;
+}
+int PconEventLog::numEvents() const
+{
+    uint32_t current = currentSlot();
+    if ((event_ptr >> 10) != 0)
+        return PCON_EVENT_LOG_MAX_EVENTS;
+    return (current > 1) ? (current - 1) : 0;
+}
+int PconEventLog::eventSlot(int event_num) const
+{
+    int current = currentSlot();
+    int distance = (event_num < 0) ? -event_num : event_num;
+    if (distance >= ((1 << 10) - 1))
+        return (-1);
+    if ((event_ptr >> 10) == 0)
+        return (distance >= current) ? current : current + event_num;
+    return (distance >= current) ? (((1 << 10) - 1) + current + event_num) : (current + event_num);
+}
+const PconEventRecord * PconEventLog::event(int event_num) const
+{
+    int slot = loaded ? eventSlot(event_num) : (-1);
+    return (slot < 0) ? nullptr : &slots[slot];
+}
+uint32_t PconEventLog::crcErrors() const
+{
+    uint32_t errors = 0;
+    for (int event_num = -1; event_num >= -numEvents(); event_num--)
+    {
+        const PconEventRecord &record = slots[eventSlot(event_num)];
+        errors += record.crc_errors + !record.software_valid;
+    }
+    return errors;
+}
+static std::string pconJsonString(const char *str)
+{
+    std::string out = "\"";
+    for (const char *p = str ? str : ""; *p; p++)
+    {
+        if ((*p == '"') || (*p == '\\'))
+            out += '\\';
+        if ((unsigned char)*p < 0x20)
+            out += fmt::format("\\u{:04x}", *p);
+        else
+            out += *p;
+    }
+    return out + "\"";
+}
+std::string PconEventLog::toJson(int num_events) const
+{
+    if (!loaded)
+        return "{}";
+    num_events = std::clamp(num_events, 0, numEvents());
+    std::string out = fmt::format("{{\"pcon\": {}, \"mini\": {}, \"event_ptr\": {}, \"current_slot\": {}, \"wrapped\": {}, "
+                                  "\"num_events\": {}, \"crc_errors\": {}, \"current_software\": {{\"power_cycle\": {}, "
+                                  "\"reset_cycle\": {}, \"reset_reason\": {}, \"epoch\": {}}}, \"events\": [",
+                                  idx, mini ? "true" : "false", event_ptr, currentSlot(), (event_ptr >> 10) ? "true" : "false",
+                                  numEvents(), crcErrors(), currentSoftware().powerCycleNum, currentSoftware().resetCycleNum,
+                                  currentSoftware().resetReason, currentSoftware().epochTime);
+    for (int n = 1; n <= num_events; n++)
+    {
+        const PconEventRecord &record = slots[eventSlot(-n)];
+        out += fmt::format("{}\n  {{\"event\": {}, \"slot\": {}, \"up_time\": {}, \"imbv_mv\": {}, \"power_cycle_type\": {}, ",
+                           (n > 1) ? "," : "", -n, record.slot, record.up_time, record.imbv_milli_volt, record.power_cycle_type);
+        if (record.software_valid)
+            out += fmt::format("\"software\": {{\"power_cycle\": {}, \"reset_cycle\": {}, \"reset_reason\": {}, \"epoch\": {}}}, "
+                               "\"power_down_time\": {}, ", record.software.powerCycleNum, record.software.resetCycleNum,
+                               record.software.resetReason, record.software.epochTime, (int64_t)record.power_down_time);
+        else
+            out += "\"software\": null, ";
+        out += "\"channels\": [";
+        bool first = 1;
+        for (uint32_t i = 0; i < config->channelCount; i++)
+        {
+            uint16_t status = record.channel_status[i];
+            if (!status)
+                continue;
+            out += fmt::format("{}{{\"chan\": {}, \"name\": {}, ", first ? "" : ", ", i, pconJsonString(config->channels[i].name));
+            if (status >> 8)
+                out += fmt::format("\"crc_error\": {}}}", status >> 8);
+            else
+            {
+                out += "\"events\": [";
+                for (int type = 0, count = 0; type < PCON_EVENT_TYPES; type++)
+                    if (status & (1 << type))
+                        out += fmt::format("{}\"{}\"", count++ ? ", " : "", pconEventNames[type]);
+                out += "]}";
+            }
+            first = 0;
+        }
+        out += "]}";
+    }
+    return out + "\n]}\n";
+}
+/* one decoded log per PCON; dropped when the software info is rewritten */
+static PconEventLog cardPconEventLog[PCON_MAX_DEVICES_PER_IOCTRL];
+PconEventLog * hwPconGetEventLog(HwInstance instance, uint8_t idx)
+{
+    if ((instance.id != HW_INSTANCE_CARD) || (idx >= PCON_MAX_DEVICES_PER_IOCTRL))
+        return nullptr;
+    PconEventLog &log = cardPconEventLog[idx];
+    if (!log.isLoaded() && (log.load(instance, idx) != 0))
+        return nullptr;
+    return &log;
+}
+void hwPconDropEventLog(HwInstance instance, uint8_t idx)
+{
+    if ((instance.id == HW_INSTANCE_CARD) && (idx < PCON_MAX_DEVICES_PER_IOCTRL))
+        cardPconEventLog[idx].invalidate();
+}
+SrlStatus hwPconGetEventRecord(HwInstance instance, uint8_t idx, int event_num, PconEventRecord *record)
+{
+    tPconEventLogMemory event_log __attribute__ ((aligned (8)));
+    tPconDevice *pcon_info = hwPconGetPconInfo(instance, idx);
+    if ((pcon_info == nullptr) || (record == nullptr))
+        return (-1);
+    if (hwPconGetEventLogMemory(instance, idx, event_num, &event_log) != 0)
+        return (-1);
+    pconEventDecode(pcon_info->dev.mini, &pcon_info->config, (const uint8_t *)&event_log, *record);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#pragma once
+
+#include "hwPcon.h"
+#include <string>
+#include <vector>
+/*
+ * The whole PCON event log NVR, read in one pass and decoded once. The region is the ring header (4 bytes at
+ * offset 0) followed by 128-byte records in slots 1..1023; the header counts events since the log was created,
+ * its low 10 bits being the slot the current power cycle writes to. Event numbers count back from that slot
+ * the way hwPconGetEventLogMemory always has: -1 is the power cycle before this one.
+ *
+ * Every record is decoded on load with its layout (mini or full) chosen once: CRCs checked, up time and IMBV
+ * converted, and the power cycle type hwPconDeterminePowerCycleType would derive from it. Only the event dump
+ * and its JSON form load the whole region; the reset-reason paths read the one record they need through
+ * hwPconGetEventRecord, which decodes it the same way.
+ */
+#define PCON_EVENT_LOG_SLOTS                1024
+#define PCON_EVENT_LOG_RECORD               128
+#define PCON_EVENT_LOG_SIZE                 (PCON_EVENT_LOG_SLOTS * PCON_EVENT_LOG_RECORD)
+#define PCON_EVENT_LOG_MAX_EVENTS           (PCON_EVENT_LOG_SLOTS - 2)
+
+static_assert(sizeof(tPconEventLogMemory) == PCON_EVENT_LOG_RECORD);
+static_assert(sizeof(tPconMiniEventLogMemory) == PCON_EVENT_LOG_RECORD);
+
+enum ePconEventType
+{
+    PCON_EVENT_UV,
+    PCON_EVENT_OV,
+    PCON_EVENT_OC,
+    PCON_EVENT_V_A2D,
+    PCON_EVENT_C_A2D,
+    PCON_EVENT_EV0_TO,
+    PCON_EVENT_EV1_TO,
+    PCON_EVENT_PRM_FILE,
+    PCON_EVENT_TYPES,
+};
+
+struct PconEventRecord
+{
+    uint32_t slot;
+    uint32_t up_time;                       /* seconds powered on, 0 if the inverted copy disagrees */
+    uint32_t imbv_milli_volt;               /* input voltage when the card powered down */
+    tPconEventLogSoftware software;
+    bool software_valid;                    /* crc8 of software matches */
+    time_t power_down_time;                 /* epoch + up time, 0 without valid software info */
+    uint8_t event_mask;                     /* OR of the channel events, bit n is ePconEventType n */
+    uint32_t crc_errors;                    /* channels whose status crc8 did not match */
+    uint16_t channel_status[PCON_MAX_CHANNELS];  /* analyzeChannelStatus(), bad crc in the high byte */
+    tPconBoardResetType power_cycle_type;   /* 0 when neither IMBV nor any channel explains the power cycle */
+};
+
+class PconEventLog
+{
+public:
+    SrlStatus load(HwInstance instance, uint8_t idx);
+    void invalidate() {
+        loaded = 0;
+    }
+    bool isLoaded() const {
+        return loaded;
+    }
+    uint32_t eventPtr() const {
+        return event_ptr;
+    }
+    uint32_t currentSlot() const {
+        return event_ptr % PCON_EVENT_LOG_SLOTS;
+    }
+    uint32_t currentOffset() const {
+        return currentSlot() * PCON_EVENT_LOG_RECORD;
+    }
+    /* number of past events event() can return, -1 .. -numEvents() */
+    int numEvents() const;
+    /* same slot mapping as hwPconGetEventLogMemory; nullptr if |event_num| is out of range */
+    const PconEventRecord *event(int event_num) const;
+    /* software info of the slot the current power cycle writes to */
+    const tPconEventLogSoftware & currentSoftware() const {
+        return slots[currentSlot()].software;
+    }
+    uint32_t crcErrors() const;
+    std::string toJson(int num_events) const;
+    static const char * eventName(int type);
+private:
+    int eventSlot(int event_num) const;
+    bool loaded = 0;
+    bool mini = 0;
+    uint8_t idx = 0;
+    const tPconConfig *config = nullptr;
+    uint32_t event_ptr = 0;
+    std::vector<uint8_t> raw;
+    std::vector<PconEventRecord> slots;
+};
+extern PconEventLog * hwPconGetEventLog(HwInstance instance, uint8_t idx);
+/* drop the loaded log of a PCON after its software info was rewritten */
+extern void hwPconDropEventLog(HwInstance instance, uint8_t idx);
+/* one record read with hwPconGetEventLogMemory and decoded like the loaded log; record->slot is left 0 */
+extern SrlStatus hwPconGetEventRecord(HwInstance instance, uint8_t idx, int event_num, PconEventRecord *record);
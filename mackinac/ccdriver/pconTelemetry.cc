@@ -0,0 +1,159 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#include "pconTelemetry.h"
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+static constexpr int kReadRetries = 1024;
+static uint64_t telemetryNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+static bool telemetryLayoutMatches(const tPconTelemetry *t)
+{
+    return (__atomic_load_n(&t->magic, __ATOMIC_ACQUIRE) == PCON_TELEMETRY_MAGIC) &&
+           (t->version == PCON_TELEMETRY_VERSION) && (t->size == sizeof(tPconTelemetry));
+}
+/* the flock is held for the life of the writer, so a second daemon fails here instead of corrupting the seqlock */
+PconTelemetryWriter::PconTelemetryWriter(const std::string &name, uint32_t interval_ms)
+{
+    struct stat st;
+    fd = open(name.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return;
+    if ((flock(fd, LOCK_EX | LOCK_NB) < 0) || (fstat(fd, &st) < 0) ||
+        ((st.st_size < (off_t)sizeof(tPconTelemetry)) && (ftruncate(fd, sizeof(tPconTelemetry)) < 0)))
+    {
+        close(fd);
+        fd = -1;
+        return;
+    }
+    void *map = mmap(nullptr, sizeof(tPconTelemetry), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        close(fd);
+        fd = -1;
+        return;
+    }
+    shm = (tPconTelemetry *)map;
+    if (!telemetryLayoutMatches(shm))
+    {
+        __atomic_store_n(&shm->magic, 0, __ATOMIC_RELEASE);
+        memset((char *)shm + sizeof(shm->magic), 0, sizeof(*shm) - sizeof(shm->magic));
+        shm->version = PCON_TELEMETRY_VERSION;
+        shm->size = sizeof(*shm);
+        __atomic_store_n(&shm->magic, PCON_TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    }
+    /* a previous daemon may have died mid-publish */
+    uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+    if (seq & 1)
+        __atomic_store_n(&shm->seq, seq + 1, __ATOMIC_RELEASE);
+    shm->pid = getpid();
+    shm->interval_ms = interval_ms;
+}
+PconTelemetryWriter::~PconTelemetryWriter()
+{
+    if (shm != nullptr)
+    {
+        shm->pid = 0;
+        munmap(shm, sizeof(*shm));
+    }
+    if (fd >= 0)
+        close(fd);
+}
+void PconTelemetryWriter::publish(const tPconTelemetryDevice (&devices)[PCON_TELEMETRY_DEVICES])
+{
+    if (shm == nullptr)
+        return;
+    uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(shm->devices, devices, sizeof(shm->devices));
+    shm->update_ns = telemetryNowNs();
+    shm->updates++;
+    __atomic_store_n(&shm->seq, seq + 2, __ATOMIC_RELEASE);
+}
+PconTelemetryReader::PconTelemetryReader(const std::string &name) : name(name)
+{
+    isOpen();
+}
+PconTelemetryReader::~PconTelemetryReader()
+{
+    if (shm != nullptr)
+        munmap((void *)shm, sizeof(*shm));
+}
+bool PconTelemetryReader::isOpen()
+{
+    struct stat st;
+    if (shm != nullptr)
+        return telemetryLayoutMatches(shm);
+    int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(tPconTelemetry)))
+    {
+        void *map = mmap(nullptr, sizeof(tPconTelemetry), PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED)
+            shm = (const tPconTelemetry *)map;
+    }
+    close(fd);
+    return (shm != nullptr) && telemetryLayoutMatches(shm);
+}
+template <typename Copy> bool PconTelemetryReader::readConsistent(Copy &&copy, uint64_t *age_ns)
+{
+    if (!isOpen())
+        return 0;
+    for (int tries = 0; tries < kReadRetries; tries++)
+    {
+        uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+            continue;
+        uint64_t update_ns = shm->update_ns;
+        copy();
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == seq)
+        {
+            /* nothing published yet */
+            if (update_ns == 0)
+                return 0;
+            if (age_ns)
+                *age_ns = telemetryNowNs() - update_ns;
+            return 1;
+        }
+    }
+    return 0;
+}
+bool PconTelemetryReader::readRail(uint32_t index, uint32_t rail, tPconTelemetryRail *value, uint64_t *age_ns)
+{
+    if ((index >= PCON_TELEMETRY_DEVICES) || (rail >= PCON_TELEMETRY_RAILS) || (value == nullptr))
+        return 0;
+    uint32_t present = 0;
+    if (!readConsistent([&]()
+        {
+            present = shm->devices[index].present && (rail < shm->devices[index].rail_count);
+            *value = shm->devices[index].rails[rail];
+        }, age_ns))
+        return 0;
+    return present;
+}
+bool PconTelemetryReader::readDevice(uint32_t index, tPconTelemetryDevice *device, uint64_t *age_ns)
+{
+    if ((index >= PCON_TELEMETRY_DEVICES) || (device == nullptr))
+        return 0;
+    if (!readConsistent([&]() { *device = shm->devices[index]; }, age_ns))
+        return 0;
+    return device->present;
+}
+bool PconTelemetryReader::read(tPconTelemetry *telemetry)
+{
+    if (telemetry == nullptr)
+        return 0;
+    return readConsistent([&]() { *telemetry = *shm; }, nullptr);
+}
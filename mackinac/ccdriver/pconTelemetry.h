@@ -0,0 +1,95 @@
+/**********************************************************************************************************************
+ * Copyright (c) 2025 Nokia
+ ***********************************************************************************************************************/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+/*
+ * Latest PCON rail readings, published by `pcon_cmds --daemon` into a shared file so thermal and pmon consumers
+ * read them without going to the PCONs themselves. The daemon is the only writer (it holds an flock on the
+ * file) and republishes the whole table under a seqlock after every sweep; readers copy what they need and
+ * retry if the sequence moved. Devices are slotted by PCON index, rails by rail number within the device.
+ *
+ * The layout is versioned by magic, version and size; a reader built against another layout does not attach.
+ * The file only ever grows, so a stale mapping never faults.
+ */
+#define PCON_TELEMETRY_NAME                 "/var/run/redis/PCON_telemetry"
+#define PCON_TELEMETRY_MAGIC                0x50435431
+#define PCON_TELEMETRY_VERSION              1
+#define PCON_TELEMETRY_DEVICES              5
+#define PCON_TELEMETRY_RAILS                42
+#define PCON_TELEMETRY_NAME_LEN             40
+
+enum
+{
+    PCON_TELEMETRY_VOLT_VALID = 0x1,
+    PCON_TELEMETRY_CURR_VALID = 0x2,
+};
+
+typedef struct
+{
+    char     name[PCON_TELEMETRY_NAME_LEN];
+    uint32_t milli_volt;
+    uint32_t milli_amp;
+    uint32_t flags;                         /* PCON_TELEMETRY_*_VALID of this sweep */
+    uint32_t pad;
+} tPconTelemetryRail;
+
+typedef struct
+{
+    char     name[PCON_TELEMETRY_NAME_LEN];
+    uint32_t present;
+    uint32_t rail_count;
+    uint32_t imbv_milli_volt;
+    uint32_t sweep_us;                      /* time the daemon took to read this device */
+    tPconTelemetryRail rails[PCON_TELEMETRY_RAILS];
+} tPconTelemetryDevice;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t seq;                           /* odd while the daemon publishes */
+    uint32_t pid;                           /* of the daemon, 0 once it exited */
+    uint32_t interval_ms;
+    uint64_t update_ns;                     /* CLOCK_MONOTONIC of the last publish */
+    uint64_t updates;
+    tPconTelemetryDevice devices[PCON_TELEMETRY_DEVICES];
+} tPconTelemetry;
+
+class PconTelemetryWriter
+{
+public:
+    explicit PconTelemetryWriter(const std::string &name = PCON_TELEMETRY_NAME, uint32_t interval_ms = 0);
+    ~PconTelemetryWriter();
+    bool isOpen() const {
+        return shm != nullptr;
+    }
+    void publish(const tPconTelemetryDevice (&devices)[PCON_TELEMETRY_DEVICES]);
+private:
+    PconTelemetryWriter(const PconTelemetryWriter &) = delete;
+    PconTelemetryWriter& operator=(const PconTelemetryWriter &) = delete;
+    tPconTelemetry *shm = nullptr;
+    int fd = -1;
+};
+
+/* attaches lazily, so it can be constructed before the daemon has run; every read fails until then */
+class PconTelemetryReader
+{
+public:
+    explicit PconTelemetryReader(const std::string &name = PCON_TELEMETRY_NAME);
+    ~PconTelemetryReader();
+    bool isOpen();
+    bool readRail(uint32_t index, uint32_t rail, tPconTelemetryRail *value, uint64_t *age_ns = nullptr);
+    bool readDevice(uint32_t index, tPconTelemetryDevice *device, uint64_t *age_ns = nullptr);
+    bool read(tPconTelemetry *telemetry);
+private:
+    PconTelemetryReader(const PconTelemetryReader &) = delete;
+    PconTelemetryReader& operator=(const PconTelemetryReader &) = delete;
+    template <typename Copy> bool readConsistent(Copy &&copy, uint64_t *age_ns);
+    std::string name;
+    const tPconTelemetry *shm = nullptr;
+};
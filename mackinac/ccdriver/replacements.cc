@@ -4,6 +4,7 @@
 #include "replacements.h"
 #include "platform_hw_info.h"
 #include "hwPcon.h"
+#include "ctlFpgaMap.h"
 #include <stdarg.h>
 #include <unordered_map>
 #include <ctime>
@@ -13,6 +14,10 @@
 #include <linux/spi/spidev.h>
 #include <sys/ioctl.h>
 #include <cstring>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <mutex>
 time_t GetUnixTime(void)
 {
     return std::time(nullptr);
@@ -46,6 +51,8 @@ uint32_t GetNumAsicsIf(void)
 uint32_t GetCtrlFpgaMiscIO2(void)
 {
     uint32_t reg_value;
+    if (CtlFpgaMap::Get(CTL_FPGA_IOCTL).read(0x02700048, &reg_value))
+        return reg_value & 0xffff;
     std::ifstream((GetIOCtlDeviceBase()+"jer_avs").c_str(), std::ios::in) >> std::hex >> reg_value;
     return reg_value;
 }
@@ -157,18 +164,7 @@ std::unordered_map<uint32_t, std::string> channel_reg_map = {
 };
 static int32_t __revFindPconIndex(HwInstance instance, I2CFpgaCtrlrDeviceParams *pDev)
 {
-    tPconDevice *pcon_info;
-    if (int size = hwPconGetCardPconInfo(instance, &pcon_info))
-    {
-        for (int i = 0; i < size; i++)
-        {
-            if (pcon_info[i].dev.dev_params.channel == pDev->channel)
-            {
-                return pcon_info[i].dev.index;
-            }
-        }
-    }
-    return -1;
+    return hwPconFindIndexByI2cChannel(instance, pDev->channel);
 }
 tI2cStatus pconReadGlobalReg(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint32_t reg, uint16_t *value)
 {
@@ -212,80 +208,291 @@ SrlStatus pconWriteChanReg(I2CCtrlr *ctrlr, I2CFpgaCtrlrDeviceParams *pDev, uint
     hwPconWriteChannelReg(instance, index, channel, reg, *value);
     return 0;
 }
-uint16_t hwPconReadGlobalReg(HwInstance instance, uint32_t index, uint8_t reg)
+namespace pcon_register_file {
+constexpr uint32_t kGlobalSlot = 0;
+constexpr uint32_t kChannelSlots = PCON_MAX_CHANNELS + 1;
+constexpr uint32_t kRegSlots = 0x40 >> 1;
+class FdTable
 {
-    uint16_t value = 0;
-    std::string pcon_device_base = GetPconDeviceBase(index);
-    value = 0xffff;
-    if (pcon_device_base != "")
-    {
-        std::string full_path = pcon_device_base + "/" + global_reg_map.at(reg);
-        std::ifstream(full_path, std::ios::in) >> std::hex >> value;
-        ;
+public:
+    static FdTable& Get() {
+        static FdTable instance;
+        return instance;
+    }
+    ~FdTable() {
+        for (auto fd : fds)
+            if (fd >= 0)
+                close(fd);
+        for (auto fd : snapshot_fds)
+            if (fd >= 0)
+                close(fd);
+    }
+    /*
+     * A cached fd goes dead when the driver is rebound, so a failed access closes it and tries
+     * once more on a freshly opened one.
+     */
+    SrlStatus read(uint32_t index, uint32_t slot, uint8_t reg, uint16_t *value) {
+        int fd = getFd(index, slot, reg);
+        if (fd < 0)
+            return (-1);
+        char buf[16];
+        ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+        if ((len < 0) && ((fd = getFd(index, slot, reg, fd)) >= 0))
+            len = pread(fd, buf, sizeof(buf) - 1, 0);
+        if (len <= 0)
+            return (-1);
+        buf[len] = '\0';
+        char *end;
+        unsigned long parsed = strtoul(buf, &end, 16);
+        if (end == buf)
+            return (-1);
+        *value = (uint16_t)parsed;
+        return 0;
+    }
+    SrlStatus readSnapshot(uint32_t index, tPconSnapshot *snapshot) {
+        if (index >= PCON_MAX_DEVICES_PER_IOCTRL)
+            return (-1);
+        int fd = getSnapshotFd(index);
+        if (fd < 0)
+            return (-1);
+        memset(snapshot, 0, sizeof(*snapshot));
+        ssize_t len = pread(fd, snapshot, sizeof(*snapshot), 0);
+        if ((len < 0) && ((fd = getSnapshotFd(index, fd)) >= 0))
+            len = pread(fd, snapshot, sizeof(*snapshot), 0);
+        if ((len < (ssize_t)offsetof(tPconSnapshot, channels)) ||
+            (len != (ssize_t)(offsetof(tPconSnapshot, channels) + snapshot->numChannels * sizeof(tPconChannelSnapshot))))
+            return (-1);
+        return 0;
+    }
+    SrlStatus write(uint32_t index, uint32_t slot, uint8_t reg, uint16_t value) {
+        int fd = getFd(index, slot, reg);
+        if (fd < 0)
+            return (-1);
+        char buf[16];
+        int len = snprintf(buf, sizeof(buf), "%u", value);
+        ssize_t written = pwrite(fd, buf, len, 0);
+        if ((written < 0) && ((fd = getFd(index, slot, reg, fd)) >= 0))
+            written = pwrite(fd, buf, len, 0);
+        if (written != len)
+            return (-1);
+        return 0;
+    }
+private:
+    std::array<int, PCON_MAX_DEVICES_PER_IOCTRL * kChannelSlots * kRegSlots> fds;
+    std::array<int, PCON_MAX_DEVICES_PER_IOCTRL> snapshot_fds;
+    std::mutex open_lock;
+    FdTable() {
+        fds.fill(-1);
+        snapshot_fds.fill(-1);
+    }
+    /* closes stale if it is still the cached fd, so only the first thread to see it fail reopens */
+    void dropFd(int &fd, int stale) {
+        if ((stale >= 0) && (fd == stale)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    int getSnapshotFd(uint32_t index, int stale = -1) {
+        int &fd = snapshot_fds[index];
+        if ((fd >= 0) && (fd != stale))
+            return fd;
+        std::lock_guard<std::mutex> guard(open_lock);
+        dropFd(fd, stale);
+        if (fd >= 0)
+            return fd;
+        std::string pcon_device_base = GetPconDeviceBase(index);
+        if (pcon_device_base == "")
+            return -1;
+        fd = open((pcon_device_base + "/snapshot").c_str(), O_RDONLY);
+        return fd;
+    }
+    int getFd(uint32_t index, uint32_t slot, uint8_t reg, int stale = -1) {
+        if ((index >= PCON_MAX_DEVICES_PER_IOCTRL) || (slot >= kChannelSlots) || ((reg >> 1) >= kRegSlots))
+            return -1;
+        int &fd = fds[(index * kChannelSlots + slot) * kRegSlots + (reg >> 1)];
+        if ((fd >= 0) && (fd != stale))
+            return fd;
+        std::lock_guard<std::mutex> guard(open_lock);
+        dropFd(fd, stale);
+        if (fd >= 0)
+            return fd;
+        std::string pcon_device_base = GetPconDeviceBase(index);
+        if (pcon_device_base == "")
+            return -1;
+        std::string full_path;
+        if (slot == kGlobalSlot)
+            full_path = pcon_device_base + "/" + global_reg_map.at(reg);
+        else
+            full_path = pcon_device_base + "/channel" + std::to_string(slot - 1) + "/" + channel_reg_map.at(reg);
+        fd = open(full_path.c_str(), O_RDWR);
+        if (fd < 0)
+            fd = open(full_path.c_str(), O_RDONLY);
+        return fd;
     }
+};
+}
+uint16_t hwPconReadGlobalReg(HwInstance instance, uint32_t index, uint8_t reg)
+{
+    uint16_t value = 0xffff;
+    if (pcon_register_file::FdTable::Get().read(index, pcon_register_file::kGlobalSlot, reg, &value) != 0)
+        value = 0xffff;
     return value;
 }
 void hwPconWriteGlobalReg(HwInstance instance, uint32_t index, uint8_t reg, uint16_t value)
 {
-    std::string pcon_device_base = GetPconDeviceBase(index);
-    if (pcon_device_base != "")
-    {
-        std::string full_path = pcon_device_base + "/" + global_reg_map.at(reg);
-        std::ofstream(full_path, std::ios::out) << value;
-        ;
-    }
+    if (GetPconDeviceBase(index) != "")
+        pcon_register_file::FdTable::Get().write(index, pcon_register_file::kGlobalSlot, reg, value);
     else
         printf("No PCON device at index %u\n", index);
 }
 uint16_t hwPconReadChannelReg(HwInstance instance, uint32_t index, uint8_t channel, uint8_t reg)
 {
-    uint16_t value = 0;
-    SrlStatus status;
-    std::string pcon_device_base = GetPconDeviceBase(index);
+    uint16_t value = 0xffff;
     tPconDevice *pcon_info = hwPconGetPconInfo(instance, index);
-    value = 0xffff;
-    if (pcon_device_base != "")
+    if (pcon_info == nullptr)
     {
-        if (channel >= pcon_info->config.channelCount)
-        {
-            printf("Invalid channel %u\n", channel);
-            status = (-1);
-        }
-        else
-        {
-            status = 0;
-            std::string full_path = pcon_device_base + "/channel" + std::to_string(channel) + "/" + channel_reg_map.at(reg);
-            std::ifstream(full_path, std::ios::in) >> std::hex >> value;
-        }
-        if (status != 0)
-            value = 0xffff;
-    }
-    else
         printf("No PCON device at index %u\n", index);
+    }
+    else if (channel >= pcon_info->config.channelCount)
+    {
+        printf("Invalid channel %u\n", channel);
+    }
+    else if (pcon_register_file::FdTable::Get().read(index, channel + 1, reg, &value) != 0)
+    {
+        value = 0xffff;
+    }
     return value;
 }
 void hwPconWriteChannelReg(HwInstance instance, uint32_t index, uint8_t channel, uint8_t reg, uint16_t value)
 {
-    SrlStatus status;
-    std::string pcon_device_base = GetPconDeviceBase(index);
     tPconDevice *pcon_info = hwPconGetPconInfo(instance, index);
-    if (pcon_device_base != "")
+    if ((pcon_info == nullptr) || (GetPconDeviceBase(index) == ""))
     {
-        if (channel >= pcon_info->config.channelCount)
-        {
-            printf("Invalid channel %u\n", channel);
-            status = (-1);
-        }
-        else
-        {
-            status = 0;
-            std::string full_path = pcon_device_base + "/channel" + std::to_string(channel) + "/" + channel_reg_map.at(reg);
-            std::ofstream(full_path, std::ios::out) << value;
-        }
+        printf("No PCON device at index %u\n", index);
+    }
+    else if (channel >= pcon_info->config.channelCount)
+    {
+        printf("Invalid channel %u\n", channel);
     }
     else
+    {
+        pcon_register_file::FdTable::Get().write(index, channel + 1, reg, value);
+    }
+}
+SrlStatus hwPconSnapshot(HwInstance instance, uint32_t index, tPconSnapshot *snapshot)
+{
+    if (snapshot == nullptr)
+        return (-1);
+    return pcon_register_file::FdTable::Get().readSnapshot(index, snapshot);
+}
+static bool hwPconWriteSysfs(const std::string &full_path, uint32_t value)
+{
+    std::ofstream file(full_path, std::ios::out);
+    file << value;
+    file.flush();
+    return file.good();
+}
+static void hwPconDrainSamples(int fd, std::vector<tPconSample> &samples)
+{
+    tPconSample chunk[512];
+    ssize_t len;
+    while ((len = pread(fd, chunk, sizeof(chunk), 0)) > 0)
+        samples.insert(samples.end(), chunk, chunk + (len / sizeof(tPconSample)));
+}
+SrlStatus hwPconCaptureSamples(uint32_t index, uint8_t channel, uint32_t rate, uint32_t seconds, std::vector<tPconSample> &samples)
+{
+    std::string pcon_device_base = GetPconDeviceBase(index);
+    if (pcon_device_base == "")
+    {
         printf("No PCON device at index %u\n", index);
-    return;
+        return (-1);
+    }
+    std::string enable_path = pcon_device_base + "/sample_enable";
+    if (!hwPconWriteSysfs(enable_path, 0) ||
+        !hwPconWriteSysfs(pcon_device_base + "/sample_channel", channel) ||
+        !hwPconWriteSysfs(pcon_device_base + "/sample_rate", rate))
+    {
+        printf("PCON %u: could not configure sampler for channel %u at %u Hz\n", index, channel, rate);
+        return (-1);
+    }
+    int fd = open((pcon_device_base + "/samples").c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        printf("PCON %u: sampler not supported by driver\n", index);
+        return (-1);
+    }
+    samples.clear();
+    samples.reserve((size_t)rate * seconds);
+    if (!hwPconWriteSysfs(enable_path, 1))
+    {
+        close(fd);
+        return (-1);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        hwPconDrainSamples(fd, samples);
+        SleepMilliSeconds(100);
+    }
+    hwPconWriteSysfs(enable_path, 0);
+    hwPconDrainSamples(fd, samples);
+    close(fd);
+    uint32_t dropped = 0;
+    std::ifstream(pcon_device_base + "/sample_dropped", std::ios::in) >> dropped;
+    if (dropped)
+        printf("PCON %u: sampler dropped %u samples\n", index, dropped);
+    return samples.empty() ? (-1) : 0;
+}
+static uint16_t hwPconReadRegFile(const std::string &full_path)
+{
+    uint16_t value = 0xffff;
+    std::ifstream(full_path, std::ios::in) >> std::hex >> value;
+    return value;
+}
+void hwPconBenchRegisterAccess(HwInstance instance, uint32_t index, uint32_t iterations)
+{
+    tPconDevice *pcon_info = hwPconGetPconInfo(instance, index);
+    std::string pcon_device_base = GetPconDeviceBase(index);
+    if ((pcon_info == nullptr) || (pcon_device_base == ""))
+    {
+        printf("No PCON device at index %u\n", index);
+        return;
+    }
+    if (iterations == 0)
+        iterations = 1;
+    auto time_ns = [iterations](const std::function<void(void)> &access) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++)
+            access();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+    };
+    double stream_total = 0;
+    double cached_total = 0;
+    printf("PCON Device %02u: %u iterations per register\n", index, iterations);
+    printf("%-8s %-28s %-14s %-14s %-8s\n", "CHANNEL", "REGISTER", "IFSTREAM ns", "PREAD ns", "SPEEDUP");
+    printf("%-8s %-28s %-14s %-14s %-8s\n", "=======", "========", "===========", "========", "=======");
+    auto report = [&](const char *channel, const std::string &name, double stream_ns, double cached_ns) {
+        stream_total += stream_ns;
+        cached_total += cached_ns;
+        printf("%-8s %-28s %-14.0f %-14.0f %.1fx\n", channel, name.c_str(), stream_ns, cached_ns,
+               (cached_ns > 0) ? stream_ns / cached_ns : 0.0);
+    };
+    for (const auto &[reg, name] : global_reg_map)
+    {
+        std::string full_path = pcon_device_base + "/" + name;
+        double stream_ns = time_ns([&]() { hwPconReadRegFile(full_path); });
+        double cached_ns = time_ns([&]() { hwPconReadGlobalReg(instance, index, reg); });
+        report("global", name, stream_ns, cached_ns);
+    }
+    for (const auto &[reg, name] : channel_reg_map)
+    {
+        std::string full_path = pcon_device_base + "/channel0/" + name;
+        double stream_ns = time_ns([&]() { hwPconReadRegFile(full_path); });
+        double cached_ns = time_ns([&]() { hwPconReadChannelReg(instance, index, 0, reg); });
+        report("0", name, stream_ns, cached_ns);
+    }
+    printf("Total per sweep: ifstream %.0f ns, pread %.0f ns\n", stream_total, cached_total);
 }
 namespace srlinux::platform::spi
 {
@@ -380,6 +587,23 @@ SrlStatus spiWriteNRead8(const tSpiParameters *parms, uint32_t wrdata, uint8_t w
     *rddata = rx_buffer[0];
     return status;
 }
+SrlStatus spiWriteNReadBlock(const tSpiParameters *parms, uint32_t wrdata, uint8_t wrbytes, uint8_t *rddata, uint32_t rdcount)
+{
+    SrlStatus status = 0;
+    ;
+    int fd = GetSpiFd(parms);
+    uint8_t tx_buffer[4];
+    byte_shift_word(wrdata, tx_buffer, wrbytes);
+    int rc;
+    rc = spi_xfer(fd, tx_buffer, wrbytes, rddata, rdcount);
+    if (rc < 0 ) {
+        printf("%s(): %s failed with %i (%s)\n",
+            __FUNCTION__, "spi_xfer", rc, strerror(errno));
+        return (-1);
+    }
+    ;
+    return status;
+}
 SrlStatus spiWrite8BlockRead(const tSpiParameters *parms, uint32_t wrdata, uint8_t *rddata, uint8_t rdbytes)
 {
     SrlStatus status = 0;
@@ -415,6 +639,23 @@ SrlStatus spiWriteBlock(const tSpiParameters *parms, const uint8_t *wrdata, uint
         return status;
     }
 }
+SrlStatus spiWriteSegments(const tSpiParameters *parms, const tSpiWriteSegment *segments, uint32_t numSegments)
+{
+    SrlStatus status = 0;
+    int fd = GetSpiFd(parms);
+    std::vector<const uint8_t *> buffers(numSegments);
+    std::vector<uint32_t> lens(numSegments);
+    for (uint32_t i = 0; i < numSegments; i++) {
+        buffers[i] = segments[i].data;
+        lens[i] = segments[i].count;
+    }
+    int rc = spi_write_multi(fd, buffers.data(), lens.data(), numSegments);
+    if (rc < 0 ) {
+        printf("%s(): failed with %i (%s), numSegments = %u\n",__FUNCTION__, rc, strerror(errno), numSegments);
+        return (-1);
+    }
+    return status;
+}
 }
 std::string HwInstanceToString(HwInstance instance)
 {
@@ -502,6 +743,19 @@ int spi_write(int fd, const uint8_t *tx_buffer, uint32_t tx_len, bool end)
     rc = ioctl(fd, SPI_IOC_MESSAGE(1), ioc_message);
     return rc;
 }
+int spi_write_multi(int fd, const uint8_t * const *tx_buffers, const uint32_t *tx_lens, uint32_t count)
+{
+    int rc;
+    std::vector<struct spi_ioc_transfer> ioc_message(count);
+    memset(ioc_message.data(), 0, count * sizeof(struct spi_ioc_transfer));
+    for (uint32_t i = 0; i < count; i++) {
+        ioc_message[i].tx_buf = (unsigned long)tx_buffers[i];
+        ioc_message[i].len = tx_lens[i];
+        ioc_message[i].cs_change = 1;
+    }
+    rc = ioctl(fd, SPI_IOC_MESSAGE(count), ioc_message.data());
+    return rc;
+}
 int spi_write_two(int fd, const uint8_t *tx_buffer1, uint32_t tx_len1,
                 const uint8_t *tx_buffer2, uint32_t tx_len2)
 {
@@ -35,6 +35,7 @@ uint32_t GetCtrlFpgaMiscIO2(void);
 std::string GetPconDeviceBase(uint32_t pcon_index);
 std::string GetCPCtlDeviceBase(void);
 std::string GetIOCtlDeviceBase(void);
+std::string GetCtlFpgaRegsDevice(CtlFpgaId fpga_id);
 std::string GetSpiDevice(const tSpiParameters *spi_paramters);
 int GetSpiFd(const tSpiParameters *spi_paramters);
 int spi_open(const char *device);
@@ -43,3 +44,4 @@ int spi_xfer(int fd, const uint8_t *tx_buffer, uint32_t tx_len, uint8_t *rx_buff
 int spi_read(int fd, uint8_t *rx_buffer, uint32_t rx_len);
 int spi_write(int fd, const uint8_t *tx_buffer, uint32_t tx_len, bool end=1);
 int spi_write_two(int fd, const uint8_t *tx_buffer1, uint32_t tx_len1, const uint8_t *tx_buffer2, uint32_t tx_len2);
+int spi_write_multi(int fd, const uint8_t * const *tx_buffers, const uint32_t *tx_lens, uint32_t count);
@@ -14,7 +14,9 @@
 #include <linux/i2c-mux.h>
 #include <linux/cdev.h>
 #include <linux/device.h>
+#include <linux/miscdevice.h>
 #include <linux/spi/spi.h>
+#include <linux/hrtimer.h>
 
 #define MODULE_NAME     "cpuctl"
 #define PCI_VENDOR_ID_NOKIA 0x1064
@@ -42,7 +44,25 @@ typedef struct
 		u32 backoff_cnt;
 		u32 throttle_cnt;
 		u8 throttle_min;
+		u32 switches;       // modsel switches onto this chan
+		u32 grants;
+		u64 wait_ns;        // lock_bus to parent bus owned
+		u64 max_wait_ns;
 	}chan_stats[CTL_MAX_I2C_CHANS];
+	/* orders transfers on the mux channels, see cpuctl_i2c.c */
+	struct {
+		spinlock_t lock;
+		struct list_head waiters;
+		const struct i2c_lock_operations *parent_ops;
+		struct task_struct *owner;
+		struct hrtimer linger;
+		s8 linger_modsel;   // >= 0 while the bus is held for this modsel
+		u16 passed;         // consecutive grants ahead of the oldest waiter
+		u64 reorders;
+		u64 lingers;
+		u64 linger_hits;
+		u64 forced;
+	}sched;
 	u8 phys_chan;
 	u8 virt_chan;
 	s8 current_modsel;
@@ -55,7 +75,22 @@ typedef struct
 	struct {
 		spinlock_t lock;
 		struct spi_controller spis[N_SPI_MINORS];
+		struct dentry *debugfs;
+		struct _spi_stats {
+			u64 msgs;
+			u64 bytes;
+			u64 ns;
+			u64 max_ns;
+			u64 last_bytes;
+			u64 last_ns;
+			u64 words;
+			u64 errors;
+		}stats;
 	}spi;
+	struct {
+		struct miscdevice misc;
+		char name[32];
+	}regs;
 } CTLDEV;
 
 struct ctlmux {
@@ -106,6 +141,12 @@ extern uint debug;
 #define CTL_DEBUG_I2C 0x0001
 #define CTL_DEBUG_SPI 0x0002
 
+/* module_param */
+extern uint i2c_sched;
+extern uint i2c_sched_batch;
+extern uint i2c_sched_wait_ms;
+extern uint i2c_sched_linger_us;
+
 static inline int ctlv_is_cp(enum ctl_type t) {
 	switch (t) {
 		case ctl_cp:
@@ -124,6 +165,9 @@ void ctl_i2c_remove(CTLDEV *pdev);
 int ctl_sysfs_init(CTLDEV *pdev);
 void ctl_sysfs_remove(CTLDEV *pdev);
 
+int ctl_mmap_init(CTLDEV *pdev);
+void ctl_mmap_remove(CTLDEV *pdev);
+
 static inline u32 ctl_reg_read(CTLDEV *p, unsigned offset)
 {
 	volatile void __iomem *addr = (p->base + offset);
@@ -221,6 +265,15 @@ static inline void ctl_reg8_write(CTLDEV *p, unsigned offset, u8 value)
 #define MISCIO4_IO_VERM_IMM_PLL_RST_N_BIT       (1 << 24)
 #define MISCIO4_IO_VERM_IMM_PLL2_RST_N_BIT      (1 << 25)
 
+/*
+ * Read-only status pages exported by mmap on /dev/<ctlv name>_regs, one page each and
+ * in this order; registers are big endian as seen by ctl_reg_read.
+ */
+#define CTL_MMAP_WIN_CNTR       0x00800000  /* CTL_CNTR_STA, CTL_CARD_TYPE, FPGA_A32_CODE_VER */
+#define CTL_MMAP_WIN_PORT       0x00807000  /* IO_A32_PORT_MOD_ABS/RST/LPMODE, QSFP modsel */
+#define CTL_MMAP_WIN_MISCIO     0x02700000  /* CTL_MISC_IO*_DAT, LED state */
+#define CTL_MMAP_NUM_WIN        3
+
 #define IS_HW_CARD_TYPE_HORNET_R2 0
 
 extern void ctl_clk_reset(CTLDEV * pdev);
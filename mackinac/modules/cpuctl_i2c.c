@@ -477,6 +477,7 @@ static int ctl_select_chan(struct i2c_mux_core *muxc, u32 chan)
 			ctl_reg_write(pdev,offset,val);
 			msleep(5);
 			pdev->current_modsel = pchan->modsel;
+			pdev->chan_stats[chan].switches++;
 		} else {
 			/* same device */
 			unsigned dur = (ktime_get_ns() - pdev->chan_stats[chan].last_xfer)/1000;
@@ -509,6 +510,232 @@ static int ctl_deselect_mux(struct i2c_mux_core *muxc, u32 chan)
 	return rc;
 }
 
+/*
+ * Transfer scheduler for the mux channels.
+ *
+ * A modsel switch costs 5ms, so when several transfers are pending the bus goes
+ * to the oldest one that needs no switch (no modsel, or the modsel already
+ * selected) rather than to the oldest one. When every waiter needs a switch the
+ * bus is held for i2c_sched_linger_us so the owner that just finished can issue
+ * its next transfer to the same module. At most i2c_sched_batch grants in a row
+ * go ahead of the oldest waiter, and a waiter older than i2c_sched_wait_ms is
+ * served next.
+ *
+ * It wraps the lock_ops i2c-mux installed on the channel adapters, which still
+ * take the parent bus once a transfer is granted.
+ */
+struct ctl_sched_waiter {
+	struct list_head list;
+	struct task_struct *task;
+	u64 enq_ns;
+	u32 chan;
+	bool granted;
+};
+
+static CTLDEV *ctl_sched_dev(struct i2c_adapter *adap)
+{
+	return i2c_get_adapdata(i2c_parent_is_i2c_adapter(adap));
+}
+
+static u32 ctl_sched_chan(CTLDEV *pdev, struct i2c_adapter *adap)
+{
+	struct i2c_mux_core *muxc = pdev->ctlmuxcore;
+	u32 i;
+
+	for (i = 0; i < muxc->num_adapters; i++)
+		if (muxc->adapter[i] == adap)
+			return i;
+	return 0;
+}
+
+static bool ctl_sched_switches(CTLDEV *pdev, u32 chan)
+{
+	s8 modsel = pdev->ctlv->pchanmap[chan].modsel;
+	return (modsel >= 0) && (modsel != READ_ONCE(pdev->current_modsel));
+}
+
+static void ctl_sched_account(CTLDEV *pdev, u32 chan, u64 t0)
+{
+	struct _chan_stats *cs = &pdev->chan_stats[chan];
+	u64 wait = ktime_get_ns() - t0;
+
+	/* under the parent bus lock */
+	cs->grants++;
+	cs->wait_ns += wait;
+	if (wait > cs->max_wait_ns)
+		cs->max_wait_ns = wait;
+}
+
+/* sched.lock held */
+static void ctl_sched_grant(CTLDEV *pdev, struct ctl_sched_waiter *w)
+{
+	struct task_struct *task = w->task;
+
+	list_del(&w->list);
+	pdev->sched.owner = task;
+	/* w is gone once the waiter sees granted */
+	smp_store_release(&w->granted, true);
+	wake_up_process(task);
+}
+
+/* sched.lock held; can chan have the bus right now without queueing */
+static bool ctl_sched_take(CTLDEV *pdev, u32 chan)
+{
+	if (pdev->sched.owner)
+		return false;
+	if (pdev->sched.linger_modsel >= 0) {
+		if (ctl_sched_switches(pdev, chan) || (pdev->sched.passed >= i2c_sched_batch))
+			return false;
+		hrtimer_try_to_cancel(&pdev->sched.linger);
+		pdev->sched.linger_modsel = -1;
+		pdev->sched.passed++;
+		pdev->sched.reorders++;
+		pdev->sched.linger_hits++;
+	} else if (!list_empty(&pdev->sched.waiters)) {
+		return false;
+	}
+	pdev->sched.owner = current;
+	return true;
+}
+
+/* sched.lock held; hand a free bus to the next waiter */
+static void ctl_sched_dispatch(CTLDEV *pdev, bool may_linger)
+{
+	struct ctl_sched_waiter *w, *oldest;
+
+	if (pdev->sched.owner || (pdev->sched.linger_modsel >= 0) || list_empty(&pdev->sched.waiters))
+		return;
+
+	oldest = list_first_entry(&pdev->sched.waiters, struct ctl_sched_waiter, list);
+	if ((pdev->sched.passed >= i2c_sched_batch) ||
+		(ktime_get_ns() - oldest->enq_ns >= (u64)i2c_sched_wait_ms * NSEC_PER_MSEC)) {
+		pdev->sched.forced++;
+		goto grant_oldest;
+	}
+
+	list_for_each_entry(w, &pdev->sched.waiters, list) {
+		if (!ctl_sched_switches(pdev, w->chan)) {
+			if (w == oldest) {
+				pdev->sched.passed = 0;
+			} else {
+				pdev->sched.passed++;
+				pdev->sched.reorders++;
+			}
+			ctl_sched_grant(pdev, w);
+			return;
+		}
+	}
+
+	if (may_linger && i2c_sched_linger_us && (pdev->current_modsel >= 0)) {
+		pdev->sched.linger_modsel = pdev->current_modsel;
+		pdev->sched.lingers++;
+		hrtimer_start(&pdev->sched.linger, ns_to_ktime((u64)i2c_sched_linger_us * NSEC_PER_USEC), HRTIMER_MODE_REL);
+		return;
+	}
+
+grant_oldest:
+	pdev->sched.passed = 0;
+	ctl_sched_grant(pdev, oldest);
+}
+
+static enum hrtimer_restart ctl_sched_linger_expire(struct hrtimer *timer)
+{
+	CTLDEV *pdev = container_of(timer, CTLDEV, sched.linger);
+	unsigned long flags;
+
+	spin_lock_irqsave(&pdev->sched.lock, flags);
+	if (pdev->sched.linger_modsel >= 0) {
+		/* nobody came back for this modsel */
+		pdev->sched.linger_modsel = -1;
+		ctl_sched_dispatch(pdev, false);
+	}
+	spin_unlock_irqrestore(&pdev->sched.lock, flags);
+	return HRTIMER_NORESTART;
+}
+
+static void ctl_sched_lock_bus(struct i2c_adapter *adap, unsigned int flags)
+{
+	CTLDEV *pdev = ctl_sched_dev(adap);
+	struct ctl_sched_waiter w = {
+		.task = current,
+		.enq_ns = ktime_get_ns(),
+		.chan = ctl_sched_chan(pdev, adap),
+	};
+	unsigned long irqflags;
+
+	if (i2c_sched) {
+		spin_lock_irqsave(&pdev->sched.lock, irqflags);
+		if (ctl_sched_take(pdev, w.chan))
+			w.granted = true;
+		else
+			list_add_tail(&w.list, &pdev->sched.waiters);
+		spin_unlock_irqrestore(&pdev->sched.lock, irqflags);
+
+		for (;;) {
+			set_current_state(TASK_UNINTERRUPTIBLE);
+			if (smp_load_acquire(&w.granted))
+				break;
+			schedule();
+		}
+		__set_current_state(TASK_RUNNING);
+	}
+
+	pdev->sched.parent_ops->lock_bus(adap, flags);
+	ctl_sched_account(pdev, w.chan, w.enq_ns);
+}
+
+static int ctl_sched_trylock_bus(struct i2c_adapter *adap, unsigned int flags)
+{
+	CTLDEV *pdev = ctl_sched_dev(adap);
+	u32 chan = ctl_sched_chan(pdev, adap);
+	u64 t0 = ktime_get_ns();
+	unsigned long irqflags;
+	bool taken = false;
+
+	if (i2c_sched) {
+		spin_lock_irqsave(&pdev->sched.lock, irqflags);
+		taken = ctl_sched_take(pdev, chan);
+		spin_unlock_irqrestore(&pdev->sched.lock, irqflags);
+		if (!taken)
+			return 0;
+	}
+
+	if (pdev->sched.parent_ops->trylock_bus(adap, flags)) {
+		ctl_sched_account(pdev, chan, t0);
+		return 1;
+	}
+
+	if (taken) {
+		spin_lock_irqsave(&pdev->sched.lock, irqflags);
+		pdev->sched.owner = NULL;
+		ctl_sched_dispatch(pdev, false);
+		spin_unlock_irqrestore(&pdev->sched.lock, irqflags);
+	}
+	return 0;
+}
+
+static void ctl_sched_unlock_bus(struct i2c_adapter *adap, unsigned int flags)
+{
+	CTLDEV *pdev = ctl_sched_dev(adap);
+	unsigned long irqflags;
+
+	pdev->sched.parent_ops->unlock_bus(adap, flags);
+
+	/* not ours if i2c_sched was off when this transfer was locked */
+	if (READ_ONCE(pdev->sched.owner) != current)
+		return;
+	spin_lock_irqsave(&pdev->sched.lock, irqflags);
+	pdev->sched.owner = NULL;
+	ctl_sched_dispatch(pdev, true);
+	spin_unlock_irqrestore(&pdev->sched.lock, irqflags);
+}
+
+static const struct i2c_lock_operations ctl_sched_lock_ops = {
+	.lock_bus =    ctl_sched_lock_bus,
+	.trylock_bus = ctl_sched_trylock_bus,
+	.unlock_bus =  ctl_sched_unlock_bus,
+};
+
 int ctl_i2c_probe(CTLDEV *pdev)
 {
 	int rc;
@@ -541,6 +768,11 @@ int ctl_i2c_probe(CTLDEV *pdev)
 		}
 
 		pdev->current_modsel = -1;
+		spin_lock_init(&pdev->sched.lock);
+		INIT_LIST_HEAD(&pdev->sched.waiters);
+		hrtimer_init(&pdev->sched.linger, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+		pdev->sched.linger.function = ctl_sched_linger_expire;
+		pdev->sched.linger_modsel = -1;
 		pdev->ctlmuxcore = i2c_mux_alloc(&pdev->adapter, &pdev->pcidev->dev, nchans, sizeof(struct ctlmux), 0,
 										 ctl_select_chan, ctl_deselect_mux);
 		if (!pdev->ctlmuxcore)
@@ -560,6 +792,15 @@ int ctl_i2c_probe(CTLDEV *pdev)
 				break;
 			}
 		}
+
+		/* put the scheduler in front of the i2c-mux parent locking; not validated
+		   on hardware yet, so the channels keep stock i2c-mux locking unless the
+		   module is loaded with i2c_sched=1 */
+		if (!rc && i2c_sched) {
+			pdev->sched.parent_ops = pdev->ctlmuxcore->adapter[0]->lock_ops;
+			for (i = 0; i < nchans; i++)
+				pdev->ctlmuxcore->adapter[i]->lock_ops = &ctl_sched_lock_ops;
+		}
 	}
 
 	return rc;
@@ -568,5 +809,6 @@ int ctl_i2c_probe(CTLDEV *pdev)
 void ctl_i2c_remove(CTLDEV *pdev)
 {
 	i2c_mux_del_adapters(pdev->ctlmuxcore);
+	hrtimer_cancel(&pdev->sched.linger);
 	i2c_del_adapter(&pdev->adapter);
 }
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ *  Nokia cpctl/ioctl i2c bus adapter/multiplexer
+ *
+ *  Copyright (C) 2024 Nokia
+ *
+ */
+
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/version.h>
+#include <linux/miscdevice.h>
+#include "cpuctl.h"
+
+static const u32 ctl_mmap_windows[CTL_MMAP_NUM_WIN] = {
+	CTL_MMAP_WIN_CNTR,
+	CTL_MMAP_WIN_PORT,
+	CTL_MMAP_WIN_MISCIO,
+};
+
+static int ctl_regs_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	CTLDEV *pdev = container_of(file->private_data, CTLDEV, regs.misc);
+	unsigned long npages = vma_pages(vma);
+	unsigned long i;
+	int rc;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	if (vma->vm_pgoff >= CTL_MMAP_NUM_WIN || npages > CTL_MMAP_NUM_WIN - vma->vm_pgoff)
+		return -EINVAL;
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6,3,0)
+	vma->vm_flags |= VM_IO | VM_DONTEXPAND | VM_DONTDUMP;
+	vma->vm_flags &= ~VM_MAYWRITE;
+#else
+	vm_flags_set(vma, VM_IO | VM_DONTEXPAND | VM_DONTDUMP);
+	vm_flags_clear(vma, VM_MAYWRITE);
+#endif
+	vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+	/* the windows are not adjacent in the BAR, so map them page by page */
+	for (i = 0; i < npages; i++)
+	{
+		u32 offset = ctl_mmap_windows[vma->vm_pgoff + i];
+		phys_addr_t phys = pci_resource_start(pdev->pcidev, 0) + offset;
+
+		if (offset + PAGE_SIZE > pci_resource_len(pdev->pcidev, 0))
+			return -EINVAL;
+		rc = io_remap_pfn_range(vma, vma->vm_start + i * PAGE_SIZE, phys >> PAGE_SHIFT,
+								PAGE_SIZE, vma->vm_page_prot);
+		if (rc)
+			return rc;
+	}
+	return 0;
+}
+
+static const struct file_operations ctl_regs_fops = {
+	.owner = THIS_MODULE,
+	.mmap = ctl_regs_mmap,
+};
+
+int ctl_mmap_init(CTLDEV *pdev)
+{
+	int rc;
+
+	snprintf(pdev->regs.name, sizeof(pdev->regs.name), "%s_regs", pdev->ctlv->name);
+	pdev->regs.misc.minor = MISC_DYNAMIC_MINOR;
+	pdev->regs.misc.name = pdev->regs.name;
+	pdev->regs.misc.fops = &ctl_regs_fops;
+	/* raw register pages, root only like the rest of the FPGA access */
+	pdev->regs.misc.mode = 0400;
+	pdev->regs.misc.parent = &pdev->pcidev->dev;
+
+	rc = misc_register(&pdev->regs.misc);
+	if (rc)
+	{
+		dev_err(&pdev->pcidev->dev, "misc_register %s failed %d\n", pdev->regs.name, rc);
+		pdev->regs.misc.name = NULL;
+	}
+	return rc;
+}
+
+void ctl_mmap_remove(CTLDEV *pdev)
+{
+	if (pdev->regs.misc.name)
+		misc_deregister(&pdev->regs.misc);
+}
@@ -34,6 +34,26 @@ MODULE_PARM_DESC(debug,
 	"  0x0001 i2c\n"
 	"  0x0002 spi\n"
 );
+uint i2c_sched = 0;
+module_param_named(i2c_sched, i2c_sched, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(i2c_sched,
+	" group mux channel transfers by modsel, 0=off (fifo, default), 1=on; only a load with 1 installs the scheduler\n"
+);
+uint i2c_sched_batch = 8;
+module_param_named(i2c_sched_batch, i2c_sched_batch, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(i2c_sched_batch,
+	" max transfers granted ahead of the oldest waiter, default 8\n"
+);
+uint i2c_sched_wait_ms = 100;
+module_param_named(i2c_sched_wait_ms, i2c_sched_wait_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(i2c_sched_wait_ms,
+	" a waiter older than this is served next regardless of modsel, default 100\n"
+);
+uint i2c_sched_linger_us = 200;
+module_param_named(i2c_sched_linger_us, i2c_sched_linger_us, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(i2c_sched_linger_us,
+	" hold the current modsel this long for a follow-up transfer before switching, 0=off, default 200\n"
+);
 
 static CTLDEV *ctl_dev_alloc(void)
 {
@@ -235,6 +255,7 @@ static int ctl_probe(struct pci_dev *pcidev, const struct pci_device_id *id)
 	kobject_set_name(&pcidev->dev.kobj, ctlv->name); */
 
 	ctl_sysfs_init(pdev);
+	ctl_mmap_init(pdev);
 
 	dev_dbg(&pcidev->dev, "probe done\n");
 
@@ -249,6 +270,7 @@ static void ctl_remove(struct pci_dev *pcidev)
 	if (!pdev)
 		return;
 
+	ctl_mmap_remove(pdev);
 	ctl_sysfs_remove(pdev);
 	ctl_i2c_remove(pdev);
 
@@ -33,8 +33,10 @@ On IOM side:
 - PCON1 is mapped to SPI Ctrl 0 bus 2     timer=6  /dev/spidev1.4
 */
 #include <linux/device.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/iopoll.h>
+#include <linux/seq_file.h>
 #include <linux/spi/spi.h>
 #include <asm/uaccess.h>
 #include <linux/unaligned.h>
@@ -81,22 +83,41 @@ int bus1_channums[brd_max][N_SPI_MINORS] = {
     {0, 1, 2, S_SPI_CHANNEL_INVALID}
 };
 
-static int ctl_spi_check_status(CTLDEV *pdev)
+#define SPI_CLK_NS 8   /* 125MHz controller clock */
+#define SPI_STATUS_BUSY ((1 << S_SPI_BUSY) >> 16)
+#define SPI_STATUS_ERROR ((1 << S_SPI_ERROR) >> 16)
+
+/* nominal time for the controller to shift len bytes at a given timer */
+static inline unsigned ctl_spi_xfer_ns(unsigned len, unsigned timer)
+{
+    return len * 8 * (2 + (2 * timer)) * SPI_CLK_NS;
+}
+
+static int ctl_spi_check_status(CTLDEV *pdev, u64 issued, unsigned xfer_ns)
 {
     u16 val;
+    u64 elapsed;
     int rc;
 
-    rc = read_poll_timeout_atomic(ctl_reg16_read, val,
-            ((val & ((1 << S_SPI_BUSY) >> 16)) == 0),
-            5, 100 * USEC_PER_MSEC, 1, pdev, A32_SPI_CTRL_SR);
+    /*
+     * BUSY is not known to be latched as soon as the control write lands, so
+     * sit out the nominal shift time of the word before trusting it.
+     */
+    elapsed = ktime_get_ns() - issued;
+    if (elapsed < xfer_ns)
+        ndelay(xfer_ns - elapsed);
 
+    rc = read_poll_timeout_atomic(ctl_reg16_read, val,
+            ((val & SPI_STATUS_BUSY) == 0),
+            1, 100 * USEC_PER_MSEC, 0, pdev, A32_SPI_CTRL_SR);
     if (rc)
     {
         dev_err(&pdev->pcidev->dev, "spi timeout 0x%04x\n", val);
         return -ETIMEDOUT;
     }
+    pdev->spi.stats.words++;
 
-    if (val & ((1 << S_SPI_ERROR) >> 16))
+    if (val & SPI_STATUS_ERROR)
     {
         dev_err(&pdev->pcidev->dev, "spi controller error 0x%04x\n", val);
         return -EIO;
@@ -105,77 +126,22 @@ static int ctl_spi_check_status(CTLDEV *pdev)
     return 0;
 }
 
-static int __spi_read(CTLDEV *pdev, u8 *data, unsigned len, int endop, unsigned channel, unsigned timer)
+static u32 ctl_spi_ctrl(unsigned channel, unsigned timer, int endop)
 {
-    int status;
     u32 val;
-    int rlen = len;
-
-    if (len > 4)
-    {
-        rlen = 4;
-    }
 
     val = (channel << S_SPI_CHANNEL);
     val |= SPI_DEFAULT_SPEED << S_SPI_SPEED;
     val |= (timer << S_SPI_TIMER);
     val |= (endop << S_SPI_END);
-    if (rlen > 0)
-    {
-        val |= (1 << S_SPI_READ) | ((rlen - 1) << S_SPI_RD_BYTES);
-    }
-    ctl_reg_write(pdev, A32_SPI_CTRL_SR, val);
-    if (debug & CTL_DEBUG_SPI)
-        dev_dbg(&pdev->pcidev->dev, "%s cntr 0x%08x rlen %d\n", __FUNCTION__, val, rlen);
-    udelay(10);
-
-    status = ctl_spi_check_status(pdev);
-    if (status < 0)
-    {
-        return status;
-    }
-
-    val = ctl_reg_read(pdev, A32_SPI_DATA_SR);
-    if (debug & CTL_DEBUG_SPI)
-        dev_dbg(&pdev->pcidev->dev, "%s data 0x%08x \n", __FUNCTION__, val);
-    switch (rlen)
-    {
-    case 1:
-        data[0] = (u8)val;
-        break;
-    case 2:
-        data[0] = (u8)(val >> 8);
-        data[1] = (u8)(val);
-        break;
-    case 3:
-        put_unaligned_be24(val, data);
-        break;
-    case 4:
-        put_unaligned_be32(val, data);
-        break;
-    default:
-        break;
-    }
 
-    return rlen; /* bytes read */
+    return val;
 }
 
-static int __spi_write(CTLDEV *pdev, const u8 *buf, unsigned len, int endop, unsigned channel, unsigned timer)
+static u32 ctl_spi_pack(const u8 *buf, unsigned wlen)
 {
-    int rc;
-    u32 val;
     u32 data = 0;
     u32 shift = 24;
-    u32 wlen = len;
-    u32 xlen = 0;
-
-    if (len && len > 4)
-        wlen = 4;
-
-    xlen += wlen;
-
-    if (endop)
-        endop = (1 << S_SPI_END);
 
     switch (wlen)
     {
@@ -201,36 +167,115 @@ static int __spi_write(CTLDEV *pdev, const u8 *buf, unsigned len, int endop, uns
         break;
     }
 
-    ctl_reg_write(pdev, A32_SPI_DATA_SR, data);
-    if (debug & CTL_DEBUG_SPI)
-        dev_dbg(&pdev->pcidev->dev, "%s data 0x%08x \n", __FUNCTION__, data);
+    return data;
+}
 
-    val = (channel << S_SPI_CHANNEL);
-    val |= SPI_DEFAULT_SPEED << S_SPI_SPEED;
-    val |= (timer << S_SPI_TIMER);
-    val |= ((xlen - 1) << S_SPI_WR_BYTES) | (1 << S_SPI_WRITE) | endop;
+static int __spi_read(CTLDEV *pdev, u8 *data, unsigned len, int cs_change, unsigned channel, unsigned timer)
+{
+    int status;
+    u32 val;
+    unsigned rlen;
+    u64 issued;
+
+    while (len)
+    {
+        rlen = min(len, 4u);
 
-    ctl_reg_write(pdev, A32_SPI_CTRL_SR, val);
-    udelay(10);
-    if (debug & CTL_DEBUG_SPI)
-        dev_dbg(&pdev->pcidev->dev, "%s cntr 0x%08x \n", __FUNCTION__, val);
+        val = ctl_spi_ctrl(channel, timer, cs_change && len <= 4);
+        val |= (1 << S_SPI_READ) | ((rlen - 1) << S_SPI_RD_BYTES);
+        ctl_reg_write(pdev, A32_SPI_CTRL_SR, val);
+        issued = ktime_get_ns();
+        if (debug & CTL_DEBUG_SPI)
+            dev_dbg(&pdev->pcidev->dev, "%s cntr 0x%08x rlen %d\n", __FUNCTION__, val, rlen);
 
-    rc = ctl_spi_check_status(pdev);
-    if (rc == 0)
-        rc = wlen;  /* bytes written */
+        status = ctl_spi_check_status(pdev, issued, ctl_spi_xfer_ns(rlen, timer));
+        if (status < 0)
+        {
+            return status;
+        }
 
-    return rc;
+        val = ctl_reg_read(pdev, A32_SPI_DATA_SR);
+        if (debug & CTL_DEBUG_SPI)
+            dev_dbg(&pdev->pcidev->dev, "%s data 0x%08x \n", __FUNCTION__, val);
+        switch (rlen)
+        {
+        case 1:
+            data[0] = (u8)val;
+            break;
+        case 2:
+            data[0] = (u8)(val >> 8);
+            data[1] = (u8)(val);
+            break;
+        case 3:
+            put_unaligned_be24(val, data);
+            break;
+        case 4:
+            put_unaligned_be32(val, data);
+            break;
+        default:
+            break;
+        }
+
+        data += rlen;
+        len -= rlen;
+    }
+
+    return 0;
+}
+
+/*
+ * A32_SPI_DATA_SR is not known to be double-buffered, so the next data word
+ * is only written once the controller has finished shifting the current one.
+ */
+static int __spi_write(CTLDEV *pdev, const u8 *buf, unsigned len, int cs_change, unsigned channel, unsigned timer)
+{
+    int rc;
+    u32 val;
+    u32 data;
+    unsigned wlen, next;
+    u64 issued;
+
+    wlen = min(len, 4u);
+    data = ctl_spi_pack(buf, wlen);
+    ctl_reg_write(pdev, A32_SPI_DATA_SR, data);
+
+    while (len)
+    {
+        if (debug & CTL_DEBUG_SPI)
+            dev_dbg(&pdev->pcidev->dev, "%s data 0x%08x \n", __FUNCTION__, data);
+
+        val = ctl_spi_ctrl(channel, timer, cs_change && len <= 4);
+        val |= ((wlen - 1) << S_SPI_WR_BYTES) | (1 << S_SPI_WRITE);
+        ctl_reg_write(pdev, A32_SPI_CTRL_SR, val);
+        issued = ktime_get_ns();
+        if (debug & CTL_DEBUG_SPI)
+            dev_dbg(&pdev->pcidev->dev, "%s cntr 0x%08x \n", __FUNCTION__, val);
+
+        buf += wlen;
+        len -= wlen;
+        rc = ctl_spi_check_status(pdev, issued, ctl_spi_xfer_ns(wlen, timer));
+        if (rc < 0)
+            return rc;
+
+        next = min(len, 4u);
+        if (next)
+        {
+            data = ctl_spi_pack(buf, next);
+            ctl_reg_write(pdev, A32_SPI_DATA_SR, data);
+        }
+        wlen = next;
+    }
+
+    return 0;
 }
 
 static int ctlspi_spi_controller_transfer(struct spi_controller *spicon, struct spi_message *message)
 {
     CTLDEV *pdev = spi_controller_get_devdata(spicon);
-    int rc;
+    int rc = 0;
     struct spi_transfer *xfer = NULL;
-    u32 wrbytes = 0, rdbytes = 0;
     u32 txlen = 0, rxlen = 0;
-    u64 start;
-    unsigned dur;
+    u64 start, dur;
     int bus = spicon->bus_num;
     unsigned timer = SPI_TIMER_DEFAULT;
     unsigned channel = message->spi->chip_select[0];
@@ -243,85 +288,109 @@ static int ctlspi_spi_controller_transfer(struct spi_controller *spicon, struct
     start = ktime_get_ns();
     list_for_each_entry(xfer, &message->transfers, transfer_list)
     {
-
         if (xfer->tx_buf)
         {
-            int endop = 0;
-            u8 *buf = (u8 *)xfer->tx_buf;
-            wrbytes += xfer->len;
             txlen += xfer->len;
 
             dev_dbg(&pdev->pcidev->dev, "spidev%d.%d tx len %d\n", bus,
                 channel, xfer->len);
-        
-            while (wrbytes)
-            {
-                if (xfer->cs_change && wrbytes <= 4)
-                {
-                    endop = 1;
-                }
-                rc = __spi_write(pdev, buf, wrbytes, endop, channel, timer);
-                if (rc < 0)
-                {
-                    message->status = rc;
-                    return rc;
-                }
-                wrbytes -= rc;
-                buf += rc;
-            }
+
+            rc = __spi_write(pdev, xfer->tx_buf, xfer->len, xfer->cs_change, channel, timer);
+            if (rc < 0)
+                goto out;
         }
     }
 
     list_for_each_entry(xfer, &message->transfers, transfer_list)
     {
-
         if (xfer->rx_buf)
         {
-            int endop = 0;
-            u8 *buf = (u8 *)xfer->rx_buf;
-            rdbytes = xfer->len;
             rxlen += xfer->len;
 
             dev_dbg(&pdev->pcidev->dev, "spidev%d.%d rx len %d\n", bus,
                 channel, xfer->len);
 
-            while (rdbytes > 0)
-            {
-                /* read */
-                if (xfer->cs_change && rdbytes <= 4)
-                {
-                    endop = 1;
-                }
-                rc = __spi_read(pdev, buf, rdbytes, endop, channel, timer);
-                if (rc < 0)
-                    break;
-                rdbytes -= rc;
-                buf += rc;
-            }
+            rc = __spi_read(pdev, xfer->rx_buf, xfer->len, xfer->cs_change, channel, timer);
             if (rc < 0)
-            {
-                message->status = rc;
-                return rc;
-            }
+                goto out;
         }
-
     }
 
-    dur = (ktime_get_ns() - start) / 1000;
-    dev_dbg(&pdev->pcidev->dev, "spidev%d.%d time %dus\n", bus,
-        channel, dur);
-
-    if (rc >= 0)
+out:
+    dur = ktime_get_ns() - start;
+    dev_dbg(&pdev->pcidev->dev, "spidev%d.%d time %lluus\n", bus,
+        channel, dur / 1000);
+
+    /* only updated from the message pump; a reset from debugfs may race, that's fine */
+    pdev->spi.stats.msgs++;
+    pdev->spi.stats.bytes += txlen + rxlen;
+    pdev->spi.stats.ns += dur;
+    pdev->spi.stats.last_bytes = txlen + rxlen;
+    pdev->spi.stats.last_ns = dur;
+    if (dur > pdev->spi.stats.max_ns)
+        pdev->spi.stats.max_ns = dur;
+
+    if (rc < 0)
     {
-        message->status = rc = 0;
+        pdev->spi.stats.errors++;
+        message->status = rc;
+        return rc;
     }
 
+    message->status = 0;
     message->actual_length = txlen + rxlen;
     spi_finalize_current_message(spicon);
 
-    return rc;
+    return 0;
+}
+
+static u64 ctl_spi_rate(u64 bytes, u64 ns)
+{
+    return ns ? div64_u64(bytes * NSEC_PER_SEC, ns) : 0;
+}
+
+static int ctl_spi_stats_show(struct seq_file *m, void *v)
+{
+    CTLDEV *pdev = m->private;
+    struct _spi_stats *st = &pdev->spi.stats;
+
+    seq_printf(m, "messages:     %llu\n", st->msgs);
+    seq_printf(m, "bytes:        %llu\n", st->bytes);
+    seq_printf(m, "time_us:      %llu\n", div64_u64(st->ns, NSEC_PER_USEC));
+    seq_printf(m, "bytes_per_s:  %llu\n", ctl_spi_rate(st->bytes, st->ns));
+    seq_printf(m, "last:         %llu bytes %lluus %llu bytes/s\n", st->last_bytes,
+        div64_u64(st->last_ns, NSEC_PER_USEC), ctl_spi_rate(st->last_bytes, st->last_ns));
+    seq_printf(m, "max_us:       %llu\n", div64_u64(st->max_ns, NSEC_PER_USEC));
+    seq_printf(m, "words:        %llu\n", st->words);
+    seq_printf(m, "errors:       %llu\n", st->errors);
+
+    return 0;
 }
 
+static int ctl_spi_stats_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, ctl_spi_stats_show, inode->i_private);
+}
+
+/* any write clears the counters */
+static ssize_t ctl_spi_stats_write(struct file *file, const char __user *ubuf, size_t count, loff_t *ppos)
+{
+    CTLDEV *pdev = ((struct seq_file *)file->private_data)->private;
+
+    memset(&pdev->spi.stats, 0, sizeof(pdev->spi.stats));
+
+    return count;
+}
+
+static const struct file_operations ctl_spi_stats_fops = {
+    .owner = THIS_MODULE,
+    .open = ctl_spi_stats_open,
+    .read = seq_read,
+    .write = ctl_spi_stats_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
 static int ctlspi_spi_controller_setup(struct spi_device *spi)
 {
     return 0;
@@ -338,6 +407,7 @@ int spi_device_create(CTLDEV *pdev)
     struct spi_controller *spicon;
     int rc = 0, i;
     int bus_num = pdev->ctlv->spi_bus;
+    char name[32];
 
     spicon = devm_spi_alloc_master(dev, sizeof(CTLDEV));
     if (!spicon)
@@ -368,6 +438,10 @@ int spi_device_create(CTLDEV *pdev)
 
     spi_controller_set_devdata(spicon, pdev);
 
+    snprintf(name, sizeof(name), MODULE_NAME "-spi%d", bus_num);
+    pdev->spi.debugfs = debugfs_create_dir(name, NULL);
+    debugfs_create_file("stats", 0644, pdev->spi.debugfs, pdev, &ctl_spi_stats_fops);
+
     if (bus_num == 0) {
         for (i = 0; i < N_SPI_MINORS; i++)
         {
@@ -402,5 +476,6 @@ int spi_device_create(CTLDEV *pdev)
 
 void spi_device_remove(CTLDEV *pdev)
 {
-
+    debugfs_remove_recursive(pdev->spi.debugfs);
+    pdev->spi.debugfs = NULL;
 }
@@ -129,6 +129,45 @@ static ssize_t chan_stats_show(struct device *dev, struct device_attribute *deva
 	return (p - buf);
 }
 
+static ssize_t chan_sched_show(struct device *dev, struct device_attribute *devattr, char *buf)
+{
+	CTLDEV *pdev = dev_get_drvdata(dev);
+	int i;
+	char* p = buf;
+	p += sprintf(p, "chan\tswitch\tgrants\tavg_us\tmax_us\n");
+	for(i=0;i<pdev->ctlv->nchans;i++) {
+		struct _chan_stats *cs = &pdev->chan_stats[i];
+		p += sprintf(p, "chan%02d\t%u\t%u\t%llu\t%llu\n", i,
+			cs->switches,
+			cs->grants,
+			cs->grants ? div_u64(cs->wait_ns, cs->grants * 1000ULL) : 0,
+			div_u64(cs->max_wait_ns, 1000)
+		);
+	}
+	p += sprintf(p, "reorders %llu lingers %llu linger_hits %llu forced %llu\n",
+		pdev->sched.reorders, pdev->sched.lingers, pdev->sched.linger_hits, pdev->sched.forced);
+	p += sprintf(p, "scheduler %s\n", pdev->sched.parent_ops ? "installed" : "not installed");
+	return (p - buf);
+}
+
+/* any write clears the switch and wait counters */
+static ssize_t chan_sched_store(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count)
+{
+	CTLDEV *pdev = dev_get_drvdata(dev);
+	int i;
+	for(i=0;i<pdev->ctlv->nchans;i++) {
+		pdev->chan_stats[i].switches = 0;
+		pdev->chan_stats[i].grants = 0;
+		pdev->chan_stats[i].wait_ns = 0;
+		pdev->chan_stats[i].max_wait_ns = 0;
+	}
+	pdev->sched.reorders = 0;
+	pdev->sched.lingers = 0;
+	pdev->sched.linger_hits = 0;
+	pdev->sched.forced = 0;
+	return count;
+}
+
 static ssize_t bus_speed_show(struct device *dev, struct device_attribute *devattr, char *buf)
 {
 	CTLDEV *pdev = dev_get_drvdata(dev);
@@ -435,6 +474,7 @@ static DEVICE_ATTR_RW(jer_reset_seq);
 static DEVICE_ATTR_RW(bus_speed);
 static DEVICE_ATTR_RO(jer_avs);
 static DEVICE_ATTR_RO(chan_stats);
+static DEVICE_ATTR_RW(chan_sched);
 
 static SENSOR_DEVICE_ATTR(fandraw_1_prs, S_IRUGO, fandraw_prs_show, NULL, 0);
 static SENSOR_DEVICE_ATTR(fandraw_2_prs, S_IRUGO, fandraw_prs_show, NULL, 1);
@@ -621,6 +661,7 @@ static struct attribute *io_vermilion_ctl_attrs[] = {
 	&dev_attr_port_prs_reg2.attr,
 	&dev_attr_code_ver.attr,
 	&dev_attr_chan_stats.attr,
+	&dev_attr_chan_sched.attr,
 
 	&sensor_dev_attr_port_1_prs.dev_attr.attr,
 	&sensor_dev_attr_port_2_prs.dev_attr.attr,
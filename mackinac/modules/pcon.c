@@ -16,6 +16,9 @@
 #include <linux/of_device.h>
 #include <linux/delay.h>
 #include <linux/slab.h>
+#include <linux/hrtimer.h>
+#include <linux/kthread.h>
+#include <linux/kfifo.h>
 
 #include "pcon.h"
 
@@ -23,6 +26,19 @@
 
 enum chips { pcon, pconm };
 
+struct pcon_sampler {
+	struct hrtimer		timer;
+	struct task_struct	*thread;
+	struct mutex		lock;
+	DECLARE_KFIFO_PTR(fifo, struct pcon_sample);
+	ktime_t				period;
+	ktime_t				start;
+	atomic_t			pending;
+	u32					dropped;
+	int					channel;
+	unsigned int		rate;
+};
+
 struct pcon_data {
 	struct i2c_client	*client;
 	const struct attribute_group **groups;
@@ -32,6 +48,8 @@ struct pcon_data {
 	u16                 revision;
 	int					num_channels;
 	char				valid;
+	struct pcon_snapshot	snapshot;
+	struct pcon_sampler	sampler;
 };
 
 static ssize_t version_show(struct device *dev, struct device_attribute *devattr,
@@ -349,6 +367,304 @@ release_lock:
 	}
 }
 
+static int __pcon_read_reg(struct i2c_client *client, u8 reg, u16 *value)
+{
+	s32 reg_data = i2c_smbus_read_word_data(client, reg);
+
+	if (reg_data < 0)
+		return reg_data;
+	*value = reg_data;
+	return 0;
+}
+
+static int __pcon_snapshot_update(struct device *dev, struct pcon_data *data)
+{
+	struct i2c_client *client = data->client;
+	struct pcon_snapshot *snap = &data->snapshot;
+	struct pcon_channel_snapshot *chan;
+	int channel;
+	int ret;
+
+	ret = __pcon_read_reg(client, PCON_VERSION_ID_REG, &snap->version_id);
+	ret = ret ? : __pcon_read_reg(client, PCON_IMBV_VOLT_VALUE_REG, &snap->imbv_volt_value);
+	ret = ret ? : __pcon_read_reg(client, PCON_IMBV_ERROR_REG, &snap->imbv_error);
+	if (ret < 0)
+		return ret;
+	snap->num_channels = data->num_channels;
+
+	for (channel = 0; channel < data->num_channels; channel++) {
+		chan = &snap->channels[channel];
+		ret = __channel_select_store(dev, channel);
+		ret = ret ? : __pcon_read_reg(client, PCON_VOLT_SET_REG, &chan->volt_set);
+		ret = ret ? : __pcon_read_reg(client, PCON_UNDER_VOLT_SET_REG, &chan->under_volt_set);
+		ret = ret ? : __pcon_read_reg(client, PCON_OVER_VOLT_SET_REG, &chan->over_volt_set);
+		ret = ret ? : __pcon_read_reg(client, PCON_MEASURED_VOLT_REG, &chan->measured_volt);
+		ret = ret ? : __pcon_read_reg(client, PCON_MEASURED_CURRENT_REG, &chan->measured_current);
+		ret = ret ? : __pcon_read_reg(client, PCON_CURRENT_MULTIPLIER_REG, &chan->current_multiplier);
+		ret = ret ? : __pcon_read_reg(client, PCON_MAX_CURRENT_REG, &chan->max_current);
+		ret = ret ? : __pcon_read_reg(client, PCON_MISC_REG, &chan->misc);
+		if (ret < 0)
+			return ret;
+	}
+	return 0;
+}
+
+/*
+ * One read of the snapshot attribute returns every channel's setpoints,
+ * measurements and misc register, sampled in a single sweep under the
+ * channel select lock. The sweep is taken on a read at offset 0; reads
+ * at later offsets return the rest of that same sweep.
+ */
+static ssize_t snapshot_read(struct file *filp, struct kobject *kobj,
+	struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+	struct device *dev = kobj_to_dev(kobj);
+	struct pcon_data *data = dev_get_drvdata(dev);
+	size_t size = offsetof(struct pcon_snapshot, channels) +
+		data->num_channels * sizeof(struct pcon_channel_snapshot);
+	int ret = 0;
+
+	if (off >= size)
+		return 0;
+	if (count > size - off)
+		count = size - off;
+
+	mutex_lock(&data->lock);
+	if (off == 0)
+		ret = __pcon_snapshot_update(dev, data);
+	if (ret == 0)
+		memcpy(buf, (u8 *)&data->snapshot + off, count);
+	mutex_unlock(&data->lock);
+
+	if (ret < 0) {
+		dev_err(dev, "error reading snapshot over i2c");
+		return -EBUSY;
+	}
+	return count;
+}
+
+static enum hrtimer_restart pcon_sampler_tick(struct hrtimer *timer)
+{
+	struct pcon_sampler *sampler = container_of(timer, struct pcon_sampler, timer);
+
+	atomic_inc(&sampler->pending);
+	wake_up_process(sampler->thread);
+	hrtimer_forward_now(timer, sampler->period);
+	return HRTIMER_RESTART;
+}
+
+static int pcon_sampler_thread(void *arg)
+{
+	struct pcon_data *data = arg;
+	struct pcon_sampler *sampler = &data->sampler;
+	struct device *dev = &data->client->dev;
+	struct pcon_sample sample;
+	int ticks;
+	int ret;
+
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (kthread_should_stop())
+			break;
+		ticks = atomic_xchg(&sampler->pending, 0);
+		if (!ticks) {
+			schedule();
+			continue;
+		}
+		__set_current_state(TASK_RUNNING);
+		sampler->dropped += ticks - 1;
+
+		mutex_lock(&data->lock);
+		ret = __channel_select_store(dev, sampler->channel);
+		ret = ret ? : __pcon_read_reg(data->client, PCON_MEASURED_VOLT_REG, &sample.measured_volt);
+		ret = ret ? : __pcon_read_reg(data->client, PCON_MEASURED_CURRENT_REG, &sample.measured_current);
+		mutex_unlock(&data->lock);
+		if (ret < 0) {
+			sampler->dropped++;
+			continue;
+		}
+
+		sample.timestamp_us = ktime_us_delta(ktime_get(), sampler->start);
+		if (!kfifo_put(&sampler->fifo, sample))
+			sampler->dropped++;
+	}
+	__set_current_state(TASK_RUNNING);
+	return 0;
+}
+
+static int __pcon_sampler_start(struct pcon_data *data)
+{
+	struct pcon_sampler *sampler = &data->sampler;
+
+	if (sampler->thread)
+		return -EBUSY;
+
+	kfifo_reset(&sampler->fifo);
+	atomic_set(&sampler->pending, 0);
+	sampler->dropped = 0;
+	sampler->period = ns_to_ktime(NSEC_PER_SEC / sampler->rate);
+	sampler->start = ktime_get();
+	sampler->thread = kthread_run(pcon_sampler_thread, data, "pcon-%s", dev_name(&data->client->dev));
+	if (IS_ERR(sampler->thread)) {
+		int ret = PTR_ERR(sampler->thread);
+		sampler->thread = NULL;
+		return ret;
+	}
+	sched_set_fifo_low(sampler->thread);
+	hrtimer_start(&sampler->timer, sampler->period, HRTIMER_MODE_REL);
+	return 0;
+}
+
+static void __pcon_sampler_stop(struct pcon_data *data)
+{
+	struct pcon_sampler *sampler = &data->sampler;
+
+	if (!sampler->thread)
+		return;
+	hrtimer_cancel(&sampler->timer);
+	kthread_stop(sampler->thread);
+	sampler->thread = NULL;
+}
+
+static void pcon_sampler_release(void *arg)
+{
+	struct pcon_data *data = arg;
+
+	mutex_lock(&data->sampler.lock);
+	__pcon_sampler_stop(data);
+	mutex_unlock(&data->sampler.lock);
+	kfifo_free(&data->sampler.fifo);
+}
+
+static int __pcon_sampler_init(struct device *dev, struct pcon_data *data)
+{
+	struct pcon_sampler *sampler = &data->sampler;
+	int ret;
+
+	mutex_init(&sampler->lock);
+	hrtimer_init(&sampler->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	sampler->timer.function = pcon_sampler_tick;
+	sampler->rate = 1000;
+	sampler->channel = 0;
+
+	ret = kfifo_alloc(&sampler->fifo, PCON_SAMPLE_FIFO_DEPTH, GFP_KERNEL);
+	if (ret < 0)
+		return ret;
+	return devm_add_action_or_reset(dev, pcon_sampler_release, data);
+}
+
+static ssize_t sample_channel_show(struct device *dev, struct device_attribute *devattr,
+	char *buf)
+{
+	struct pcon_data *data = dev_get_drvdata(dev);
+	return sprintf(buf, "%d\n", data->sampler.channel);
+}
+
+static ssize_t sample_channel_store(struct device *dev, struct device_attribute *devattr,
+	const char *buf, size_t count)
+{
+	struct pcon_data *data = dev_get_drvdata(dev);
+	long val;
+	int ret = kstrtol(buf, 10, &val);
+	if (ret < 0)
+		return ret;
+
+	if (val < 0 || val >= data->num_channels)
+		return -EINVAL;
+
+	mutex_lock(&data->sampler.lock);
+	if (data->sampler.thread)
+		ret = -EBUSY;
+	else
+		data->sampler.channel = val;
+	mutex_unlock(&data->sampler.lock);
+	return ret < 0 ? ret : count;
+}
+
+static ssize_t sample_rate_show(struct device *dev, struct device_attribute *devattr,
+	char *buf)
+{
+	struct pcon_data *data = dev_get_drvdata(dev);
+	return sprintf(buf, "%u\n", data->sampler.rate);
+}
+
+static ssize_t sample_rate_store(struct device *dev, struct device_attribute *devattr,
+	const char *buf, size_t count)
+{
+	struct pcon_data *data = dev_get_drvdata(dev);
+	unsigned long val;
+	int ret = kstrtoul(buf, 10, &val);
+	if (ret < 0)
+		return ret;
+
+	if (val == 0 || val > PCON_SAMPLE_RATE_MAX)
+		return -EINVAL;
+
+	mutex_lock(&data->sampler.lock);
+	if (data->sampler.thread)
+		ret = -EBUSY;
+	else
+		data->sampler.rate = val;
+	mutex_unlock(&data->sampler.lock);
+	return ret < 0 ? ret : count;
+}
+
+static ssize_t sample_enable_show(struct device *dev, struct device_attribute *devattr,
+	char *buf)
+{
+	struct pcon_data *data = dev_get_drvdata(dev);
+	return sprintf(buf, "%d\n", data->sampler.thread ? 1 : 0);
+}
+
+static ssize_t sample_enable_store(struct device *dev, struct device_attribute *devattr,
+	const char *buf, size_t count)
+{
+	struct pcon_data *data = dev_get_drvdata(dev);
+	long val;
+	int ret = kstrtol(buf, 10, &val);
+	if (ret < 0)
+		return ret;
+
+	if (val != 0 && val != 1) {
+		dev_err(dev, "sample_enable only supports 0 or 1; got %li", val);
+		return -EINVAL;
+	}
+
+	mutex_lock(&data->sampler.lock);
+	if (val)
+		ret = __pcon_sampler_start(data);
+	else
+		__pcon_sampler_stop(data);
+	mutex_unlock(&data->sampler.lock);
+	return ret < 0 ? ret : count;
+}
+
+static ssize_t sample_dropped_show(struct device *dev, struct device_attribute *devattr,
+	char *buf)
+{
+	struct pcon_data *data = dev_get_drvdata(dev);
+	return sprintf(buf, "%u\n", data->sampler.dropped);
+}
+
+/*
+ * Reads drain whole samples from the sampler fifo regardless of the file
+ * offset, so a reader can keep calling read() until it returns 0.
+ */
+static ssize_t samples_read(struct file *filp, struct kobject *kobj,
+	struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+	struct device *dev = kobj_to_dev(kobj);
+	struct pcon_data *data = dev_get_drvdata(dev);
+	unsigned int copied;
+
+	mutex_lock(&data->sampler.lock);
+	copied = kfifo_out(&data->sampler.fifo, (struct pcon_sample *)buf,
+		count / sizeof(struct pcon_sample));
+	mutex_unlock(&data->sampler.lock);
+
+	return copied * sizeof(struct pcon_sample);
+}
+
 static DEVICE_ATTR_RO(version);
 static DEVICE_ATTR_RO(revision);
 static DEVICE_ATTR_RO(imb_volt);
@@ -358,6 +674,10 @@ static DEVICE_ATTR_RO(imb_ov);
 static DEVICE_ATTR_RW(spi_i2c_select);
 static DEVICE_ATTR_RW(event_cfg_select);
 static DEVICE_ATTR_RO(uptime);
+static DEVICE_ATTR_RW(sample_channel);
+static DEVICE_ATTR_RW(sample_rate);
+static DEVICE_ATTR_RW(sample_enable);
+static DEVICE_ATTR_RO(sample_dropped);
 static SENSOR_DEVICE_ATTR_RW(version_id_reg, global, PCON_VERSION_ID_REG);
 static SENSOR_DEVICE_ATTR_RW(imb_volt_value_reg, global, PCON_IMBV_VOLT_VALUE_REG);
 static SENSOR_DEVICE_ATTR_RW(imbv_error_reg, global, PCON_IMBV_ERROR_REG);
@@ -377,6 +697,10 @@ static struct attribute *pcon_global_attrs[] = {
 	&dev_attr_spi_i2c_select.attr,
 	&dev_attr_event_cfg_select.attr,
 	&dev_attr_uptime.attr,
+	&dev_attr_sample_channel.attr,
+	&dev_attr_sample_rate.attr,
+	&dev_attr_sample_enable.attr,
+	&dev_attr_sample_dropped.attr,
 	&sensor_dev_attr_version_id_reg.dev_attr.attr,
 	&sensor_dev_attr_imb_volt_value_reg.dev_attr.attr,
 	&sensor_dev_attr_imbv_error_reg.dev_attr.attr,
@@ -387,8 +711,18 @@ static struct attribute *pcon_global_attrs[] = {
 	NULL
 };
 
+static BIN_ATTR_RO(snapshot, sizeof(struct pcon_snapshot));
+static BIN_ATTR_RO(samples, 0);
+
+static struct bin_attribute *pcon_global_bin_attrs[] = {
+	&bin_attr_snapshot,
+	&bin_attr_samples,
+	NULL
+};
+
 static const struct attribute_group pcon_global_group = {
 	.attrs = pcon_global_attrs,
+	.bin_attrs = pcon_global_bin_attrs,
 };
 
 static SENSOR_DEVICE_ATTR_2_RW(volt_set_inv_reg, channel, PCON_VOLT_SET_INV_REG, 0);
@@ -565,6 +899,9 @@ static int pcon_probe(struct i2c_client *client)
 	ret = __pcon_data_init(dev, data);
 	if (ret < 0) return ret;
 
+	ret = __pcon_sampler_init(dev, data);
+	if (ret < 0) return ret;
+
 	ret = __pcon_create_attribute_groups(dev, data);
 	if (ret < 0) return ret;
 
@@ -82,3 +82,31 @@
 
 #define PCON_MAX_CHANNELS_PER_DEV           42
 #define PCONM_MAX_CHANNELS_PER_DEV          16
+
+struct pcon_channel_snapshot {
+	u16 volt_set;
+	u16 under_volt_set;
+	u16 over_volt_set;
+	u16 measured_volt;
+	u16 measured_current;
+	u16 current_multiplier;
+	u16 max_current;
+	u16 misc;
+} __packed;
+
+struct pcon_snapshot {
+	u16 version_id;
+	u16 imbv_volt_value;
+	u16 imbv_error;
+	u16 num_channels;
+	struct pcon_channel_snapshot channels[PCON_MAX_CHANNELS_PER_DEV];
+} __packed;
+
+#define PCON_SAMPLE_FIFO_DEPTH              4096
+#define PCON_SAMPLE_RATE_MAX                10000
+
+struct pcon_sample {
+	u32 timestamp_us;
+	u16 measured_volt;
+	u16 measured_current;
+} __packed;